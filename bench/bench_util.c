@@ -0,0 +1,93 @@
+/** @file bench_util.c
+ *  Functions shared by the programs measuring the performance.
+ *
+ * @author Cezary Chodun
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "bench_util.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+uint64_t nextRandom(uint64_t *state) {
+    uint64_t x = state[0];
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    state[0] = x;
+    return x;
+}
+
+double nowSeconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+void cityName(char *buf, int x, int y) {
+    sprintf(buf, "C%d_%d", x, y);
+}
+
+/// @private Adds the road from the city(x, y) to the right(down) or to the bottom.
+static void addGridRoad(Map *map, int x, int y, bool down, uint64_t *seed) {
+    char a[32], b[32];
+    cityName(a, x, y);
+    cityName(b, x + down, y + !down);
+    addRoad(map, a, b, 1 + nextRandom(seed) % 1000, 1900 + nextRandom(seed) % 100);
+}
+
+/// @private Adds the roads of the grid in a random order.
+static bool addShuffledRoads(Map *map, int side, uint64_t *seed) {
+    int count = 2 * side * side;
+    int *roads = (int*) malloc(sizeof(int) * count);
+    if (roads == NULL)
+        return false;
+
+    for (int i = 0; i < count; i++)
+        roads[i] = i;
+    for (int i = count - 1; i > 0; i--) {
+        int j = nextRandom(seed) % (i + 1);
+        int tmp = roads[i];
+        roads[i] = roads[j];
+        roads[j] = tmp;
+    }
+
+    for (int i = 0; i < count; i++) {
+        int city = roads[i] / 2, x = city / side, y = city % side;
+        bool down = roads[i] % 2;
+        if ((down && x + 1 == side) || (!down && y + 1 == side))
+            continue;
+
+        addGridRoad(map, x, y, down, seed);
+    }
+
+    free(roads);
+    return true;
+}
+
+Map *buildGridMap(int side, bool shuffled, uint64_t *seed) {
+    Map *map = newMap();
+    if (map == NULL)
+        return NULL;
+
+    if (shuffled) {
+        if (!addShuffledRoads(map, side, seed)) {
+            deleteMap(map);
+            return NULL;
+        }
+        return map;
+    }
+
+    for (int x = 0; x < side; x++)
+        for (int y = 0; y < side; y++) {
+            if (x + 1 < side)
+                addGridRoad(map, x, y, true, seed);
+            if (y + 1 < side)
+                addGridRoad(map, x, y, false, seed);
+        }
+
+    return map;
+}
@@ -0,0 +1,52 @@
+/** @file bench_util.h
+ *  Functions shared by the programs measuring the performance:
+ *  random numbers, time and the grid maps on which they run.
+ *
+ * @author Cezary Chodun
+ */
+
+#ifndef bench_util_h
+#define bench_util_h
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "map.h"
+
+/**
+    @brief
+        Returns the next number of the xorshift generator
+        and updates its state.
+ */
+uint64_t nextRandom(uint64_t *state);
+
+/**
+    @brief
+        Returns the time in seconds, measured from an
+        unspecified moment in the past.
+ */
+double nowSeconds(void);
+
+/**
+    @brief
+        Writes the name of the city at the position(x, y)
+        of the grid to 'buf'(at most 32 characters).
+ */
+void cityName(char *buf, int x, int y);
+
+/**
+    @brief
+        Creates a map of side * side cities, in which every city
+        has the roads to its neighbours in the grid. The roads have
+        random lengths from 1 to 1000 and years from 1900 to 1999.
+        If 'shuffled' is @p true the roads are added in a random
+        order, so the cities and the roads close on the map are
+        far apart in the memory.
+    @param[in,out] seed - state of the random number generator.
+    @return
+        A pointer to the map or NULL if the memory
+        could not be allocated.
+ */
+Map *buildGridMap(int side, bool shuffled, uint64_t *seed);
+
+#endif /* bench_util_h */
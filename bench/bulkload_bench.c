@@ -0,0 +1,85 @@
+/** @file bulkload_bench.c
+ *  Compares the time of adding the roads one by one(@ref addRoad)
+ *  and at once(@ref commitRoadBatch) for growing numbers of roads.
+ *
+ *  Usage: bulkload_bench [roads]
+ *
+ * @author Cezary Chodun
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "bench_util.h"
+#include "map.h"
+
+/// @private Names of the cities of the roads, a road in every two names.
+static char (*makeRoads(int roads))[16] {
+    char (*names)[16] = malloc(sizeof(*names) * 2 * roads);
+    if (names == NULL)
+        return NULL;
+
+    uint64_t seed = 88172645463325252ull;
+    int cities = roads / 4 + 2;
+    for (int i = 0; i < roads; i++) {
+        unsigned a = nextRandom(&seed) % cities, b = nextRandom(&seed) % cities;
+        if (a == b)
+            b = (b + 1) % cities;
+        sprintf(names[2 * i], "C%u", a);
+        sprintf(names[2 * i + 1], "C%u", b);
+    }
+
+    return names;
+}
+
+/**
+ * @brief
+ *  Prints the time of adding the roads one by one and at once,
+ *  for 1/8, 1/4, 1/2 and all of the roads.
+ */
+int main(int argc, char **argv) {
+    int total = (argc > 1 ? atoi(argv[1]) : 800000);
+    if (total < 8) {
+        fprintf(stderr, "Usage: %s [roads(at least 8)]\n", argv[0]);
+        return 1;
+    }
+
+    char (*names)[16] = makeRoads(total);
+    if (names == NULL) {
+        fprintf(stderr, "Failed to allocate memory\n");
+        return 1;
+    }
+
+    printf("roads;added;one by one(ms);at once(ms)\n");
+    for (int roads = total / 8; roads <= total; roads *= 2) {
+        Map *map = newMap();
+        double start = nowSeconds();
+        int added = 0;
+        for (int i = 0; i < roads; i++)
+            added += addRoad(map, names[2 * i], names[2 * i + 1], 1 + i % 100, 2000);
+        double single = nowSeconds() - start;
+        deleteMap(map);
+
+        map = newMap();
+        start = nowSeconds();
+        RoadBatch *batch = beginRoadBatch(map);
+        for (int i = 0; i < roads && batch != NULL; i++)
+            addRoadBatch(batch, names[2 * i], names[2 * i + 1], 1 + i % 100, 2000);
+        int batched = commitRoadBatch(batch);
+        double bulk = nowSeconds() - start;
+        deleteMap(map);
+
+        if (batched != added) {
+            fprintf(stderr, "Different numbers of the roads: %d and %d\n", added, batched);
+            free(names);
+            return 1;
+        }
+        printf("%d;%d;%.1f;%.1f\n", roads, added, single * 1e3, bulk * 1e3);
+    }
+
+    free(names);
+    return 0;
+}
@@ -0,0 +1,184 @@
+/** @file concurrent_bench.c
+ *  Measures the throughput of the route queries executed
+ *  by many threads on a ConcurrentMap(mode "rwlock") or
+ *  a VersionedMap(mode "rcu").
+ *
+ *  Usage: concurrent_bench [max_threads] [seconds] [write_per_mille] [mode]
+ *
+ * @author Cezary Chodun
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "ConcurrentMap.h"
+#include "VersionedMap.h"
+#include "bench_util.h"
+#include "map.h"
+
+/// @private Side of the grid of cities.
+static const int GRID = 40;
+/// @private Number of the routes.
+static const unsigned ROUTES = 999;
+
+/// @private State of a single benchmark thread.
+typedef struct Worker{
+    /// The thread.
+    pthread_t thread;
+    /// The shared map(mode "rwlock").
+    ConcurrentMap *cmap;
+    /// The shared map(mode "rcu").
+    VersionedMap *vmap;
+    /// State of the random number generator.
+    uint64_t seed;
+    /// Number of the modifications per 1000 operations.
+    unsigned writePerMille;
+    /// Duration of the measurement.
+    double seconds;
+    /// Number of the executed queries.
+    uint64_t reads;
+    /// Number of the executed modifications.
+    uint64_t writes;
+}Worker;
+
+/// @private Builds a grid of cities with random roads and the routes.
+static Map *buildMap(void) {
+    uint64_t seed = 12345;
+    Map *map = buildGridMap(GRID, false, &seed);
+    if (map == NULL)
+        return NULL;
+
+    char a[32], b[32];
+    for (unsigned id = 1; id <= ROUTES; id++) {
+        bool created = false;
+        while (!created) {
+            cityName(a, nextRandom(&seed) % GRID, nextRandom(&seed) % GRID);
+            cityName(b, nextRandom(&seed) % GRID, nextRandom(&seed) % GRID);
+            created = newRoute(map, id, a, b);
+        }
+    }
+
+    return map;
+}
+
+/// @private Body of the benchmark thread.
+static void *runWorker(void *arg) {
+    Worker *w = (Worker*) arg;
+    double end = nowSeconds() + w->seconds;
+    char a[32], b[32];
+    int year = 2000;
+
+    while (true) {
+        for (int i = 0; i < 256; i++) {
+            uint64_t r = nextRandom(&w->seed);
+            if (r % 1000 < w->writePerMille) {
+                int x = (r >> 10) % (GRID - 1), y = (r >> 20) % GRID;
+                cityName(a, x, y);
+                cityName(b, x + 1, y);
+                if (w->cmap != NULL)
+                    concurrentRepairRoad(w->cmap, a, b, year++);
+                else {
+                    repairRoad(beginMapUpdate(w->vmap), a, b, year++);
+                    endMapUpdate(w->vmap);
+                }
+                w->writes++;
+            }
+            else {
+                unsigned id = 1 + (r >> 10) % ROUTES;
+                char const *s = (w->cmap != NULL ? concurrentRouteDescription(w->cmap, id)
+                                                 : versionedRouteDescription(w->vmap, id));
+                free((void*) s);
+                w->reads++;
+            }
+        }
+
+        if (nowSeconds() >= end)
+            break;
+    }
+
+    return NULL;
+}
+
+/// @private Runs the benchmark with the given number of threads.
+static double measure(ConcurrentMap *cmap, VersionedMap *vmap, int threads,
+                      double seconds, unsigned writePerMille) {
+    Worker *workers = (Worker*) calloc(threads, sizeof(Worker));
+    if (workers == NULL)
+        return 0;
+
+    double start = nowSeconds();
+    for (int i = 0; i < threads; i++) {
+        workers[i].cmap = cmap;
+        workers[i].vmap = vmap;
+        workers[i].seed = 88172645463325252ull + 7919 * (uint64_t) i;
+        workers[i].writePerMille = writePerMille;
+        workers[i].seconds = seconds;
+        pthread_create(&workers[i].thread, NULL, runWorker, &workers[i]);
+    }
+
+    uint64_t ops = 0;
+    for (int i = 0; i < threads; i++) {
+        pthread_join(workers[i].thread, NULL);
+        ops += workers[i].reads + workers[i].writes;
+    }
+    double time = nowSeconds() - start;
+
+    free(workers);
+    return ops / time;
+}
+
+/**
+ * @brief
+ *  Prints the number of operations per second for 1, 2, 4, ...
+ *  threads up to the given maximum(the number of processors
+ *  by default).
+ */
+int main(int argc, char **argv) {
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    int maxThreads = (argc > 1 ? atoi(argv[1]) : (int) (cores > 0 ? cores : 1));
+    double seconds = (argc > 2 ? atof(argv[2]) : 1.0);
+    unsigned writePerMille = (argc > 3 ? (unsigned) atoi(argv[3]) : 1);
+    bool rcu = (argc > 4 && strcmp(argv[4], "rcu") == 0);
+    if (maxThreads < 1 || seconds <= 0 || (argc > 4 && !rcu && strcmp(argv[4], "rwlock") != 0)) {
+        fprintf(stderr, "Usage: %s [max_threads] [seconds] [write_per_mille] [rwlock|rcu]\n",
+                argv[0]);
+        return 1;
+    }
+
+    ConcurrentMap *cmap = NULL;
+    VersionedMap *vmap = NULL;
+    if (rcu)
+        vmap = newVersionedMap(buildMap());
+    else
+        cmap = newConcurrentMap(buildMap());
+    if (cmap == NULL && vmap == NULL) {
+        fprintf(stderr, "Failed to build the map\n");
+        return 1;
+    }
+
+    printf("threads;ops_per_second;speedup (cores: %ld, writes: %u/1000, mode: %s)\n",
+           cores, writePerMille, rcu ? "rcu" : "rwlock");
+    double base = 0;
+    for (int threads = 1; ; threads *= 2) {
+        if (threads > maxThreads)
+            threads = maxThreads;
+
+        double ops = measure(cmap, vmap, threads, seconds, writePerMille);
+        if (base == 0)
+            base = ops;
+        printf("%d;%.0f;%.2f\n", threads, ops, ops / base);
+
+        if (threads == maxThreads)
+            break;
+    }
+
+    deleteConcurrentMap(cmap);
+    deleteVersionedMap(vmap);
+    return 0;
+}
@@ -0,0 +1,88 @@
+/** @file interleave_bench.c
+ *  Measures the time of @ref newRoutes in one thread, with the searches
+ *  run one after another and in turns(see @ref setMapInterleaving).
+ *  The roads of the grid are added in a random order, so the cities
+ *  and the roads close on the map are far apart in the memory.
+ *
+ *  Usage: interleave_bench [grid] [routes]
+ *
+ * @author Cezary Chodun
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "bench_util.h"
+#include "map.h"
+
+/// @private Creates the routes between random cities and removes them.
+static double measure(Map *map, int grid, int n, int searches) {
+    unsigned *ids = (unsigned*) malloc(sizeof(unsigned) * n);
+    char (*names)[32] = malloc(sizeof(*names) * 2 * n);
+    const char **cities = (const char**) malloc(sizeof(char*) * 2 * n);
+    if (ids == NULL || names == NULL || cities == NULL) {
+        free(ids);
+        free(names);
+        free(cities);
+        return 0;
+    }
+
+    uint64_t seed = 88172645463325252ull;
+    for (int i = 0; i < 2 * n; i++) {
+        cityName(names[i], nextRandom(&seed) % grid, nextRandom(&seed) % grid);
+        cities[i] = names[i];
+    }
+    for (int i = 0; i < n; i++)
+        ids[i] = i + 1;
+
+    setMapInterleaving(map, searches);
+    double start = nowSeconds();
+    newRoutes(map, ids, cities, cities + n, n, NULL);
+    double time = nowSeconds() - start;
+
+    for (int i = 0; i < n; i++)
+        removeRoute(map, ids[i]);
+
+    free(ids);
+    free(names);
+    free(cities);
+    return time;
+}
+
+/**
+ * @brief
+ *  Prints the time of creating the routes with 1, 2, 4, 8
+ *  and 16 searches run in turns.
+ */
+int main(int argc, char **argv) {
+    int grid = (argc > 1 ? atoi(argv[1]) : 300);
+    int n = (argc > 2 ? atoi(argv[2]) : 64);
+    if (grid < 2 || n < 1 || n > 999) {
+        fprintf(stderr, "Usage: %s [grid] [routes]\n", argv[0]);
+        return 1;
+    }
+
+    uint64_t seed = 12345;
+    Map *map = buildGridMap(grid, true, &seed);
+    if (map == NULL) {
+        fprintf(stderr, "Failed to build the map\n");
+        return 1;
+    }
+    setMapThreads(map, 1);
+
+    printf("searches;seconds;speedup (cities: %d, routes: %d)\n", grid * grid, n);
+    double base = 0;
+    for (int searches = 1; searches <= 16; searches *= 2) {
+        double time = measure(map, grid, n, searches);
+        if (base == 0)
+            base = time;
+        printf("%d;%.3f;%.2f\n", searches, time, base / time);
+    }
+
+    deleteMap(map);
+    return 0;
+}
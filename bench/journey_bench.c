@@ -0,0 +1,102 @@
+/** @file journey_bench.c
+ *  Measures the time of @ref planJourney on a grid of cities with
+ *  many routes. The routes start in a few hubs and end in random
+ *  cities, so most journeys need a change in a hub.
+ *
+ *  Usage: journey_bench [routes] [journeys]
+ *
+ * @author Cezary Chodun
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "bench_util.h"
+#include "map.h"
+
+/// @private Side of the grid of cities.
+static const int GRID = 150;
+/// @private Number of the routes starting in every hub.
+static const int HUB_ROUTES = 20;
+
+/// @private Creates the routes from the hubs to random cities.
+static int addRoutes(Map *map, int n, uint64_t *seed) {
+    unsigned *ids = (unsigned*) malloc(sizeof(unsigned) * n);
+    char (*names)[32] = malloc(sizeof(*names) * 2 * n);
+    const char **cities = (const char**) malloc(sizeof(char*) * 2 * n);
+    int out = -1;
+
+    if (ids != NULL && names != NULL && cities != NULL) {
+        for (int i = 0; i < n; i++) {
+            if (i % HUB_ROUTES == 0)
+                cityName(names[i], nextRandom(seed) % GRID, nextRandom(seed) % GRID);
+            else
+                memcpy(names[i], names[i - 1], sizeof(names[i]));
+            cityName(names[n + i], nextRandom(seed) % GRID, nextRandom(seed) % GRID);
+            cities[i] = names[i];
+            cities[n + i] = names[n + i];
+            ids[i] = i + 1;
+        }
+        out = newRoutes(map, ids, cities, cities + n, n, NULL);
+    }
+
+    free(ids);
+    free(names);
+    free(cities);
+    return out;
+}
+
+/**
+ * @brief
+ *  Prints the time of copying the stops of the routes and
+ *  the average time of a journey.
+ */
+int main(int argc, char **argv) {
+    int n = (argc > 1 ? atoi(argv[1]) : 999);
+    int journeys = (argc > 2 ? atoi(argv[2]) : 1000);
+    if (n < 1 || n > 999 || journeys < 1) {
+        fprintf(stderr, "Usage: %s [routes(at most 999)] [journeys]\n", argv[0]);
+        return 1;
+    }
+
+    uint64_t seed = 12345;
+    Map *map = buildGridMap(GRID, false, &seed);
+    if (map == NULL) {
+        fprintf(stderr, "Failed to build the map\n");
+        return 1;
+    }
+
+    seed = 88172645463325252ull;
+    int created = addRoutes(map, n, &seed);
+
+    char a[32], b[32];
+    int count, found = 0, legs = 0;
+    double start = nowSeconds();
+    free(planJourney(map, "C0_0", "C1_1", &count));//Copies the stops
+    double build = nowSeconds() - start;
+
+    start = nowSeconds();
+    for (int i = 0; i < journeys; i++) {
+        cityName(a, nextRandom(&seed) % GRID, nextRandom(&seed) % GRID);
+        cityName(b, nextRandom(&seed) % GRID, nextRandom(&seed) % GRID);
+
+        JourneyLeg *out = planJourney(map, a, b, &count);
+        if (out != NULL && count > 0) {
+            found++;
+            legs += count;
+        }
+        free(out);
+    }
+    double time = nowSeconds() - start;
+
+    printf("cities;routes;stops copied(ms);journeys;found;average routes;ms per journey\n");
+    printf("%d;%d;%.3f;%d;%d;%.2f;%.3f\n", GRID * GRID, created, build * 1e3, journeys, found,
+           found > 0 ? (double) legs / found : 0.0, time * 1e3 / journeys);
+
+    deleteMap(map);
+    return 0;
+}
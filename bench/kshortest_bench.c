@@ -0,0 +1,81 @@
+/** @file kshortest_bench.c
+ *  Measures the time of @ref kShortestRoutes on a grid of cities
+ *  for k from 1 to 16.
+ *
+ *  Usage: kshortest_bench [side] [pairs]
+ *
+ * @author Cezary Chodun
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "bench_util.h"
+#include "map.h"
+
+/**
+ * @brief
+ *  Prints the average time of the first search, which also finds
+ *  the tree of the routes from the target, and of the next searches
+ *  for every k, which use the same tree.
+ */
+int main(int argc, char **argv) {
+    int side = (argc > 1 ? atoi(argv[1]) : 300);
+    int pairs = (argc > 2 ? atoi(argv[2]) : 20);
+    if (side < 2 || pairs < 1) {
+        fprintf(stderr, "Usage: %s [side] [pairs]\n", argv[0]);
+        return 1;
+    }
+
+    uint64_t seed = 12345;
+    Map *map = buildGridMap(side, false, &seed);
+    if (map == NULL) {
+        fprintf(stderr, "Failed to build the map\n");
+        return 1;
+    }
+
+    char (*from)[32] = malloc(sizeof(*from) * pairs);
+    char (*to)[32] = malloc(sizeof(*to) * pairs);
+    if (from == NULL || to == NULL) {
+        fprintf(stderr, "Failed to allocate memory\n");
+        return 1;
+    }
+
+    seed = 88172645463325252ull;
+    for (int i = 0; i < pairs; i++) {
+        cityName(from[i], nextRandom(&seed) % side, nextRandom(&seed) % side);
+        cityName(to[i], nextRandom(&seed) % side, nextRandom(&seed) % side);
+    }
+
+    int count, found[17] = {0};
+    double first = 0, time[17] = {0};
+    for (int i = 0; i < pairs; i++) {
+        double start = nowSeconds();
+        free(kShortestRoutes(map, from[i], to[i], 1, &count));
+        first += nowSeconds() - start;
+
+        //The tree of the routes from the target is kept by the map
+        for (int k = 1; k <= 16; k++) {
+            start = nowSeconds();
+            AlternativeRoute *routes = kShortestRoutes(map, from[i], to[i], k, &count);
+            time[k] += nowSeconds() - start;
+            if (routes != NULL)
+                found[k] += count;
+            free(routes);
+        }
+    }
+
+    printf("cities;pairs;first search with the tree(ms)\n");
+    printf("%d;%d;%.3f\n", side * side, pairs, first * 1e3 / pairs);
+    printf("k;routes found;ms per search\n");
+    for (int k = 1; k <= 16; k++)
+        printf("%d;%d;%.3f\n", k, found[k], time[k] * 1e3 / pairs);
+
+    free(from);
+    free(to);
+    deleteMap(map);
+    return 0;
+}
@@ -0,0 +1,96 @@
+/** @file matrix_bench.c
+ *  Measures the time of @ref distanceMatrix for a list of depots
+ *  on a grid of cities, compared with a separate search for every
+ *  pair of the depots.
+ *
+ *  Usage: matrix_bench [depots] [max_threads]
+ *
+ * @author Cezary Chodun
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <unistd.h>
+
+#include "bench_util.h"
+#include "map.h"
+
+/// @private Side of the grid of cities.
+static const int GRID = 60;
+
+/// @private Finds the distances with a separate search for every pair.
+static double measurePairs(Map *map, const char **depots, int n) {
+    double start = nowSeconds();
+
+    for (int i = 0; i < n; i++)
+        for (int j = i + 1; j < n; j++) {
+            const char *pair[2] = {depots[i], depots[j]};
+            free(distanceMatrix(map, pair, 2));
+        }
+
+    return nowSeconds() - start;
+}
+
+/**
+ * @brief
+ *  Prints the time of the separate searches and of the whole
+ *  matrix for 1, 2, 4, ... threads up to the given maximum
+ *  (the number of processors by default).
+ */
+int main(int argc, char **argv) {
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    int n = (argc > 1 ? atoi(argv[1]) : 200);
+    int maxThreads = (argc > 2 ? atoi(argv[2]) : (int) (cores > 0 ? cores : 1));
+    if (n < 2 || n > GRID * GRID || maxThreads < 1) {
+        fprintf(stderr, "Usage: %s [depots] [max_threads]\n", argv[0]);
+        return 1;
+    }
+
+    uint64_t seed = 12345;
+    Map *map = buildGridMap(GRID, false, &seed);
+    char (*names)[32] = malloc(sizeof(*names) * n);
+    const char **depots = (const char**) malloc(sizeof(char*) * n);
+    if (map == NULL || names == NULL || depots == NULL) {
+        fprintf(stderr, "Failed to build the map\n");
+        return 1;
+    }
+
+    seed = 88172645463325252ull;
+    for (int i = 0; i < n; i++) {
+        cityName(names[i], nextRandom(&seed) % GRID, nextRandom(&seed) % GRID);
+        depots[i] = names[i];
+    }
+
+    setMapThreads(map, 1);
+    double pairs = measurePairs(map, depots, n);
+    printf("method;threads;seconds;speedup (cores: %ld, depots: %d, cities: %d)\n",
+           cores, n, GRID * GRID);
+    printf("pairs;1;%.3f;1.00\n", pairs);
+
+    for (int threads = 1; ; threads *= 2) {
+        if (threads > maxThreads)
+            threads = maxThreads;
+
+        setMapThreads(map, threads);
+        double start = nowSeconds();
+        RouteDistance *out = distanceMatrix(map, depots, n);
+        double time = nowSeconds() - start;
+        if (out == NULL) {
+            fprintf(stderr, "Failed to allocate memory\n");
+            break;
+        }
+        free(out);
+        printf("matrix;%d;%.3f;%.2f\n", threads, time, pairs / time);
+
+        if (threads == maxThreads)
+            break;
+    }
+
+    free(depots);
+    free(names);
+    deleteMap(map);
+    return 0;
+}
@@ -0,0 +1,123 @@
+/** @file transaction_bench.c
+ *  Measures the time of closing many roads used by the routes one
+ *  by one with @ref removeRoad and at once in a transaction(see
+ *  @ref beginTransaction). Every route loses a few of its roads.
+ *
+ *  Usage: transaction_bench [routes] [closed roads per route]
+ *
+ * @author Cezary Chodun
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "bench_util.h"
+#include "map.h"
+
+/// @private Side of the grid of cities.
+static const int GRID = 120;
+
+/// @private Builds a grid of cities with random roads and the routes between random cities.
+static Map *buildMap(int routes) {
+    uint64_t seed = 12345;
+    Map *map = buildGridMap(GRID, false, &seed);
+    if (map == NULL)
+        return NULL;
+
+    char a[32], b[32];
+    for (int i = 1; i <= routes; i++) {
+        cityName(a, nextRandom(&seed) % GRID, nextRandom(&seed) % GRID);
+        cityName(b, nextRandom(&seed) % GRID, nextRandom(&seed) % GRID);
+        newRoute(map, i, a, b);
+    }
+
+    return map;
+}
+
+/**
+    @private
+    @brief
+        Chooses 'perRoute' roads of every route, every second one
+        from the start, and stores their cities in 'closed'.
+    @return
+        Number of the chosen roads.
+ */
+static int chooseRoads(Map *map, int routes, int perRoute, char (*closed)[2][32]) {
+    int out = 0;
+    for (int i = 1; i <= routes; i++) {
+        const char *description = getRouteDescription(map, i);
+        if (description == NULL)
+            continue;
+
+        //Fields: number;city;length;year;city;...
+        char *copy = strdup(description);
+        char *cities[4096];
+        int count = 0, field = 0;
+        for (char *s = strtok(copy, ";"); s != NULL && count < 4096; s = strtok(NULL, ";"), field++)
+            if (field % 3 == 1)
+                cities[count++] = s;
+
+        for (int j = 0; j < perRoute && 2 * j + 1 < count; j++) {
+            strcpy(closed[out][0], cities[2 * j]);
+            strcpy(closed[out][1], cities[2 * j + 1]);
+            out++;
+        }
+
+        free(copy);
+        free((void*) description);
+    }
+
+    return out;
+}
+
+/**
+ * @brief
+ *  Prints the time of closing the roads one by one and in a transaction.
+ */
+int main(int argc, char **argv) {
+    int routes = (argc > 1 ? atoi(argv[1]) : 50);
+    int perRoute = (argc > 2 ? atoi(argv[2]) : 2);
+    if (routes < 1 || routes > 999 || perRoute < 1) {
+        fprintf(stderr, "Usage: %s [routes(at most 999)] [closed roads per route]\n", argv[0]);
+        return 1;
+    }
+
+    Map *single = buildMap(routes);
+    Map *grouped = buildMap(routes);
+    char (*closed)[2][32] = malloc(sizeof(*closed) * routes * perRoute);
+    if (single == NULL || grouped == NULL || closed == NULL) {
+        fprintf(stderr, "Failed to build the map\n");
+        return 1;
+    }
+
+    int count = chooseRoads(single, routes, perRoute, closed);
+
+    int removed = 0;
+    double start = nowSeconds();
+    for (int i = 0; i < count; i++)
+        removed += removeRoad(single, closed[i][0], closed[i][1]);
+    double one = nowSeconds() - start;
+
+    int staged = 0;
+    start = nowSeconds();
+    beginTransaction(grouped);
+    for (int i = 0; i < count; i++)
+        staged += removeRoad(grouped, closed[i][0], closed[i][1]);
+    bool committed = commitTransaction(grouped);
+    double all = nowSeconds() - start;
+
+    printf("routes;closed roads;removed one by one;ms one by one;settled one by one;"
+           "committed;ms in transaction;settled in transaction\n");
+    printf("%d;%d;%d;%.3f;%llu;%d;%.3f;%llu\n", routes, count, removed, one * 1e3,
+           getRepairStats(single).settled, committed ? staged : 0, all * 1e3,
+           getRepairStats(grouped).settled);
+
+    free(closed);
+    deleteMap(single);
+    deleteMap(grouped);
+    return 0;
+}
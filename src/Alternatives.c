@@ -0,0 +1,326 @@
+/** @file Alternatives.c
+ *  The search for the k shortest routes(Yen's algorithm).
+ *
+ *  Every next route leaves one of the routes found before in some
+ *  city(the spur), after the same cities(the root), and then goes by
+ *  the shortest way to the target which avoids the cities of the root
+ *  and the roads taken from the spur by the found routes with the same
+ *  root. A route is searched only from the spurs not earlier than the
+ *  city where it left the route it was found from, as the earlier
+ *  spurs were already searched for that route(Lawler's improvement).
+ *
+ *  All searches share one tree of the shortest routes from the target.
+ *  Its distances are never longer than the ways avoiding some cities,
+ *  so the searches use them to go towards the target first(A*, see
+ *  @ref searchGuided) and a search which can follow the tree labels
+ *  few other cities.
+ *
+ * @author Cezary Chodun
+ */
+
+#include "Alternatives.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <stdbool.h>
+
+#include "Road.h"
+
+/// State of the search reused by the consecutive searches.
+typedef struct AlternativeSearch{
+    /// Workspace of the searches from the spurs.
+    SearchWorkspace *ws;
+    /// The tree of the shortest routes from the target.
+    SearchWorkspace *tree;
+    /// Cities of the root, which can not be used.
+    vector *blocked;
+    /// The spur of the current search.
+    City *spur;
+
+    /// Cities which can not be reached directly from the spur.
+    City **cut;
+    /// Number of the cities in 'cut'.
+    int cutCount;
+    /// Size of 'cut'.
+    int cutCapacity;
+
+    /// The routes found so far.
+    Alternative *found;
+    /// Number of the routes in 'found'.
+    int foundCount;
+    /// Size of 'found'.
+    int foundCapacity;
+
+    /// The routes which may be found next.
+    Alternative *candidates;
+    /// Number of the routes in 'candidates'.
+    int candidateCount;
+    /// Size of 'candidates'.
+    int candidateCapacity;
+}AlternativeSearch;
+
+AlternativeSearch *newAlternativeSearch(void) {
+    AlternativeSearch *out = (struct AlternativeSearch*) calloc(1, sizeof(AlternativeSearch));
+    if (out == NULL)
+        return NULL;
+
+    out->ws = newSearchWorkspace();
+    out->blocked = newVec(0);
+    if (out->ws == NULL || out->blocked == NULL) {
+        destroySearchWorkspace(out->ws);
+        destroyVec(out->blocked);
+        free(out);
+        return NULL;
+    }
+
+    return out;
+}
+
+/// @private Frees the routes of the last search.
+static void clearRoutes(AlternativeSearch *as) {
+    for (int i = 0; i < as->foundCount; i++)
+        free(as->found[i].cities);
+    for (int i = 0; i < as->candidateCount; i++)
+        free(as->candidates[i].cities);
+
+    as->foundCount = 0;
+    as->candidateCount = 0;
+}
+
+void destroyAlternativeSearch(AlternativeSearch *as) {
+    if (as == NULL)
+        return;
+
+    clearRoutes(as);
+    destroySearchWorkspace(as->ws);
+    destroyVec(as->blocked);
+    free(as->cut);
+    free(as->found);
+    free(as->candidates);
+    free(as);
+}
+
+/// @private Makes space for 'size' elements of the given size in the array.
+static bool reserve(void **array, int *capacity, int size, size_t element) {
+    if (size <= capacity[0])
+        return true;
+
+    int next = (capacity[0] == 0 ? 16 : capacity[0] * 2);
+    if (next < size)
+        next = size;
+
+    void *grown = realloc(array[0], element * next);
+    if (grown == NULL)
+        return false;
+
+    array[0] = grown;
+    capacity[0] = next;
+    return true;
+}
+
+/// @private Whether the route with the distance 'd1' and oldest road 'y1' is better.
+static bool better(unsigned long long d1, int y1, unsigned long long d2, int y2) {
+    if (d1 != d2)
+        return d1 < d2;
+    return y1 > y2;
+}
+
+/// @private Distance from the city to the target by the tree(UINT_MAX if it can not be reached).
+static unsigned estimateTarget(void *data, City *city) {
+    AlternativeSearch *as = (AlternativeSearch*) data;
+    Distance left;
+    finishRouteDistance(as->tree, city, &left);
+    return (left.city == city ? left.distance : UINT_MAX);
+}
+
+/// @private Whether the road from the city to 'next' was not taken from the spur by a found route.
+static bool notCut(void *data, City *city, City *next) {
+    AlternativeSearch *as = (AlternativeSearch*) data;
+    if (city != as->spur)
+        return true;
+
+    for (int i = 0; i < as->cutCount; i++)
+        if (as->cut[i] == next)
+            return false;
+    return true;
+}
+
+/**
+    @private
+    @brief
+        Finds the shortest way from the 'spur' to 'to', which avoids
+        the blocked cities and the cut roads of the spur. The way
+        continues the root with the given oldest road.
+    @return
+        1 if the way was found, 0 if there is no way and
+        -1 if the memory could not be allocated.
+ */
+static int searchSpur(AlternativeSearch *as, int cities, City *spur, City *to, int oldestRoad) {
+    SearchGuide guide = {&estimateTarget, &notCut, as};
+    as->spur = spur;
+
+    return searchGuided(as->ws, cities, spur, to, oldestRoad, as->blocked, &guide);
+}
+
+/// @private Returns the road between the cities.
+static Road *roadBetween(City *a, City *b) {
+    vector *roads = getRoadsCity(a);
+    for (int i = 0; i < vecSize(roads); i++)
+        if (getConnectedCity(getVec(roads, i), a) == b)
+            return getVec(roads, i);
+    return NULL;
+}
+
+/**
+    @private
+    @brief
+        Adds the route made of the first 'root' cities of 'prev'
+        and the way found from the spur(the next city) to 'to'
+        to the candidates, unless it is already there.
+    @return
+        @p false if the memory could not be allocated.
+ */
+static bool addCandidate(AlternativeSearch *as, Alternative *prev, int root,
+                         unsigned long long distance, City *to) {
+    int size = root;
+    for (City *c = to; c != NULL; c = previousCity(as->ws, c))
+        size++;
+
+    City **cities = (City**) malloc(sizeof(City*) * size);
+    if (cities == NULL)
+        return false;
+
+    memcpy(cities, prev->cities, sizeof(City*) * root);
+    int x = size;
+    for (City *c = to; c != NULL; c = previousCity(as->ws, c))
+        cities[--x] = c;
+
+    for (int i = 0; i < as->candidateCount; i++) {
+        Alternative *other = &as->candidates[i];
+        if (other->size == size && memcmp(other->cities, cities, sizeof(City*) * size) == 0) {
+            free(cities);
+            return true;//Found from another route
+        }
+    }
+
+    if (!reserve((void**) &as->candidates, &as->candidateCapacity,
+                 as->candidateCount + 1, sizeof(Alternative))) {
+        free(cities);
+        return false;
+    }
+
+    Distance way;
+    finishRouteDistance(as->ws, to, &way);
+
+    Alternative *out = &as->candidates[as->candidateCount++];
+    out->cities = cities;
+    out->size = size;
+    out->distance = distance + way.distance;
+    out->oldestRoad = way.oldestRoad;
+    out->deviation = root;
+
+    return true;
+}
+
+/**
+    @private
+    @brief
+        Searches the routes leaving the last found route
+        in its cities, and adds them to the candidates.
+    @return
+        @p false if the memory could not be allocated.
+ */
+static bool branchRoute(AlternativeSearch *as, int cities, City *to) {
+    Alternative *prev = &as->found[as->foundCount - 1];
+    unsigned long long distance = 0;
+    int oldestRoad = INT_MAX;
+
+    for (int i = 0; i + 1 < prev->size; i++) {
+        if (i > 0) {//The root is longer by one road
+            Road *road = roadBetween(prev->cities[i - 1], prev->cities[i]);
+            if (road == NULL)
+                return false;
+
+            distance += getRoadLength(road);
+            if (getRoadYear(road) < oldestRoad)
+                oldestRoad = getRoadYear(road);
+        }
+        if (i < prev->deviation)
+            continue;
+
+        resetVec(as->blocked);
+        as->cutCount = 0;
+        for (int j = 0; j < i; j++)
+            if (pushBackVec(as->blocked, prev->cities[j]) == NULL)
+                return false;
+
+        //The found routes with the same root can not be repeated
+        for (int j = 0; j < as->foundCount; j++) {
+            Alternative *other = &as->found[j];
+            if (other->size <= i + 1
+                || memcmp(other->cities, prev->cities, sizeof(City*) * (i + 1)) != 0)
+                continue;
+
+            if (!reserve((void**) &as->cut, &as->cutCapacity, as->cutCount + 1, sizeof(City*)))
+                return false;
+            as->cut[as->cutCount++] = other->cities[i + 1];
+        }
+
+        int ret = searchSpur(as, cities, prev->cities[i], to, oldestRoad);
+        if (ret == -1 || (ret == 1 && !addCandidate(as, prev, i, distance, to)))
+            return false;
+    }
+
+    return true;
+}
+
+int findAlternatives(AlternativeSearch *as, int cities, City *from, City *to,
+                     SearchWorkspace *tree, int k, Alternative **routes) {
+    if (as == NULL || from == NULL || to == NULL || tree == NULL || routes == NULL)
+        return -1;
+
+    clearRoutes(as);
+    routes[0] = as->found;
+    if (k <= 0)
+        return 0;
+
+    //The shortest route is the only candidate at first
+    as->tree = tree;
+    as->cutCount = 0;
+    resetVec(as->blocked);
+    int ret = searchSpur(as, cities, from, to, INT_MAX);
+    if (ret != 1)
+        return ret;
+
+    Alternative start = {&from, 1, 0, INT_MAX, 0};
+    if (!addCandidate(as, &start, 0, 0, to))
+        return -1;
+
+    while (as->foundCount < k && as->candidateCount > 0) {
+        int best = 0;
+        for (int i = 1; i < as->candidateCount; i++)
+            if (better(as->candidates[i].distance, as->candidates[i].oldestRoad,
+                       as->candidates[best].distance, as->candidates[best].oldestRoad))
+                best = i;
+
+        if (!reserve((void**) &as->found, &as->foundCapacity,
+                     as->foundCount + 1, sizeof(Alternative)))
+            return -1;
+        as->found[as->foundCount++] = as->candidates[best];
+        as->candidates[best] = as->candidates[--as->candidateCount];
+
+        if (as->foundCount < k && !branchRoute(as, cities, to))
+            return -1;
+    }
+
+    routes[0] = as->found;
+    return as->foundCount;
+}
+
+unsigned long long settledAlternatives(AlternativeSearch *as) {
+    if (as == NULL)
+        return 0;
+
+    return settledCities(as->ws);
+}
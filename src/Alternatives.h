@@ -0,0 +1,72 @@
+/** @file Alternatives.h
+ *  Interface for the 'AlternativeSearch' class, which finds the
+ *  k shortest routes(without repeated cities) between two cities.
+ *  The routes are compared as in @ref distanceComparator.
+ *
+ * @author Cezary Chodun
+ */
+
+#ifndef Alternatives_h
+#define Alternatives_h
+
+#include "City.h"
+#include "Search.h"
+
+/// @private
+typedef struct AlternativeSearch AlternativeSearch;
+
+/** A route found by @ref findAlternatives. */
+typedef struct Alternative{
+    /// The cities of the route, from the start to the target.
+    City **cities;
+    /// Number of the cities.
+    int size;
+    /// Sum of the lengths of the roads.
+    unsigned long long distance;
+    /// The smallest year of the roads.
+    int oldestRoad;
+    /// Number of the first city which is not shared with the route it was found from.
+    int deviation;
+}Alternative;
+
+/**
+    @brief
+        Creates a new search.
+    @return
+        A pointer to the search or NULL if
+        the memory could not be allocated.
+ */
+AlternativeSearch *newAlternativeSearch(void);
+
+/**
+    @brief
+        Destroys the search.
+ */
+void destroyAlternativeSearch(AlternativeSearch *as);
+
+/**
+    @brief
+        Finds at most 'k' shortest routes from the city 'from' to
+        the city 'to', best first. Routes with the same distance
+        and oldest road are given in any order.
+    @param[in] cities - number of the cities in the map, the ids of
+        the cities are smaller;
+    @param[in] tree - the finished search of the routes from 'to'
+        to all cities(see @ref searchAllRoutes), used to direct
+        the searches towards 'to';
+    @param[out] routes - the routes, valid until the next call.
+    @return
+        Number of the routes(0 if 'to' can not be reached)
+        or -1 if the memory could not be allocated.
+ */
+int findAlternatives(AlternativeSearch *as, int cities, City *from, City *to,
+                     SearchWorkspace *tree, int k, Alternative **routes);
+
+/**
+    @brief
+        Returns the number of the cities settled by all
+        searches of the routes.
+ */
+unsigned long long settledAlternatives(AlternativeSearch *as);
+
+#endif /* Alternatives_h */
@@ -0,0 +1,597 @@
+/** @file BinaryProtocol.c
+ *  Binary command format.
+ *
+ * @author Cezary Chodun
+ */
+
+#include "BinaryProtocol.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "Text.h"
+#include "Trie.h"
+
+/// @private Header of the binary input.
+static const unsigned char BINARY_HEADER[5] = {BINARY_MAGIC_BYTE, 'B', 'L', 'N', 1};
+
+/// @private Size of the alphabet for the names of the cities.
+static const unsigned NAMES_ALPHABET = 260;
+
+/// Decoder of the binary commands.
+typedef struct BinaryReader{
+    /// The input.
+    FILE *in;
+    /// Names of the cities in the order of appearance.
+    vector *names;
+    /// Payload of the current frame.
+    unsigned char *frame;
+    /// Size of the 'frame' array.
+    size_t capacity;
+}BinaryReader;
+
+/// Encoder of the binary commands.
+typedef struct BinaryWriter{
+    /// Numbers of the cities which already appeared.
+    Trie *ids;
+    /// Pointers to the numbers(to free them).
+    vector *idPtrs;
+}BinaryWriter;
+
+BinaryReader *newBinaryReader(FILE *in) {
+    for (size_t i = 0; i < sizeof(BINARY_HEADER); i++)
+        if (getc(in) != BINARY_HEADER[i])
+            return NULL;//Wrong header
+
+    BinaryReader *out = (struct BinaryReader*) malloc(sizeof(BinaryReader));
+    if (out == NULL)
+        return NULL;
+
+    out->in = in;
+    out->names = newVec(16);
+    out->capacity = 256;
+    out->frame = (unsigned char*) malloc(out->capacity);
+    if (out->names == NULL || out->frame == NULL) {
+        destroyBinaryReader(out);
+        return NULL;
+    }
+
+    return out;
+}
+
+void destroyBinaryReader(BinaryReader *reader) {
+    if (reader == NULL)
+        return;
+
+    for (int i = 0; i < vecSize(reader->names); i++)
+        free(getVec(reader->names, i));
+    destroyVec(reader->names);
+    free(reader->frame);
+    free(reader);
+}
+
+/// @private
+static void resetBinaryCommand(BinaryCommand *cmd) {
+    cmd->op = BIN_INVALID;
+    cmd->routeId = 0;
+    cmd->length = 0;
+    cmd->year = 0;
+    cmd->city1 = NULL;
+    cmd->city2 = NULL;
+    cmd->path = NULL;
+    cmd->cities = NULL;
+    cmd->lengths = NULL;
+    cmd->years = NULL;
+}
+
+void clearBinaryCommand(BinaryCommand *cmd) {
+    free(cmd->path);
+
+    for (int i = 0; i < vecSize(cmd->lengths); i++)
+        free(getVec(cmd->lengths, i));
+    for (int i = 0; i < vecSize(cmd->years); i++)
+        free(getVec(cmd->years, i));
+    destroyVec(cmd->cities);
+    destroyVec(cmd->lengths);
+    destroyVec(cmd->years);
+
+    resetBinaryCommand(cmd);
+}
+
+/// @private Reads a varint directly from the input.
+static int readFrameSize(FILE *in, size_t *size) {
+    uint64_t out = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        int c = getc(in);
+        if (c == EOF)
+            return shift == 0 ? 0 : -2;//End of the input or a cut frame
+
+        out |= (uint64_t) (c & 0x7F) << shift;
+        if ((c & 0x80) == 0) {
+            if (out > SIZE_MAX / 2)
+                return -2;
+            size[0] = (size_t) out;
+            return 1;
+        }
+    }
+
+    return -2;//Too long
+}
+
+/// @private
+static bool readUnsigned(ByteReader *in, unsigned *val) {
+    uint64_t tmp;
+    if (!getVarUInt(in, &tmp) || tmp > UINT32_MAX)
+        return false;
+
+    val[0] = (unsigned) tmp;
+    return true;
+}
+
+/// @private
+static bool readYear(ByteReader *in, int *val) {
+    int64_t tmp;
+    if (!getVarInt(in, &tmp) || tmp < INT32_MIN || tmp > INT32_MAX)
+        return false;
+
+    val[0] = (int) tmp;
+    return true;
+}
+
+/// @private Reads the reference to a city, and remembers the new names.
+static bool readCity(BinaryReader *reader, ByteReader *in, const char **city) {
+    uint64_t id;
+    if (!getVarUInt(in, &id))
+        return false;
+
+    if (id == 0) {
+        char *name;
+        if (!getString(in, &name))
+            return false;
+        if (pushBackVec(reader->names, name) == NULL) {
+            free(name);
+            return false;
+        }
+
+        city[0] = name;
+        return true;
+    }
+
+    if (id > (uint64_t) vecSize(reader->names))
+        return false;//Unknown city
+
+    city[0] = getVec(reader->names, (int) id - 1);
+    return true;
+}
+
+/// @private
+static bool readExactRoute(BinaryReader *reader, ByteReader *in, BinaryCommand *cmd) {
+    uint64_t roads;
+    if (!readUnsigned(in, &cmd->routeId) || !getVarUInt(in, &roads))
+        return false;
+    if (roads == 0 || roads > in->size - in->pos)
+        return false;//Every road takes at least 3 bytes
+
+    cmd->cities = newVec((int) roads + 1);
+    cmd->lengths = newVec((int) roads);
+    cmd->years = newVec((int) roads);
+    if (cmd->cities == NULL || cmd->lengths == NULL || cmd->years == NULL)
+        return false;
+
+    const char *city;
+    if (!readCity(reader, in, &city) || pushBackVec(cmd->cities, (void*) city) == NULL)
+        return false;
+
+    for (uint64_t i = 0; i < roads; i++) {
+        unsigned *length = (unsigned*) malloc(sizeof(unsigned));
+        if (length == NULL)
+            return false;
+        if (pushBackVec(cmd->lengths, length) == NULL) {
+            free(length);
+            return false;
+        }
+
+        int *year = (int*) malloc(sizeof(int));
+        if (year == NULL)
+            return false;
+        if (pushBackVec(cmd->years, year) == NULL) {
+            free(year);
+            return false;
+        }
+
+        if (!readUnsigned(in, length) || !readYear(in, year))
+            return false;
+        if (!readCity(reader, in, &city) || pushBackVec(cmd->cities, (void*) city) == NULL)
+            return false;
+    }
+
+    return true;
+}
+
+/// @private Decodes the payload of the frame.
+static bool readPayload(BinaryReader *reader, ByteReader *in, BinaryCommand *cmd) {
+    unsigned char op;
+    if (!getByte(in, &op))
+        return false;
+
+    bool ok;
+    switch (op) {
+        case BIN_NOP:
+        case BIN_INVALID:
+            ok = true;
+            break;
+        case BIN_ADD_ROAD:
+            ok = readCity(reader, in, &cmd->city1) && readCity(reader, in, &cmd->city2)
+                 && readUnsigned(in, &cmd->length) && readYear(in, &cmd->year);
+            break;
+        case BIN_REPAIR_ROAD:
+            ok = readCity(reader, in, &cmd->city1) && readCity(reader, in, &cmd->city2)
+                 && readYear(in, &cmd->year);
+            break;
+        case BIN_GET_ROUTE_DESCRIPTION:
+        case BIN_REMOVE_ROUTE:
+            ok = readUnsigned(in, &cmd->routeId);
+            break;
+        case BIN_NEW_ROUTE:
+            ok = readUnsigned(in, &cmd->routeId) && readCity(reader, in, &cmd->city1)
+                 && readCity(reader, in, &cmd->city2);
+            break;
+        case BIN_EXTEND_ROUTE:
+            ok = readUnsigned(in, &cmd->routeId) && readCity(reader, in, &cmd->city1);
+            break;
+        case BIN_REMOVE_ROAD:
+            ok = readCity(reader, in, &cmd->city1) && readCity(reader, in, &cmd->city2);
+            break;
+        case BIN_EXACT_ROUTE:
+            ok = readExactRoute(reader, in, cmd);
+            break;
+        case BIN_CHECKPOINT:
+            ok = getString(in, &cmd->path);
+            break;
+        default:
+            ok = false;//Unknown operation
+            break;
+    }
+
+    cmd->op = (BinaryOp) op;
+    return ok && in->pos == in->size;
+}
+
+int readBinaryCommand(BinaryReader *reader, BinaryCommand *cmd) {
+    resetBinaryCommand(cmd);
+
+    size_t size;
+    int ret = readFrameSize(reader->in, &size);
+    if (ret != 1)
+        return ret;
+
+    if (size > reader->capacity) {
+        unsigned char *tmp = (unsigned char*) realloc(reader->frame, size);
+        if (tmp == NULL)
+            return -2;//Failed to allocate memory
+        reader->frame = tmp;
+        reader->capacity = size;
+    }
+    if (fread(reader->frame, 1, size, reader->in) != size)
+        return -2;//Cut frame
+
+    ByteReader in;
+    initByteReader(&in, reader->frame, size);
+    if (!readPayload(reader, &in, cmd)) {
+        clearBinaryCommand(cmd);
+        return -1;
+    }
+
+    return 1;
+}
+
+bool executeBinaryCommand(Map *map, BinaryCommand *cmd) {
+    const char *out;
+
+    switch (cmd->op) {
+        case BIN_ADD_ROAD:
+            return addRoad(map, cmd->city1, cmd->city2, cmd->length, cmd->year);
+        case BIN_REPAIR_ROAD:
+            return repairRoad(map, cmd->city1, cmd->city2, cmd->year);
+        case BIN_GET_ROUTE_DESCRIPTION:
+            out = getRouteDescription(map, cmd->routeId);
+            if (out == NULL)
+                return false;
+
+            fprintf(stdout, "%s\n", out);
+            free((void*) out);
+            return true;
+        case BIN_NEW_ROUTE:
+            return newRoute(map, cmd->routeId, cmd->city1, cmd->city2);
+        case BIN_EXTEND_ROUTE:
+            return extendRoute(map, cmd->routeId, cmd->city1);
+        case BIN_REMOVE_ROAD:
+            return removeRoad(map, cmd->city1, cmd->city2);
+        case BIN_REMOVE_ROUTE:
+            return removeRoute(map, cmd->routeId);
+        case BIN_EXACT_ROUTE:
+            return exactRoute(map, cmd->routeId, cmd->cities, cmd->lengths, cmd->years);
+        default:
+            return false;//Not a map command
+    }
+}
+
+/// @private
+static bool pushText(vector *args, Text *arg) {
+    if (arg == NULL)
+        return false;
+    if (pushBackVec(args, arg) == NULL) {
+        destroyText(arg);
+        return false;
+    }
+    return true;
+}
+
+/// @private
+static bool pushName(vector *args, const char *name) {
+    return pushText(args, newText((char*) name));
+}
+
+/// @private
+static bool pushUInt(vector *args, unsigned val) {
+    Text *arg = newText("");
+    if (arg != NULL && appendUInt(arg, val) == NULL) {
+        destroyText(arg);
+        return false;
+    }
+    return pushText(args, arg);
+}
+
+/// @private
+static bool pushInt(vector *args, int val) {
+    Text *arg = newText("");
+    if (arg != NULL && appendInt(arg, val) == NULL) {
+        destroyText(arg);
+        return false;
+    }
+    return pushText(args, arg);
+}
+
+vector *binaryCommandArgs(BinaryCommand *cmd) {
+    vector *args = newVec(5);
+    if (args == NULL)
+        return NULL;
+
+    bool ok;
+    switch (cmd->op) {
+        case BIN_ADD_ROAD:
+            ok = pushName(args, "addRoad") && pushName(args, cmd->city1)
+                 && pushName(args, cmd->city2) && pushUInt(args, cmd->length)
+                 && pushInt(args, cmd->year);
+            break;
+        case BIN_REPAIR_ROAD:
+            ok = pushName(args, "repairRoad") && pushName(args, cmd->city1)
+                 && pushName(args, cmd->city2) && pushInt(args, cmd->year);
+            break;
+        case BIN_GET_ROUTE_DESCRIPTION:
+            ok = pushName(args, "getRouteDescription") && pushUInt(args, cmd->routeId);
+            break;
+        case BIN_NEW_ROUTE:
+            ok = pushName(args, "newRoute") && pushUInt(args, cmd->routeId)
+                 && pushName(args, cmd->city1) && pushName(args, cmd->city2);
+            break;
+        case BIN_EXTEND_ROUTE:
+            ok = pushName(args, "extendRoute") && pushUInt(args, cmd->routeId)
+                 && pushName(args, cmd->city1);
+            break;
+        case BIN_REMOVE_ROAD:
+            ok = pushName(args, "removeRoad") && pushName(args, cmd->city1)
+                 && pushName(args, cmd->city2);
+            break;
+        case BIN_REMOVE_ROUTE:
+            ok = pushName(args, "removeRoute") && pushUInt(args, cmd->routeId);
+            break;
+        case BIN_EXACT_ROUTE:
+            ok = pushUInt(args, cmd->routeId) && pushName(args, getVec(cmd->cities, 0));
+            for (int i = 0; i < vecSize(cmd->lengths) && ok; i++)
+                ok = pushUInt(args, *(unsigned*) getVec(cmd->lengths, i))
+                     && pushInt(args, *(int*) getVec(cmd->years, i))
+                     && pushName(args, getVec(cmd->cities, i + 1));
+            break;
+        case BIN_CHECKPOINT:
+            ok = pushName(args, "checkpoint") && pushName(args, cmd->path);
+            break;
+        default:
+            ok = false;
+            break;
+    }
+
+    if (!ok) {
+        for (int i = 0; i < vecSize(args); i++)
+            destroyText(getVec(args, i));
+        destroyVec(args);
+        return NULL;
+    }
+
+    return args;
+}
+
+BinaryWriter *newBinaryWriter(void) {
+    BinaryWriter *out = (struct BinaryWriter*) malloc(sizeof(BinaryWriter));
+    if (out == NULL)
+        return NULL;
+
+    out->ids = newTrie(NAMES_ALPHABET);
+    out->idPtrs = newVec(16);
+    if (out->ids == NULL || out->idPtrs == NULL) {
+        destroyBinaryWriter(out);
+        return NULL;
+    }
+
+    return out;
+}
+
+void destroyBinaryWriter(BinaryWriter *writer) {
+    if (writer == NULL)
+        return;
+
+    for (int i = 0; i < vecSize(writer->idPtrs); i++)
+        free(getVec(writer->idPtrs, i));
+    destroyVec(writer->idPtrs);
+    destroyTrie(writer->ids);
+    free(writer);
+}
+
+bool encodeBinaryHeader(ByteBuffer *out) {
+    return putBytes(out, BINARY_HEADER, sizeof(BINARY_HEADER)) != NULL;
+}
+
+/// @private Appends the payload as a frame.
+static bool putFrame(ByteBuffer *out, ByteBuffer *payload) {
+    return putVarUInt(out, byteBufferSize(payload)) != NULL
+           && putBytes(out, byteBufferData(payload), byteBufferSize(payload)) != NULL;
+}
+
+bool encodeBinaryEmpty(ByteBuffer *out, BinaryOp op) {
+    unsigned char frame[2] = {1, (unsigned char) op};
+    return putBytes(out, frame, 2) != NULL;
+}
+
+/// @private Writes the number of the city, or its name if it is new.
+static bool putCity(BinaryWriter *writer, ByteBuffer *out, Text *city) {
+    char *name = to_cString(city);
+    if (name == NULL)
+        return false;
+
+    int size = (int) strlen(name);
+    int *id = getTrie(writer->ids, name, size);
+    bool ok;
+
+    if (id != NULL)
+        ok = (putVarUInt(out, (uint64_t) id[0]) != NULL);
+    else {
+        id = (int*) malloc(sizeof(int));
+        ok = (id != NULL && pushBackVec(writer->idPtrs, id) != NULL);
+        if (!ok)
+            free(id);
+        else {
+            id[0] = vecSize(writer->idPtrs);
+            ok = (addTrie(writer->ids, name, size, id) != NULL);
+            ok = ok && putVarUInt(out, 0) != NULL && putString(out, name) != NULL;
+        }
+    }
+
+    free(name);
+    return ok;
+}
+
+/// @private Checks the numeric arguments('U' - unsigned, 'I' - int, 'S' - name).
+static bool validArguments(vector *args, const char *types) {
+    if ((size_t) vecSize(args) != strlen(types) + 1)
+        return false;
+
+    unsigned uval;
+    int ival;
+    for (int i = 1; i < vecSize(args); i++) {
+        if (types[i - 1] == 'U' && !toUIntVal(getVec(args, i), &uval))
+            return false;
+        if (types[i - 1] == 'I' && !toIntVal(getVec(args, i), &ival))
+            return false;
+    }
+    return true;
+}
+
+/// @private Writes the arguments of the command.
+static bool putArguments(BinaryWriter *writer, ByteBuffer *out, vector *args,
+                         int first, const char *types) {
+    bool ok = true;
+    unsigned uval;
+    int ival;
+
+    for (int i = first; i < vecSize(args) && ok; i++) {
+        Text *arg = getVec(args, i);
+        char type = types[(i - first) % strlen(types)];
+
+        if (type == 'U')
+            ok = toUIntVal(arg, &uval) && putVarUInt(out, uval) != NULL;
+        else if (type == 'I')
+            ok = toIntVal(arg, &ival) && putVarInt(out, ival) != NULL;
+        else
+            ok = putCity(writer, out, arg);
+    }
+    return ok;
+}
+
+/// @private
+static bool validExactRoute(vector *args) {
+    if (vecSize(args) < 5 || vecSize(args)%3 != 2)
+        return false;
+
+    unsigned uval;
+    int ival;
+    for (int i = 0; i < vecSize(args); i++) {
+        if (i%3 == 0 && i > 0 && !toIntVal(getVec(args, i), &ival))
+            return false;
+        if ((i%3 == 2 || i == 0) && !toUIntVal(getVec(args, i), &uval))
+            return false;
+    }
+    return true;
+}
+
+bool encodeBinaryCommand(BinaryWriter *writer, vector *args, ByteBuffer *out) {
+    if (writer == NULL || args == NULL || vecSize(args) == 0)
+        return false;
+
+    //Operations with fixed arguments
+    static const struct {
+        const char *name;
+        BinaryOp op;
+        const char *types;
+    } commands[] = {
+        {"addRoad", BIN_ADD_ROAD, "SSUI"},
+        {"repairRoad", BIN_REPAIR_ROAD, "SSI"},
+        {"getRouteDescription", BIN_GET_ROUTE_DESCRIPTION, "U"},
+        {"newRoute", BIN_NEW_ROUTE, "USS"},
+        {"extendRoute", BIN_EXTEND_ROUTE, "US"},
+        {"removeRoad", BIN_REMOVE_ROAD, "SS"},
+        {"removeRoute", BIN_REMOVE_ROUTE, "U"}
+    };
+
+    ByteBuffer *payload = newByteBuffer(64);
+    if (payload == NULL)
+        return false;
+
+    Text *cmd = getVec(args, 0);
+    bool ok = true, valid = false;
+    unsigned uval;
+
+    for (size_t i = 0; i < sizeof(commands) / sizeof(commands[0]) && !valid; i++) {
+        if (!equalsC(cmd, commands[i].name))
+            continue;
+        if (!validArguments(args, commands[i].types))
+            break;
+
+        valid = true;
+        ok = putByte(payload, commands[i].op) != NULL
+             && putArguments(writer, payload, args, 1, commands[i].types);
+    }
+
+    if (!valid && toUIntVal(cmd, &uval) && validExactRoute(args)) {
+        valid = true;
+        ok = putByte(payload, BIN_EXACT_ROUTE) != NULL
+             && putVarUInt(payload, uval) != NULL
+             && putVarUInt(payload, (uint64_t) (vecSize(args) - 2) / 3) != NULL
+             && putArguments(writer, payload, args, 1, "SUI");
+    }
+    else if (!valid && equalsC(cmd, "checkpoint")
+             && vecSize(args) == 2 && textSize(getVec(args, 1)) > 0) {
+        char *path = to_cString(getVec(args, 1));
+        valid = true;
+        ok = path != NULL && putByte(payload, BIN_CHECKPOINT) != NULL
+             && putString(payload, path) != NULL;
+        free(path);
+    }
+
+    if (!valid)
+        ok = encodeBinaryEmpty(out, BIN_INVALID);
+    else
+        ok = ok && putFrame(out, payload);
+
+    destroyByteBuffer(payload);
+    return ok;
+}
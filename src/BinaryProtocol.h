@@ -0,0 +1,192 @@
+/** @file BinaryProtocol.h
+ *  Interface of the binary command format, an alternative to
+ *  the text commands for programs which generate the input.
+ *
+ *  The input starts with the header: byte 0xB1, "BLN", version(1 byte).
+ *  Then every command is a frame: size of the payload(varint) and
+ *  the payload, which starts with the operation code(1 byte).
+ *  Every frame counts as a single line of the text format.
+ *
+ *  Cities are identified by numbers given in the order of their
+ *  first appearance in the input(starting from 1). Number 0 means
+ *  that the city appears for the first time and its name follows.
+ *  Lengths and route ids are unsigned varints, years are zigzag
+ *  encoded varints.
+ *
+ * @author Cezary Chodun
+ */
+
+#ifndef BinaryProtocol_h
+#define BinaryProtocol_h
+
+#include <stdio.h>
+#include <stdbool.h>
+
+#include "ByteBuffer.h"
+#include "map.h"
+#include "vector.h"
+
+/// First byte of the binary input, which never starts a text command.
+#define BINARY_MAGIC_BYTE 0xB1
+
+/**
+    Operation codes of the frames.
+ */
+typedef enum BinaryOp{
+    /// Empty line or a comment.
+    BIN_NOP = 0,
+    /// city1, city2, length, builtYear.
+    BIN_ADD_ROAD = 1,
+    /// city1, city2, repairYear.
+    BIN_REPAIR_ROAD = 2,
+    /// routeId.
+    BIN_GET_ROUTE_DESCRIPTION = 3,
+    /// routeId, city1, city2.
+    BIN_NEW_ROUTE = 4,
+    /// routeId, city.
+    BIN_EXTEND_ROUTE = 5,
+    /// city1, city2.
+    BIN_REMOVE_ROAD = 6,
+    /// routeId.
+    BIN_REMOVE_ROUTE = 7,
+    /// routeId, number of roads, city, (length, builtYear, city)...
+    BIN_EXACT_ROUTE = 8,
+    /// path(string).
+    BIN_CHECKPOINT = 9,
+    /// Line which is not a correct command.
+    BIN_INVALID = 10
+}BinaryOp;
+
+/**
+    Decoded command. The names of the cities belong
+    to the BinaryReader.
+ */
+typedef struct BinaryCommand{
+    /// Operation code.
+    BinaryOp op;
+    /// Id of the route.
+    unsigned routeId;
+    /// Length of the road.
+    unsigned length;
+    /// Built or repair year.
+    int year;
+    /// The first city.
+    const char *city1;
+    /// The second city.
+    const char *city2;
+    /// Path of the checkpoint.
+    char *path;
+    /// Cities of the exact route.
+    vector *cities;
+    /// Lengths of the roads of the exact route(unsigned*).
+    vector *lengths;
+    /// Built years of the roads of the exact route(int*).
+    vector *years;
+}BinaryCommand;
+
+/// @private
+typedef struct BinaryReader BinaryReader;
+
+/// @private
+typedef struct BinaryWriter BinaryWriter;
+
+/**
+    @brief
+        Creates a reader of the binary commands and
+        reads the header of the input.
+    @return
+        A pointer to the reader or NULL if the header
+        is wrong or the memory could not be allocated.
+ */
+BinaryReader *newBinaryReader(FILE *in);
+
+/**
+    @brief
+        Frees the reader together with the names
+        of the cities.
+ */
+void destroyBinaryReader(BinaryReader *reader);
+
+/**
+    @brief
+        Reads the next command.
+        The command has to be cleared with @ref clearBinaryCommand.
+    @return
+        1 if the command was read, 0 at the end of the input,
+        -1 if the frame is malformed(it is skipped) and
+        -2 if the input is broken and can not be read further.
+ */
+int readBinaryCommand(BinaryReader *reader, BinaryCommand *cmd);
+
+/**
+    @brief
+        Frees the memory allocated for the command.
+ */
+void clearBinaryCommand(BinaryCommand *cmd);
+
+/**
+    @brief
+        Executes the map command(from BIN_ADD_ROAD to BIN_EXACT_ROUTE).
+        The route description is printed on the standard output.
+    @return
+        @p true if the operation was successful, and
+        @p false otherwise.
+ */
+bool executeBinaryCommand(Map *map, BinaryCommand *cmd);
+
+/**
+    @brief
+        Creates the text arguments of the command,
+        as they would be given by splitText for the
+        text command.
+    @return
+        A vector of Text or NULL if the memory
+        could not be allocated.
+ */
+vector *binaryCommandArgs(BinaryCommand *cmd);
+
+/**
+    @brief
+        Creates an encoder of the binary commands.
+    @return
+        A pointer to the writer or NULL if
+        the memory could not be allocated.
+ */
+BinaryWriter *newBinaryWriter(void);
+
+/**
+    @brief
+        Frees the writer.
+ */
+void destroyBinaryWriter(BinaryWriter *writer);
+
+/**
+    @brief
+        Appends the header of the binary input.
+    @return
+        @p true if the operation was successful, and
+        @p false otherwise.
+ */
+bool encodeBinaryHeader(ByteBuffer *out);
+
+/**
+    @brief
+        Appends a frame without arguments(BIN_NOP or BIN_INVALID).
+    @return
+        @p true if the operation was successful, and
+        @p false otherwise.
+ */
+bool encodeBinaryEmpty(ByteBuffer *out, BinaryOp op);
+
+/**
+    @brief
+        Appends the frame for the text command split
+        into arguments(see @ref splitText). If the arguments
+        do not form a correct command, BIN_INVALID is written.
+    @return
+        @p true if the operation was successful, and
+        @p false otherwise.
+ */
+bool encodeBinaryCommand(BinaryWriter *writer, vector *args, ByteBuffer *out);
+
+#endif /* BinaryProtocol_h */
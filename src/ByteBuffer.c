@@ -0,0 +1,258 @@
+/** @file ByteBuffer.c
+ *  Growable buffer for binary encoded data.
+ *
+ * @author Cezary Chodun
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "ByteBuffer.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+
+/// Binary data buffer.
+typedef struct ByteBuffer{
+    /// Stored bytes.
+    unsigned char *data;
+    /// Number of stored bytes.
+    size_t size;
+    /// Size of the array.
+    size_t capacity;
+}ByteBuffer;
+
+ByteBuffer *newByteBuffer(size_t capacity) {
+    ByteBuffer *out = (struct ByteBuffer*) malloc(sizeof(ByteBuffer));
+    if (out == NULL)
+        return NULL;
+
+    if (capacity < 16)
+        capacity = 16;
+
+    out->data = (unsigned char*) malloc(capacity);
+    if (out->data == NULL) {
+        free(out);
+        return NULL;
+    }
+    out->size = 0;
+    out->capacity = capacity;
+
+    return out;
+}
+
+void destroyByteBuffer(ByteBuffer *buf) {
+    if (buf == NULL)
+        return;
+
+    free(buf->data);
+    free(buf);
+}
+
+void clearByteBuffer(ByteBuffer *buf) {
+    buf->size = 0;
+}
+
+size_t byteBufferSize(ByteBuffer *buf) {
+    return buf->size;
+}
+
+const unsigned char *byteBufferData(ByteBuffer *buf) {
+    return buf->data;
+}
+
+/// @private
+static void *reserveBytes(ByteBuffer *buf, size_t extra) {
+    if (buf->size + extra <= buf->capacity)
+        return buf;
+
+    size_t capacity = buf->capacity;
+    while (capacity < buf->size + extra)
+        capacity <<= 1;
+
+    unsigned char *tmp = (unsigned char*) realloc(buf->data, capacity);
+    if (tmp == NULL)
+        return NULL;//Failed to allocate memory
+
+    buf->data = tmp;
+    buf->capacity = capacity;
+    return buf;
+}
+
+void *putBytes(ByteBuffer *buf, const void *data, size_t size) {
+    if (buf == NULL || reserveBytes(buf, size) == NULL)
+        return NULL;
+
+    if (size > 0)
+        memcpy(buf->data + buf->size, data, size);
+    buf->size += size;
+    return buf;
+}
+
+void *putByte(ByteBuffer *buf, unsigned char val) {
+    return putBytes(buf, &val, 1);
+}
+
+void *putU32(ByteBuffer *buf, uint32_t val) {
+    unsigned char tmp[4];
+    for (int i = 0; i < 4; i++)
+        tmp[i] = (unsigned char) (val >> (8 * i));
+    return putBytes(buf, tmp, 4);
+}
+
+void *putU64(ByteBuffer *buf, uint64_t val) {
+    unsigned char tmp[8];
+    for (int i = 0; i < 8; i++)
+        tmp[i] = (unsigned char) (val >> (8 * i));
+    return putBytes(buf, tmp, 8);
+}
+
+void *putVarUInt(ByteBuffer *buf, uint64_t val) {
+    unsigned char tmp[10];
+    int size = 0;
+
+    while (val >= 0x80) {
+        tmp[size++] = (unsigned char) (val | 0x80);
+        val >>= 7;
+    }
+    tmp[size++] = (unsigned char) val;
+
+    return putBytes(buf, tmp, size);
+}
+
+void *putVarInt(ByteBuffer *buf, int64_t val) {
+    uint64_t zigzag = ((uint64_t) val << 1) ^ (uint64_t) (val >> 63);
+    return putVarUInt(buf, zigzag);
+}
+
+void *putString(ByteBuffer *buf, const char *s) {
+    size_t size = strlen(s);
+    if (putVarUInt(buf, size) == NULL)
+        return NULL;
+    return putBytes(buf, s, size);
+}
+
+bool writeByteBuffer(ByteBuffer *buf, int fd) {
+    size_t done = 0;
+    while (done < buf->size) {
+        ssize_t ret = write(fd, buf->data + done, buf->size - done);
+        if (ret < 0) {
+            if (errno == EINTR)
+                continue;
+            return false;//Write error
+        }
+        done += (size_t) ret;
+    }
+
+    return true;
+}
+
+bool readByteBuffer(ByteBuffer *buf, int fd) {
+    while (true) {
+        if (reserveBytes(buf, 4096) == NULL)
+            return false;//Failed to allocate memory
+
+        ssize_t ret = read(fd, buf->data + buf->size, buf->capacity - buf->size);
+        if (ret < 0) {
+            if (errno == EINTR)
+                continue;
+            return false;//Read error
+        }
+        if (ret == 0)
+            return true;//End of the file
+        buf->size += (size_t) ret;
+    }
+}
+
+void initByteReader(ByteReader *in, const unsigned char *data, size_t size) {
+    in->data = data;
+    in->size = size;
+    in->pos = 0;
+}
+
+bool getByte(ByteReader *in, unsigned char *val) {
+    if (in->pos >= in->size)
+        return false;
+
+    val[0] = in->data[in->pos++];
+    return true;
+}
+
+bool getU32(ByteReader *in, uint32_t *val) {
+    if (in->size - in->pos < 4)
+        return false;
+
+    uint32_t out = 0;
+    for (int i = 0; i < 4; i++)
+        out |= (uint32_t) in->data[in->pos++] << (8 * i);
+
+    val[0] = out;
+    return true;
+}
+
+bool getU64(ByteReader *in, uint64_t *val) {
+    if (in->size - in->pos < 8)
+        return false;
+
+    uint64_t out = 0;
+    for (int i = 0; i < 8; i++)
+        out |= (uint64_t) in->data[in->pos++] << (8 * i);
+
+    val[0] = out;
+    return true;
+}
+
+bool getVarUInt(ByteReader *in, uint64_t *val) {
+    uint64_t out = 0;
+    unsigned char b;
+
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (!getByte(in, &b))
+            return false;
+
+        out |= (uint64_t) (b & 0x7F) << shift;
+        if ((b & 0x80) == 0) {
+            val[0] = out;
+            return true;
+        }
+    }
+
+    return false;//Too long
+}
+
+bool getVarInt(ByteReader *in, int64_t *val) {
+    uint64_t zigzag;
+    if (!getVarUInt(in, &zigzag))
+        return false;
+
+    val[0] = (int64_t) (zigzag >> 1) ^ -(int64_t) (zigzag & 1);
+    return true;
+}
+
+bool getString(ByteReader *in, char **val) {
+    uint64_t size;
+    if (!getVarUInt(in, &size) || size > in->size - in->pos)
+        return false;
+
+    char *out = (char*) malloc(size + 1);
+    if (out == NULL)
+        return false;
+
+    memcpy(out, in->data + in->pos, size);
+    out[size] = '\0';
+    in->pos += size;
+
+    val[0] = out;
+    return true;
+}
+
+uint32_t checksumBytes(const unsigned char *data, size_t size) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= data[i];
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
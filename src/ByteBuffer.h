@@ -0,0 +1,225 @@
+/** @file ByteBuffer.h
+ *  Interface for the 'ByteBuffer' class which helps encode data in
+ *  a compact binary form.
+ *
+ * @author Cezary Chodun
+ */
+
+#ifndef ByteBuffer_h
+#define ByteBuffer_h
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/// @private
+typedef struct ByteBuffer ByteBuffer;
+
+/**
+    Position in a block of encoded bytes.
+ */
+typedef struct ByteReader{
+    /// Encoded data.
+    const unsigned char *data;
+    /// Size of the data.
+    size_t size;
+    /// Index of the next byte to read.
+    size_t pos;
+}ByteReader;
+
+/**
+    @brief
+        Creates a new, empty ByteBuffer.
+    @return
+        A pointer to the ByteBuffer or NULL if
+        the memory could not be allocated.
+ */
+ByteBuffer *newByteBuffer(size_t capacity);
+
+/**
+    @brief
+        Frees the ByteBuffer and its data.
+ */
+void destroyByteBuffer(ByteBuffer *buf);
+
+/**
+    @brief
+        Discards the data stored in the buffer, but
+        preserves its capacity.
+ */
+void clearByteBuffer(ByteBuffer *buf);
+
+/**
+    @brief
+        Returns the number of bytes stored in the buffer.
+    @return
+        Size of the buffer.
+ */
+size_t byteBufferSize(ByteBuffer *buf);
+
+/**
+    @brief
+        Returns the bytes stored in the buffer.
+    <b>NOTE: </b> the pointer becomes invalid after
+        the next write to the buffer.
+    @return
+        A pointer to the first byte.
+ */
+const unsigned char *byteBufferData(ByteBuffer *buf);
+
+/**
+    @brief
+        Appends 'size' bytes to the buffer.
+    @return
+        'buf' if the operation was successful
+        and NULL otherwise
+ */
+void *putBytes(ByteBuffer *buf, const void *data, size_t size);
+
+/**
+    @brief
+        Appends a single byte to the buffer.
+    @return
+        'buf' if the operation was successful
+        and NULL otherwise
+ */
+void *putByte(ByteBuffer *buf, unsigned char val);
+
+/**
+    @brief
+        Appends a 32 bit value(little endian) to the buffer.
+    @return
+        'buf' if the operation was successful
+        and NULL otherwise
+ */
+void *putU32(ByteBuffer *buf, uint32_t val);
+
+/**
+    @brief
+        Appends a 64 bit value(little endian) to the buffer.
+    @return
+        'buf' if the operation was successful
+        and NULL otherwise
+ */
+void *putU64(ByteBuffer *buf, uint64_t val);
+
+/**
+    @brief
+        Appends an unsigned value as a varint
+        (7 bits per byte, the highest bit marks continuation).
+    @return
+        'buf' if the operation was successful
+        and NULL otherwise
+ */
+void *putVarUInt(ByteBuffer *buf, uint64_t val);
+
+/**
+    @brief
+        Appends a signed value as a zigzag encoded varint.
+    @return
+        'buf' if the operation was successful
+        and NULL otherwise
+ */
+void *putVarInt(ByteBuffer *buf, int64_t val);
+
+/**
+    @brief
+        Appends a C style string(its length followed by
+        the characters, without the '\0').
+    @return
+        'buf' if the operation was successful
+        and NULL otherwise
+ */
+void *putString(ByteBuffer *buf, const char *s);
+
+/**
+    @brief
+        Writes the whole buffer to the file descriptor.
+    @return
+        @p true if every byte was written and
+        @p false otherwise.
+ */
+bool writeByteBuffer(ByteBuffer *buf, int fd);
+
+/**
+    @brief
+        Appends everything that can be read from
+        the file descriptor to the buffer.
+    @return
+        @p true if the whole file was read and
+        @p false otherwise.
+ */
+bool readByteBuffer(ByteBuffer *buf, int fd);
+
+/**
+    @brief
+        Sets the reader at the beginning of the data.
+ */
+void initByteReader(ByteReader *in, const unsigned char *data, size_t size);
+
+/**
+    @brief
+        Reads a single byte.
+    @return
+        @p true if the value was read and
+        @p false if the data ended.
+ */
+bool getByte(ByteReader *in, unsigned char *val);
+
+/**
+    @brief
+        Reads a 32 bit value written by @ref putU32.
+    @return
+        @p true if the value was read and
+        @p false if the data ended.
+ */
+bool getU32(ByteReader *in, uint32_t *val);
+
+/**
+    @brief
+        Reads a 64 bit value written by @ref putU64.
+    @return
+        @p true if the value was read and
+        @p false if the data ended.
+ */
+bool getU64(ByteReader *in, uint64_t *val);
+
+/**
+    @brief
+        Reads a value written by @ref putVarUInt.
+    @return
+        @p true if the value was read and
+        @p false if the data is malformed.
+ */
+bool getVarUInt(ByteReader *in, uint64_t *val);
+
+/**
+    @brief
+        Reads a value written by @ref putVarInt.
+    @return
+        @p true if the value was read and
+        @p false if the data is malformed.
+ */
+bool getVarInt(ByteReader *in, int64_t *val);
+
+/**
+    @brief
+        Reads a string written by @ref putString.
+        Allocates memory for it, which has to be
+        freed with the free function.
+    @return
+        @p true if the value was read and
+        @p false if the data is malformed or the memory
+        could not be allocated.
+ */
+bool getString(ByteReader *in, char **val);
+
+/**
+    @brief
+        Calculates the checksum(32 bit FNV-1a) of the data.
+    @return
+        The checksum.
+ */
+uint32_t checksumBytes(const unsigned char *data, size_t size);
+
+#endif /* ByteBuffer_h */
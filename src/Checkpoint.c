@@ -0,0 +1,188 @@
+/** @file Checkpoint.c
+ *  Snapshots of the map written in child processes.
+ *
+ * @author Cezary Chodun
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "Checkpoint.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#include "Snapshot.h"
+#include "vector.h"
+
+/// @private Checkpoint written by a child process.
+typedef struct Checkpoint{
+    /// Id of the child process.
+    pid_t pid;
+    /// Reading end of the pipe with the result.
+    int fd;
+    /// Number reported together with the result.
+    int tag;
+}Checkpoint;
+
+/// Set of the running checkpoints.
+typedef struct Checkpointer{
+    /// Running checkpoints.
+    vector *running;
+}Checkpointer;
+
+Checkpointer *newCheckpointer(void) {
+    Checkpointer *out = (struct Checkpointer*) malloc(sizeof(Checkpointer));
+    if (out == NULL)
+        return NULL;
+
+    out->running = newVec(1);
+    if (out->running == NULL) {
+        free(out);
+        return NULL;
+    }
+
+    return out;
+}
+
+void destroyCheckpointer(Checkpointer *checkpointer) {
+    if (checkpointer == NULL)
+        return;
+
+    finishCheckpoints(checkpointer);
+    destroyVec(checkpointer->running);
+    free(checkpointer);
+}
+
+/// @private
+static uint64_t nowNanoseconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000u + (uint64_t) ts.tv_nsec;
+}
+
+/// @private Body of the child process.
+static void writeCheckpoint(Map *map, const char *path, uint64_t lsn, int fd) {
+    uint64_t start = nowNanoseconds();
+    bool ok = writeSnapshot(map, path, lsn);
+    uint64_t time = nowNanoseconds() - start;
+
+    unsigned char result[9];
+    result[0] = ok;
+    for (int i = 0; i < 8; i++)
+        result[i + 1] = (unsigned char) (time >> (8 * i));
+
+    ssize_t ret;
+    do {
+        ret = write(fd, result, sizeof(result));
+    } while (ret < 0 && errno == EINTR);
+
+    close(fd);
+    //Skips the atexit handlers and the buffers inherited from the parent
+    _exit(ok ? 0 : 1);
+}
+
+bool startCheckpoint(Checkpointer *checkpointer, Map *map, const char *path,
+                     uint64_t lsn, int tag) {
+    if (checkpointer == NULL || map == NULL || path == NULL)
+        return false;//Wrong parameters
+
+    Checkpoint *cp = (struct Checkpoint*) malloc(sizeof(Checkpoint));
+    if (cp == NULL)
+        return false;
+    if (pushBackVec(checkpointer->running, cp) == NULL) {
+        free(cp);
+        return false;
+    }
+
+    int fds[2];
+    if (pipe(fds) != 0) {
+        free(popBackVec(checkpointer->running));
+        return false;
+    }
+
+    pid_t pid = fork();
+    if (pid < 0) {
+        close(fds[0]);
+        close(fds[1]);
+        free(popBackVec(checkpointer->running));
+        return false;
+    }
+    if (pid == 0) {
+        close(fds[0]);
+        writeCheckpoint(map, path, lsn, fds[1]);
+    }
+
+    close(fds[1]);
+    cp->pid = pid;
+    cp->fd = fds[0];
+    cp->tag = tag;
+
+    return true;
+}
+
+/// @private Reads the result of the finished checkpoint and reports it.
+static void reportCheckpoint(Checkpoint *cp, int status) {
+    unsigned char result[9];
+    size_t done = 0;
+    while (done < sizeof(result)) {
+        ssize_t ret = read(cp->fd, result + done, sizeof(result) - done);
+        if (ret < 0 && errno == EINTR)
+            continue;
+        if (ret <= 0)
+            break;
+        done += (size_t) ret;
+    }
+    close(cp->fd);
+
+    bool ok = (done == sizeof(result) && result[0] != 0
+               && WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    if (!ok) {
+        fprintf(stderr, "CHECKPOINT %d FAILED\n", cp->tag);
+        return;
+    }
+
+    uint64_t time = 0;
+    for (int i = 0; i < 8; i++)
+        time |= (uint64_t) result[i + 1] << (8 * i);
+    fprintf(stderr, "CHECKPOINT %d OK %.3f ms\n", cp->tag, time / 1e6);
+}
+
+/// @private
+static void collectCheckpoints(Checkpointer *checkpointer, int options) {
+    if (checkpointer == NULL)
+        return;
+
+    vector *running = checkpointer->running;
+    for (int i = 0; i < vecSize(running); i++) {
+        Checkpoint *cp = getVec(running, i);
+
+        int status;
+        pid_t ret = waitpid(cp->pid, &status, options);
+        if (ret < 0 && errno == EINTR && options == 0) {
+            i--;
+            continue;//Interrupted, waits again
+        }
+        if (ret == 0 || (ret < 0 && errno == EINTR))
+            continue;//Still running
+        if (ret < 0)
+            status = -1;//The child was lost
+
+        reportCheckpoint(cp, status);
+        free(cp);
+        removeVec(running, i);
+        i--;
+    }
+}
+
+void pollCheckpoints(Checkpointer *checkpointer) {
+    collectCheckpoints(checkpointer, WNOHANG);
+}
+
+void finishCheckpoints(Checkpointer *checkpointer) {
+    collectCheckpoints(checkpointer, 0);
+}
@@ -0,0 +1,72 @@
+/** @file Checkpoint.h
+ *  Interface for the 'Checkpointer' class, which writes snapshots
+ *  of the map in child processes, so that the program can
+ *  execute commands while the snapshot is being written.
+ *
+ * @author Cezary Chodun
+ */
+
+#ifndef Checkpoint_h
+#define Checkpoint_h
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "map.h"
+
+/// @private
+typedef struct Checkpointer Checkpointer;
+
+/**
+    @brief
+        Creates a new Checkpointer without running checkpoints.
+    @return
+        A pointer to the Checkpointer or NULL if
+        the memory could not be allocated.
+ */
+Checkpointer *newCheckpointer(void);
+
+/**
+    @brief
+        Waits for the running checkpoints and frees
+        the Checkpointer.
+ */
+void destroyCheckpointer(Checkpointer *checkpointer);
+
+/**
+    @brief
+        Starts writing the snapshot of the map(see @ref writeSnapshot)
+        in a child process. The child works on the copy of the memory
+        made by fork(), so the map can be modified right after the
+        function returns.
+    @param[in] checkpointer - the Checkpointer;
+    @param[in] map          - the map;
+    @param[in] path         - path of the snapshot;
+    @param[in] lsn          - number of the last journal record
+                              reflected in the map;
+    @param[in] tag          - number reported together with
+                              the result(e.g. the line of the command).
+    @return
+        @p true if the child process was started and
+        @p false otherwise.
+ */
+bool startCheckpoint(Checkpointer *checkpointer, Map *map, const char *path,
+                     uint64_t lsn, int tag);
+
+/**
+    @brief
+        Reports the checkpoints which were finished since
+        the last call, without waiting for the running ones.
+        Every checkpoint is reported on the standard error output as
+        "CHECKPOINT tag OK time ms" or "CHECKPOINT tag FAILED".
+ */
+void pollCheckpoints(Checkpointer *checkpointer);
+
+/**
+    @brief
+        Waits for every running checkpoint and reports it
+        (see @ref pollCheckpoints).
+ */
+void finishCheckpoints(Checkpointer *checkpointer);
+
+#endif /* Checkpoint_h */
@@ -10,6 +10,15 @@
 #include <string.h>
 
 #include "Text.h"
+#include "Road.h"
+
+/** A route going through the City. */
+typedef struct CityRoute{
+    /** The route. */
+    Route *route;
+    /** Number of the roads of the route which end in the City. */
+    int roads;
+}CityRoute;
 
 /**
     A data structure containing information
@@ -24,6 +33,15 @@ typedef struct City{
     vector *roads;
     /** City name. */
     const char *name;
+    /** Routes(see @ref Route) going through the City. */
+    CityRoute *routes;
+    /** Number of the routes going through the City. */
+    int routeCount;
+    /** Size of 'routes'. */
+    int routeCapacity;
+    /** Whether some routes are missing from 'routes', because
+        the memory could not be allocated(see @ref indexRoutesCity). */
+    bool routesStale;
 }City;
 
 City *newCity(int id, const char *cityName) {
@@ -34,7 +52,7 @@ City *newCity(int id, const char *cityName) {
     int size = cStringSize(cityName);
     char *name = (char*) malloc((size + 1) * sizeof(char));
     if (name == NULL) {
-        destroyCity(out);
+        free(out);
         return NULL;
     }
     memcpy(name, cityName, size * sizeof(char));
@@ -42,12 +60,17 @@ City *newCity(int id, const char *cityName) {
 
     out->roads = newVec(0);
     if (out->roads == NULL) {
+        free(name);
         free(out);
         return NULL;
     }
 
     out->id = id;
     out->name = name;
+    out->routes = NULL;
+    out->routeCount = 0;
+    out->routeCapacity = 0;
+    out->routesStale = false;
 
     return out;
 }
@@ -57,6 +80,7 @@ void destroyCity(City *city) {
         return;
 
     destroyVec(city->roads);
+    free(city->routes);
     if (city->name != NULL)
         free((void *) city->name);
 
@@ -72,6 +96,62 @@ void removeRoadCity(City *city, int x) {
     popBackVec(city->roads);
 }
 
+void addRouteCity(City *city, Route *route) {
+    for (int i = 0; i < city->routeCount; i++)
+        if (city->routes[i].route == route) {
+            city->routes[i].roads++;
+            return;
+        }
+
+    if (city->routeCount == city->routeCapacity) {
+        int capacity = (city->routeCapacity == 0 ? 4 : city->routeCapacity * 2);
+        CityRoute *routes = (CityRoute*) realloc(city->routes, sizeof(CityRoute) * capacity);
+        if (routes == NULL) {
+            city->routesStale = true;//The routes are found again from the roads
+            return;
+        }
+
+        city->routes = routes;
+        city->routeCapacity = capacity;
+    }
+
+    city->routes[city->routeCount].route = route;
+    city->routes[city->routeCount].roads = 1;
+    city->routeCount++;
+}
+
+void removeRouteCity(City *city, Route *route) {
+    for (int i = 0; i < city->routeCount; i++)
+        if (city->routes[i].route == route) {
+            if (--city->routes[i].roads == 0)
+                city->routes[i] = city->routes[--city->routeCount];
+            return;
+        }
+}
+
+bool indexRoutesCity(City *city) {
+    if (!city->routesStale)
+        return true;
+
+    city->routeCount = 0;
+    city->routesStale = false;
+    for (int i = 0; i < vecSize(city->roads); i++) {
+        vector *routes = getRoutesRoad(getVec(city->roads, i));
+        for (int j = 0; j < vecSize(routes); j++)
+            addRouteCity(city, getVec(routes, j));
+    }
+
+    return !city->routesStale;
+}
+
+int routeCountCity(City *city) {
+    return city->routeCount;
+}
+
+Route *getRouteCity(City *city, int x) {
+    return city->routes[x].route;
+}
+
 vector *getRoadsCity(City *city) {
     return city->roads;
 }
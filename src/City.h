@@ -7,6 +7,8 @@
 #ifndef City_h
 #define City_h
 
+#include <stdbool.h>
+
 #include "vector.h"
 
 /// @private
@@ -15,6 +17,9 @@ typedef struct Road Road;
 /// @private
 typedef struct City City;
 
+/// @private
+typedef struct Route Route;
+
 /**
     @brief
         Creates a new City.
@@ -47,6 +52,46 @@ void removeRoadCity(City *city, int x);
  */
 vector *getRoadsCity(City *city);
 
+/**
+    @brief
+        Notes that a road of the route ends in the City.
+        A route is kept once, however many of its roads end here.
+        If the memory can not be allocated, the routes of the City
+        are found again by @ref indexRoutesCity.
+ */
+void addRouteCity(City *city, Route *route);
+
+/**
+    @brief
+        Notes that a road of the route no longer ends in the City.
+        The route is removed when none of its roads ends here.
+ */
+void removeRouteCity(City *city, Route *route);
+
+/**
+    @brief
+        Finds the routes going through the City again from the
+        routes of its roads, if some of them could not be noted.
+        It has to be called before the routes are read.
+    @return
+        @p false if the memory could not be allocated.
+ */
+bool indexRoutesCity(City *city);
+
+/**
+    @brief
+        Returns the number of the routes(see @ref Route)
+        going through the City.
+ */
+int routeCountCity(City *city);
+
+/**
+    @brief
+        Returns the x-th route going through the City
+        (the order is not specified).
+ */
+Route *getRouteCity(City *city, int x);
+
 /**
     @brief
         Returns the City name.
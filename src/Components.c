@@ -0,0 +1,311 @@
+/** @file Components.c
+ *  Connected components of the cities, following the changes of the roads.
+ *
+ *  Every city has the label of its component. When a road joins two
+ *  components, the smaller one takes the label of the larger one, so
+ *  a city changes its label at most log(n) times while roads are added.
+ *
+ *  When a road is removed, its cities are searched from in turns. If the
+ *  searches meet, the component stays whole. If one of them ends first,
+ *  it has visited a whole new component, which gets a new label. Either
+ *  way the work is bounded by the smaller part, or by the detour around
+ *  the removed road, and not by the whole map.
+ *
+ * @author Cezary Chodun
+ */
+
+#include "Components.h"
+
+#include <stdlib.h>
+
+#include "Road.h"
+
+/// Labels of the components.
+typedef struct Components{
+    /// Number of the labelled cities.
+    int size;
+    /// Size of the arrays of the cities.
+    int capacity;
+    /// Label of the component of every city.
+    int *label;
+    /// Number of the last search which visited the city.
+    unsigned long long *visit;
+    /// Number of the last search.
+    unsigned long long visits;
+    /// Queues of the searches.
+    City **first, **second;
+
+    /// Number of the labels in use.
+    int labels;
+    /// Size of the array of the labels.
+    int labelCapacity;
+    /// Number of the cities with every label.
+    int *members;
+}Components;
+
+Components *newComponents(void) {
+    Components *out = (struct Components*) malloc(sizeof(Components));
+    if (out == NULL)
+        return NULL;
+
+    out->size = 0;
+    out->capacity = 0;
+    out->label = NULL;
+    out->visit = NULL;
+    out->visits = 0;
+    out->first = NULL;
+    out->second = NULL;
+    out->labels = 0;
+    out->labelCapacity = 0;
+    out->members = NULL;
+
+    return out;
+}
+
+void destroyComponents(Components *components) {
+    if (components == NULL)
+        return;
+
+    free(components->label);
+    free(components->visit);
+    free(components->first);
+    free(components->second);
+    free(components->members);
+    free(components);
+}
+
+/// @private Resizes the array of 'count' elements of the given size.
+static bool growArray(void **array, int count, size_t size) {
+    void *out = realloc(array[0], count * size);
+    if (out == NULL)
+        return false;
+
+    array[0] = out;
+    return true;
+}
+
+/// @private Makes room for the cities with the ids smaller than 'size'.
+static bool growCities(Components *components, int size) {
+    if (size <= components->capacity)
+        return true;
+
+    int capacity = components->capacity * 2;
+    if (capacity < size)
+        capacity = size;
+
+    if (!growArray((void**) &components->label, capacity, sizeof(int))
+        || !growArray((void**) &components->visit, capacity, sizeof(unsigned long long))
+        || !growArray((void**) &components->first, capacity, sizeof(City*))
+        || !growArray((void**) &components->second, capacity, sizeof(City*)))
+        return false;
+    components->capacity = capacity;
+
+    return true;
+}
+
+/// @private Returns a new label with 'members' cities(-1 if the memory could not be allocated).
+static int newLabel(Components *components, int members) {
+    if (components->labels == components->labelCapacity) {
+        int capacity = (components->labelCapacity == 0 ? 16 : components->labelCapacity * 2);
+        if (!growArray((void**) &components->members, capacity, sizeof(int)))
+            return -1;
+        components->labelCapacity = capacity;
+    }
+
+    components->members[components->labels] = members;
+    return components->labels++;
+}
+
+/// @private Labels the cities with the ids smaller than 'size', which have no roads yet.
+static bool reserveCities(Components *components, int size) {
+    if (!growCities(components, size))
+        return false;
+
+    for (int i = components->size; i < size; i++) {
+        int label = newLabel(components, 1);
+        if (label == -1)
+            return false;
+
+        components->label[i] = label;
+        components->visit[i] = 0;
+        components->size = i + 1;
+    }
+
+    return true;
+}
+
+/**
+ @private
+ @brief
+ Gives the 'label' to the cities reachable from the city 'from'
+ through the cities with the label 'old'(or without a label if
+ 'old' is -1).
+ @return
+ Number of the labelled cities.
+ */
+static int spreadLabel(Components *components, City *from, int old, int label) {
+    City **queue = components->first;
+    int head = 0, tail = 0;
+
+    components->label[getCityID(from)] = label;
+    queue[tail++] = from;
+
+    while (head < tail) {
+        City *city = queue[head++];
+        vector *roads = getRoadsCity(city);
+
+        for (int i = 0; i < vecSize(roads); i++) {
+            City *other = getConnectedCity(getVec(roads, i), city);
+            int id = getCityID(other);
+
+            if (id < components->size && components->label[id] == old) {
+                components->label[id] = label;
+                queue[tail++] = other;
+            }
+        }
+    }
+
+    return tail;
+}
+
+bool resetComponents(Components *components, vector *cities) {
+    if (components == NULL || cities == NULL)
+        return false;
+
+    int size = vecSize(cities);
+    if (!growCities(components, size))
+        return false;
+
+    components->size = size;
+    components->labels = 0;
+    for (int i = 0; i < size; i++) {
+        components->label[i] = -1;
+        components->visit[i] = 0;
+    }
+
+    for (int i = 0; i < size; i++) {
+        if (components->label[i] != -1)
+            continue;
+
+        int label = newLabel(components, 0);
+        if (label == -1)
+            return false;
+        components->members[label] = spreadLabel(components, getVec(cities, i), -1, label);
+    }
+
+    return true;
+}
+
+bool addRoadComponents(Components *components, City *a, City *b) {
+    if (components == NULL || a == NULL || b == NULL)
+        return false;//Wrong parameters
+
+    int ida = getCityID(a), idb = getCityID(b);
+    if (!reserveCities(components, (ida > idb ? ida : idb) + 1))
+        return false;//Failed to allocate memory
+
+    int la = components->label[ida];
+    int lb = components->label[idb];
+    if (la == lb)
+        return true;
+
+    //The smaller component takes the label of the larger one
+    if (components->members[la] > components->members[lb]) {
+        int tmp = la;
+        la = lb;
+        lb = tmp;
+        a = b;
+    }
+
+    components->members[lb] += spreadLabel(components, a, la, lb);
+    components->members[la] = 0;
+
+    return true;
+}
+
+/**
+ @private
+ @brief
+ Visits the neighbours of the next city in the 'queue'.
+ @return
+ @p true if a city visited by the other search was found.
+ */
+static bool searchStep(Components *components, City **queue, int *head, int *tail,
+                       unsigned long long visit, unsigned long long other) {
+    City *city = queue[(*head)++];
+    vector *roads = getRoadsCity(city);
+
+    for (int i = 0; i < vecSize(roads); i++) {
+        City *next = getConnectedCity(getVec(roads, i), city);
+        int id = getCityID(next);
+
+        if (id >= components->size || components->visit[id] == visit)
+            continue;
+        if (components->visit[id] == other)
+            return true;
+
+        components->visit[id] = visit;
+        queue[(*tail)++] = next;
+    }
+
+    return false;
+}
+
+/// @private Gives a new label to the 'count' cities in the 'queue'.
+static bool splitComponent(Components *components, City **queue, int count) {
+    int label = newLabel(components, count);
+    if (label == -1)
+        return false;
+
+    components->members[components->label[getCityID(queue[0])]] -= count;
+    for (int i = 0; i < count; i++)
+        components->label[getCityID(queue[i])] = label;
+
+    return true;
+}
+
+bool removeRoadComponents(Components *components, City *a, City *b) {
+    if (components == NULL || a == NULL || b == NULL)
+        return false;//Wrong parameters
+
+    int ida = getCityID(a), idb = getCityID(b);
+    if (!reserveCities(components, (ida > idb ? ida : idb) + 1))
+        return false;//Failed to allocate memory
+    if (a == b || components->label[ida] != components->label[idb])
+        return true;
+
+    unsigned long long visitA = ++components->visits;
+    unsigned long long visitB = ++components->visits;
+    int headA = 0, tailA = 0, headB = 0, tailB = 0;
+
+    components->visit[ida] = visitA;
+    components->first[tailA++] = a;
+    components->visit[idb] = visitB;
+    components->second[tailB++] = b;
+
+    //The search which ends first has visited the smaller part
+    while (true) {
+        if (headA == tailA)
+            return splitComponent(components, components->first, tailA);
+        if (headB == tailB)
+            return splitComponent(components, components->second, tailB);
+
+        if (searchStep(components, components->first, &headA, &tailA, visitA, visitB))
+            return true;
+        if (searchStep(components, components->second, &headB, &tailB, visitB, visitA))
+            return true;
+    }
+}
+
+bool connectedComponents(Components *components, City *a, City *b) {
+    if (a == b)
+        return true;
+    if (components == NULL || a == NULL || b == NULL)
+        return false;
+
+    int ida = getCityID(a), idb = getCityID(b);
+    if (ida >= components->size || idb >= components->size)
+        return false;//A city without roads
+
+    return components->label[ida] == components->label[idb];
+}
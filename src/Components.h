@@ -0,0 +1,73 @@
+/** @file Components.h
+ *  Interface for the 'Components' class, which labels the cities
+ *  with the numbers of their connected components. The labels follow
+ *  the roads which are added and removed.
+ *
+ * @author Cezary Chodun
+ */
+
+#ifndef Components_h
+#define Components_h
+
+#include <stdbool.h>
+
+#include "vector.h"
+#include "City.h"
+
+/// @private
+typedef struct Components Components;
+
+/**
+    @brief
+        Creates the labels for a map without any roads.
+    @return
+        A pointer to the labels or NULL if the
+        memory could not be allocated.
+ */
+Components *newComponents(void);
+
+/**
+    @brief
+        Destroys the labels.
+ */
+void destroyComponents(Components *components);
+
+/**
+    @brief
+        Labels the 'cities'(see @ref City) again,
+        using their current roads.
+    @return
+        @p true if the operation was successful, and @p false
+        if the memory could not be allocated.
+ */
+bool resetComponents(Components *components, vector *cities);
+
+/**
+    @brief
+        Updates the labels after the road between the
+        cities 'a' and 'b' was added to the cities.
+    @return
+        @p true if the operation was successful, and @p false
+        if the memory could not be allocated(the labels
+        have to be reset then).
+ */
+bool addRoadComponents(Components *components, City *a, City *b);
+
+/**
+    @brief
+        Updates the labels after the road between the
+        cities 'a' and 'b' was removed from the cities.
+    @return
+        @p true if the operation was successful, and @p false
+        if the memory could not be allocated(the labels
+        have to be reset then).
+ */
+bool removeRoadComponents(Components *components, City *a, City *b);
+
+/**
+    @brief
+        Checks whether the cities 'a' and 'b' are connected.
+ */
+bool connectedComponents(Components *components, City *a, City *b);
+
+#endif /* Components_h */
@@ -0,0 +1,121 @@
+/** @file ConcurrentMap.c
+ *  Map shared by many threads, guarded by a reader/writer lock.
+ *
+ * @author Cezary Chodun
+ */
+
+#define _GNU_SOURCE
+
+#include "ConcurrentMap.h"
+
+#include <stdlib.h>
+#include <pthread.h>
+
+/// Map guarded by a reader/writer lock.
+typedef struct ConcurrentMap{
+    /// The map.
+    Map *map;
+    /// Lock shared by the readers and taken exclusively by the writers.
+    pthread_rwlock_t lock;
+}ConcurrentMap;
+
+ConcurrentMap *newConcurrentMap(Map *map) {
+    if (map == NULL)
+        return NULL;
+
+    ConcurrentMap *out = (struct ConcurrentMap*) malloc(sizeof(ConcurrentMap));
+    if (out == NULL)
+        return NULL;
+
+    pthread_rwlockattr_t attr;
+    pthread_rwlockattr_init(&attr);
+#ifdef __GLIBC__
+    //Modifications are rare, so a stream of queries must not starve them
+    pthread_rwlockattr_setkind_np(&attr, PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP);
+#endif
+    int ret = pthread_rwlock_init(&out->lock, &attr);
+    pthread_rwlockattr_destroy(&attr);
+
+    if (ret != 0) {
+        free(out);
+        return NULL;
+    }
+
+    out->map = map;
+    return out;
+}
+
+void deleteConcurrentMap(ConcurrentMap *cmap) {
+    if (cmap == NULL)
+        return;
+
+    pthread_rwlock_destroy(&cmap->lock);
+    deleteMap(cmap->map);
+    free(cmap);
+}
+
+Map *lockMapRead(ConcurrentMap *cmap) {
+    pthread_rwlock_rdlock(&cmap->lock);
+    return cmap->map;
+}
+
+Map *lockMapWrite(ConcurrentMap *cmap) {
+    pthread_rwlock_wrlock(&cmap->lock);
+    return cmap->map;
+}
+
+void unlockMap(ConcurrentMap *cmap) {
+    pthread_rwlock_unlock(&cmap->lock);
+}
+
+bool concurrentAddRoad(ConcurrentMap *cmap, const char *city1, const char *city2,
+                       unsigned length, int builtYear) {
+    bool out = addRoad(lockMapWrite(cmap), city1, city2, length, builtYear);
+    unlockMap(cmap);
+    return out;
+}
+
+bool concurrentRepairRoad(ConcurrentMap *cmap, const char *city1, const char *city2,
+                          int repairYear) {
+    bool out = repairRoad(lockMapWrite(cmap), city1, city2, repairYear);
+    unlockMap(cmap);
+    return out;
+}
+
+bool concurrentNewRoute(ConcurrentMap *cmap, unsigned routeId,
+                        const char *city1, const char *city2) {
+    bool out = newRoute(lockMapWrite(cmap), routeId, city1, city2);
+    unlockMap(cmap);
+    return out;
+}
+
+bool concurrentExactRoute(ConcurrentMap *cmap, unsigned num, vector *cityNames,
+                          vector *roadLengths, vector *roadBuiltYears) {
+    bool out = exactRoute(lockMapWrite(cmap), num, cityNames, roadLengths, roadBuiltYears);
+    unlockMap(cmap);
+    return out;
+}
+
+bool concurrentExtendRoute(ConcurrentMap *cmap, unsigned routeId, const char *city) {
+    bool out = extendRoute(lockMapWrite(cmap), routeId, city);
+    unlockMap(cmap);
+    return out;
+}
+
+bool concurrentRemoveRoad(ConcurrentMap *cmap, const char *city1, const char *city2) {
+    bool out = removeRoad(lockMapWrite(cmap), city1, city2);
+    unlockMap(cmap);
+    return out;
+}
+
+bool concurrentRemoveRoute(ConcurrentMap *cmap, unsigned routeId) {
+    bool out = removeRoute(lockMapWrite(cmap), routeId);
+    unlockMap(cmap);
+    return out;
+}
+
+char const *concurrentRouteDescription(ConcurrentMap *cmap, unsigned routeId) {
+    char const *out = getRouteDescription(lockMapRead(cmap), routeId);
+    unlockMap(cmap);
+    return out;
+}
@@ -0,0 +1,116 @@
+/** @file ConcurrentMap.h
+ *  Interface for the 'ConcurrentMap' class, which lets many threads
+ *  use a single Map. Queries share the map, while modifications
+ *  get exclusive access to it.
+ *
+ * @author Cezary Chodun
+ */
+
+#ifndef ConcurrentMap_h
+#define ConcurrentMap_h
+
+#include <stdbool.h>
+
+#include "map.h"
+#include "vector.h"
+
+/// @private
+typedef struct ConcurrentMap ConcurrentMap;
+
+/**
+    @brief
+        Wraps the map. From now on the map should be used
+        only through the ConcurrentMap.
+    @param[in] map - the map.
+    @return
+        A pointer to the ConcurrentMap or NULL if the
+        memory could not be allocated or the lock
+        could not be created.
+ */
+ConcurrentMap *newConcurrentMap(Map *map);
+
+/**
+    @brief
+        Frees the ConcurrentMap together with the map.
+        No thread may use it at the time.
+ */
+void deleteConcurrentMap(ConcurrentMap *cmap);
+
+/**
+    @brief
+        Gives the map for reading. Many threads can read
+        the map at once. Has to be followed by @ref unlockMap.
+    @return
+        The map.
+ */
+Map *lockMapRead(ConcurrentMap *cmap);
+
+/**
+    @brief
+        Gives the map for modification. Waits until no other
+        thread uses the map. Has to be followed by @ref unlockMap.
+    @return
+        The map.
+ */
+Map *lockMapWrite(ConcurrentMap *cmap);
+
+/**
+    @brief
+        Releases the map taken with @ref lockMapRead or @ref lockMapWrite.
+ */
+void unlockMap(ConcurrentMap *cmap);
+
+/**
+    @brief
+        Thread safe version of @ref addRoad.
+ */
+bool concurrentAddRoad(ConcurrentMap *cmap, const char *city1, const char *city2,
+                       unsigned length, int builtYear);
+
+/**
+    @brief
+        Thread safe version of @ref repairRoad.
+ */
+bool concurrentRepairRoad(ConcurrentMap *cmap, const char *city1, const char *city2,
+                          int repairYear);
+
+/**
+    @brief
+        Thread safe version of @ref newRoute.
+ */
+bool concurrentNewRoute(ConcurrentMap *cmap, unsigned routeId,
+                        const char *city1, const char *city2);
+
+/**
+    @brief
+        Thread safe version of @ref exactRoute.
+ */
+bool concurrentExactRoute(ConcurrentMap *cmap, unsigned num, vector *cityNames,
+                          vector *roadLengths, vector *roadBuiltYears);
+
+/**
+    @brief
+        Thread safe version of @ref extendRoute.
+ */
+bool concurrentExtendRoute(ConcurrentMap *cmap, unsigned routeId, const char *city);
+
+/**
+    @brief
+        Thread safe version of @ref removeRoad.
+ */
+bool concurrentRemoveRoad(ConcurrentMap *cmap, const char *city1, const char *city2);
+
+/**
+    @brief
+        Thread safe version of @ref removeRoute.
+ */
+bool concurrentRemoveRoute(ConcurrentMap *cmap, unsigned routeId);
+
+/**
+    @brief
+        Thread safe version of @ref getRouteDescription.
+        Does not wait for other threads which read the map.
+ */
+char const *concurrentRouteDescription(ConcurrentMap *cmap, unsigned routeId);
+
+#endif /* ConcurrentMap_h */
@@ -0,0 +1,654 @@
+/** @file Journal.c
+ *  Write-ahead journal of the map modifications.
+ *
+ *  Journal file layout: magic "BLNJ", version(1 byte), records.
+ *  Record layout: size of the payload(4 bytes), checksum of
+ *  the payload(4 bytes), payload.
+ *  Payload layout: lsn(varint), operation(1 byte),
+ *  number of arguments(varint), arguments except the first one.
+ *  Names are stored as strings, lengths and route ids as
+ *  unsigned varints and years as signed varints.
+ *
+ * @author Cezary Chodun
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "Journal.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+#include "ByteBuffer.h"
+#include "MapParser.h"
+#include "Snapshot.h"
+#include "Text.h"
+
+/// @private
+static const char JOURNAL_MAGIC[4] = {'B', 'L', 'N', 'J'};
+/// @private
+static const unsigned char JOURNAL_VERSION = 1;
+/// @private Size of the file header(magic, version).
+static const size_t JOURNAL_HEADER = 4 + 1;
+
+/// @private
+static const unsigned DEFAULT_GROUP_SIZE = 32;
+/// @private
+static const uint64_t DEFAULT_COMPACTION = 65536;
+
+/// @private Identifiers of the stored operations.
+enum {
+    OP_ADD_ROAD = 1,
+    OP_REPAIR_ROAD,
+    OP_NEW_ROUTE,
+    OP_EXTEND_ROUTE,
+    OP_REMOVE_ROAD,
+    OP_REMOVE_ROUTE,
+    OP_EXACT_ROUTE,
+    OP_BEGIN_TRANSACTION,
+    OP_COMMIT_TRANSACTION,
+    OP_ROLLBACK_TRANSACTION,
+    OP_COUNT
+};
+
+/// @private Names of the commands for each operation.
+static const char *OP_NAMES[OP_COUNT] = {
+    NULL,
+    "addRoad",
+    "repairRoad",
+    "newRoute",
+    "extendRoute",
+    "removeRoad",
+    "removeRoute",
+    NULL,
+    "beginTransaction",
+    "commitTransaction",
+    "rollbackTransaction"
+};
+
+/// @private Types of the arguments('S' - name, 'U' - unsigned, 'I' - int).
+static const char *OP_ARGS[OP_COUNT] = {
+    NULL,
+    "SSUI",
+    "SSI",
+    "USS",
+    "US",
+    "SS",
+    "U",
+    NULL,
+    "",
+    "",
+    ""
+};
+
+/// Journal of the map modifications.
+typedef struct Journal{
+    /// Path of the snapshot.
+    char *snapPath;
+    /// Path of the current journal file.
+    char *journalPath;
+    /// Path of the journal file which is being compacted.
+    char *oldPath;
+    /// Descriptor of the current journal file.
+    int fd;
+    /// Records which were not written yet.
+    ByteBuffer *pending;
+    /// Number of the records in 'pending'.
+    unsigned pendingRecords;
+    /// Number of the records written at once.
+    unsigned groupSize;
+    /// Number of the next record.
+    uint64_t nextLsn;
+    /// Number of the records after which the journal is compacted.
+    uint64_t compaction;
+    /// Number of the records since the last compaction.
+    uint64_t sinceCompaction;
+    /// Whether the records end in an open transaction, which defers the compaction.
+    bool transaction;
+    /// Whether the compaction thread was started and not joined.
+    bool compacting;
+    /// The compaction thread.
+    pthread_t compactor;
+    /// Set by the compaction thread when it finishes.
+    atomic_bool compactionDone;
+}Journal;
+
+/// @private
+static char *joinPath(const char *prefix, const char *suffix) {
+    size_t size = strlen(prefix);
+    char *out = (char*) malloc(size + strlen(suffix) + 1);
+    if (out == NULL)
+        return NULL;
+
+    memcpy(out, prefix, size);
+    strcpy(out + size, suffix);
+    return out;
+}
+
+/// @private
+static int operationOf(Text *cmd) {
+    unsigned tmp;
+    if (toUIntVal(cmd, &tmp))
+        return OP_EXACT_ROUTE;
+
+    for (int op = OP_ADD_ROAD; op < OP_COUNT; op++)
+        if (OP_NAMES[op] != NULL && equalsC(cmd, OP_NAMES[op]))
+            return op;
+
+    return 0;//Command does not modify the map
+}
+
+/// @private Type of the argument 'i'(i > 0) of the operation.
+static char argumentType(int op, int i) {
+    if (op == OP_EXACT_ROUTE) {
+        if (i%3 == 1)
+            return 'S';
+        return i%3 == 2 ? 'U' : 'I';
+    }
+
+    return OP_ARGS[op][i - 1];
+}
+
+/// @private
+static bool validArgumentCount(int op, uint64_t count) {
+    if (op == OP_EXACT_ROUTE)
+        return count >= 5 && count%3 == 2;
+    return count == strlen(OP_ARGS[op]) + 1;
+}
+
+/// @private
+static bool encodeCommand(ByteBuffer *out, uint64_t lsn, int op, vector *args) {
+    bool err = (putVarUInt(out, lsn) == NULL);
+    err = err || putByte(out, (unsigned char) op) == NULL;
+    err = err || putVarUInt(out, (uint64_t) vecSize(args)) == NULL;
+
+    unsigned uval;
+    int ival;
+    if (op == OP_EXACT_ROUTE) {
+        err = err || !toUIntVal(getVec(args, 0), &uval);
+        err = err || putVarUInt(out, uval) == NULL;
+    }
+
+    for (int i = 1; i < vecSize(args) && !err; i++) {
+        Text *arg = getVec(args, i);
+        char type = argumentType(op, i);
+
+        if (type == 'U') {
+            err = !toUIntVal(arg, &uval) || putVarUInt(out, uval) == NULL;
+        }
+        else if (type == 'I') {
+            err = !toIntVal(arg, &ival) || putVarInt(out, ival) == NULL;
+        }
+        else {
+            char *name = to_cString(arg);
+            err = (name == NULL || putString(out, name) == NULL);
+            free(name);
+        }
+    }
+
+    return !err;
+}
+
+/// @private
+static void destroyArgs(vector *args) {
+    for (int i = 0; i < vecSize(args); i++)
+        destroyText(getVec(args, i));
+    destroyVec(args);
+}
+
+/// @private Reads the argument and appends it to 'args' as a text.
+static bool decodeArgument(ByteReader *in, char type, vector *args) {
+    Text *arg = NULL;
+    uint64_t uval;
+    int64_t ival;
+    char *name;
+
+    if (type == 'U') {
+        if (getVarUInt(in, &uval) && uval <= UINT32_MAX
+            && (arg = newText("")) != NULL)
+            appendUInt(arg, (unsigned) uval);
+    }
+    else if (type == 'I') {
+        if (getVarInt(in, &ival) && ival >= INT32_MIN && ival <= INT32_MAX
+            && (arg = newText("")) != NULL)
+            appendInt(arg, (int) ival);
+    }
+    else if (getString(in, &name)) {
+        arg = newText(name);
+        free(name);
+    }
+
+    if (arg == NULL)
+        return false;
+    if (pushBackVec(args, arg) == NULL) {
+        destroyText(arg);
+        return false;
+    }
+    return true;
+}
+
+/// @private Executes the command stored in the record payload.
+static bool replayCommand(Map *map, ByteReader *in, uint64_t after, uint64_t *lsn) {
+    unsigned char op;
+    uint64_t count;
+
+    if (!getVarUInt(in, lsn) || !getByte(in, &op) || !getVarUInt(in, &count))
+        return false;
+    if (op < OP_ADD_ROAD || op >= OP_COUNT || !validArgumentCount(op, count))
+        return false;
+    if (lsn[0] <= after)
+        return true;//Already included in the snapshot
+
+    vector *args = newVec((int) count);
+    if (args == NULL)
+        return false;
+
+    bool err;
+    if (op == OP_EXACT_ROUTE)
+        err = !decodeArgument(in, 'U', args);
+    else {
+        Text *cmd = newText((char*) OP_NAMES[op]);
+        err = (cmd == NULL || pushBackVec(args, cmd) == NULL);
+        if (err)
+            destroyText(cmd);
+    }
+
+    for (uint64_t i = 1; i < count && !err; i++)
+        err = !decodeArgument(in, argumentType(op, (int) i), args);
+
+    if (!err && in->pos != in->size)
+        err = true;//Unexpected data
+
+    if (!err) {
+        switch (op) {
+            case OP_ADD_ROAD:
+                err = !addRoadFoo(map, args);
+                break;
+            case OP_REPAIR_ROAD:
+                err = !repairRoadFoo(map, args);
+                break;
+            case OP_NEW_ROUTE:
+                err = !newRouteFoo(map, args);
+                break;
+            case OP_EXTEND_ROUTE:
+                err = !extendRouteFoo(map, args);
+                break;
+            case OP_REMOVE_ROAD:
+                err = !removeRoadFoo(map, args);
+                break;
+            case OP_REMOVE_ROUTE:
+                err = !removeRouteFoo(map, args);
+                break;
+            case OP_BEGIN_TRANSACTION:
+                err = !beginTransactionFoo(map, args);
+                break;
+            case OP_COMMIT_TRANSACTION:
+                //A commit is journaled also when it failed and rolled the changes back
+                err = !inTransaction(map);
+                commitTransactionFoo(map, args);
+                break;
+            case OP_ROLLBACK_TRANSACTION:
+                err = !rollbackTransactionFoo(map, args);
+                break;
+            default:
+                err = !exactRouteFoo(map, args);
+                break;
+        }
+    }
+
+    destroyArgs(args);
+    return !err;
+}
+
+/**
+    @private
+    @brief
+        Executes the commands stored in the journal file
+        with numbers greater than 'after'.
+        Stops at the first incomplete or damaged record.
+    @param[in] path       - path of the journal file;
+    @param[in] map        - the map;
+    @param[in] after      - number of the last executed record;
+    @param[out] lastLsn   - number of the last record in the file;
+    @param[out] validSize - size of the correct part of the file
+                            (0 if the file does not exist or
+                            has no header).
+    @return
+        @p false if the file could not be read or one of the
+        commands failed and @p true otherwise.
+ */
+static bool replayJournalFile(const char *path, Map *map, uint64_t after,
+                              uint64_t *lastLsn, size_t *validSize) {
+    validSize[0] = 0;
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return errno == ENOENT;
+
+    ByteBuffer *data = newByteBuffer(1 << 16);
+    bool err = (data == NULL || !readByteBuffer(data, fd));
+    close(fd);
+    if (err) {
+        destroyByteBuffer(data);
+        return false;
+    }
+
+    ByteReader in;
+    initByteReader(&in, byteBufferData(data), byteBufferSize(data));
+    if (in.size < JOURNAL_HEADER) {
+        destroyByteBuffer(data);
+        return true;//The header was not written completely
+    }
+
+    unsigned char version;
+    for (int i = 0; i < 4; i++) {
+        unsigned char c;
+        getByte(&in, &c);
+        err |= (c != (unsigned char) JOURNAL_MAGIC[i]);
+    }
+    getByte(&in, &version);
+    err |= (version != JOURNAL_VERSION);
+
+    validSize[0] = in.pos;
+    while (!err) {
+        uint32_t size, checksum;
+        if (!getU32(&in, &size) || !getU32(&in, &checksum))
+            break;//Incomplete record header
+        if (size > in.size - in.pos)
+            break;//Incomplete record
+        if (checksum != checksumBytes(in.data + in.pos, size))
+            break;//Damaged record
+
+        ByteReader payload;
+        initByteReader(&payload, in.data + in.pos, size);
+        uint64_t lsn;
+        err = !replayCommand(map, &payload, after, &lsn);
+        if (!err && lsn > lastLsn[0])
+            lastLsn[0] = lsn;
+
+        in.pos += size;
+        validSize[0] = in.pos;
+    }
+
+    destroyByteBuffer(data);
+    return !err;
+}
+
+/// @private Reads the snapshot or creates an empty map if there is none.
+static Map *loadSnapshot(const char *path, uint64_t *lsn) {
+    lsn[0] = 0;
+    if (access(path, F_OK) != 0)
+        return errno == ENOENT ? newMap() : NULL;
+
+    return readSnapshot(path, lsn);
+}
+
+/// @private Body of the compaction thread.
+static void *compactJournal(void *arg) {
+    Journal *journal = (struct Journal*) arg;
+
+    uint64_t lsn;
+    size_t size;
+    Map *map = loadSnapshot(journal->snapPath, &lsn);
+    bool err = (map == NULL);
+
+    err = err || !replayJournalFile(journal->oldPath, map, lsn, &lsn, &size);
+    err = err || !writeSnapshot(map, journal->snapPath, lsn);
+    if (!err) {
+        unlink(journal->oldPath);
+        syncDirectoryOf(journal->oldPath);
+    }
+
+    deleteMap(map);
+    atomic_store(&journal->compactionDone, true);
+    return NULL;
+}
+
+/// @private Opens the current journal file and cuts off its damaged end.
+static bool openJournalFile(Journal *journal, size_t validSize) {
+    journal->fd = open(journal->journalPath, O_WRONLY | O_CREAT, 0644);
+    if (journal->fd < 0)
+        return false;
+
+    bool err = (ftruncate(journal->fd, (off_t) validSize) != 0);
+    err = err || lseek(journal->fd, 0, SEEK_END) < 0;
+
+    if (!err && validSize == 0) {
+        ByteBuffer *header = newByteBuffer(JOURNAL_HEADER);
+        err = (header == NULL);
+        err = err || putBytes(header, JOURNAL_MAGIC, 4) == NULL;
+        err = err || putByte(header, JOURNAL_VERSION) == NULL;
+        err = err || !writeByteBuffer(header, journal->fd);
+        destroyByteBuffer(header);
+    }
+
+    err = err || fsync(journal->fd) != 0;
+    err = err || !syncDirectoryOf(journal->journalPath);
+    return !err;
+}
+
+/// @private Writes the gathered records and flushes them to the disk.
+static bool flushJournal(Journal *journal) {
+    if (journal->pendingRecords == 0)
+        return true;
+
+    if (!writeByteBuffer(journal->pending, journal->fd)
+        || fdatasync(journal->fd) != 0)
+        return false;
+
+    clearByteBuffer(journal->pending);
+    journal->pendingRecords = 0;
+    return true;
+}
+
+/**
+    @private
+    @brief
+        Starts folding the journal into a new snapshot.
+        The current journal file becomes the old one and
+        the new records go to a fresh file. If the old file
+        remains from an unfinished compaction it is folded
+        first, and the current file is left as it is.
+ */
+static bool startCompaction(Journal *journal) {
+    if (journal->compacting) {
+        if (!atomic_load(&journal->compactionDone))
+            return true;//Previous compaction is still running
+
+        pthread_join(journal->compactor, NULL);
+        journal->compacting = false;
+    }
+
+    if (access(journal->oldPath, F_OK) != 0) {
+        if (!flushJournal(journal))
+            return false;
+
+        close(journal->fd);
+        journal->fd = -1;
+        if (rename(journal->journalPath, journal->oldPath) != 0)
+            return false;
+        if (!openJournalFile(journal, 0))
+            return false;
+    }
+
+    journal->sinceCompaction = 0;
+    atomic_store(&journal->compactionDone, false);
+    if (pthread_create(&journal->compactor, NULL, compactJournal, journal) != 0)
+        return true;//The compaction will be retried later
+
+    journal->compacting = true;
+    return true;
+}
+
+/// @private
+static void destroyJournal(Journal *journal) {
+    if (journal->fd >= 0)
+        close(journal->fd);
+
+    free(journal->snapPath);
+    free(journal->journalPath);
+    free(journal->oldPath);
+    destroyByteBuffer(journal->pending);
+    free(journal);
+}
+
+/**
+    @private
+    @brief
+        Rolls back the transaction which was not finished when
+        the journal was written for the last time, and stores
+        the rollback, so that the next records are replayed
+        outside of the transaction.
+ */
+static bool closeInterruptedTransaction(Journal *journal, Map *map) {
+    rollbackTransaction(map);
+
+    vector *args = newVec(1);
+    Text *cmd = newText((char*) OP_NAMES[OP_ROLLBACK_TRANSACTION]);
+    bool err = (args == NULL || cmd == NULL || pushBackVec(args, cmd) == NULL);
+    if (err)
+        destroyText(cmd);
+
+    err = err || !journalCommand(journal, args);
+    err = err || !flushJournal(journal);
+    destroyArgs(args);
+    return !err;
+}
+
+Journal *openJournal(const char *prefix, Map **map) {
+    if (prefix == NULL || map == NULL)
+        return NULL;//Wrong parameters
+
+    Journal *out = (struct Journal*) malloc(sizeof(Journal));
+    if (out == NULL)
+        return NULL;
+
+    out->snapPath = joinPath(prefix, ".snap");
+    out->journalPath = joinPath(prefix, ".journal");
+    out->oldPath = joinPath(prefix, ".journal.old");
+    out->fd = -1;
+    out->pending = newByteBuffer(1 << 12);
+    out->pendingRecords = 0;
+    out->groupSize = DEFAULT_GROUP_SIZE;
+    out->compaction = DEFAULT_COMPACTION;
+    out->sinceCompaction = 0;
+    out->transaction = false;
+    out->compacting = false;
+    atomic_init(&out->compactionDone, false);
+
+    if (out->snapPath == NULL || out->journalPath == NULL
+        || out->oldPath == NULL || out->pending == NULL) {
+        destroyJournal(out);
+        return NULL;
+    }
+
+    uint64_t lsn, last;
+    size_t oldSize, validSize;
+    Map *recovered = loadSnapshot(out->snapPath, &lsn);
+    last = lsn;
+
+    bool err = (recovered == NULL);
+    err = err || !replayJournalFile(out->oldPath, recovered, lsn, &last, &oldSize);
+    err = err || !replayJournalFile(out->journalPath, recovered, lsn, &last, &validSize);
+    err = err || !openJournalFile(out, validSize);
+
+    if (err) {
+        deleteMap(recovered);
+        destroyJournal(out);
+        return NULL;
+    }
+
+    out->nextLsn = last + 1;
+    if (inTransaction(recovered) && !closeInterruptedTransaction(out, recovered)) {
+        deleteMap(recovered);
+        destroyJournal(out);
+        return NULL;
+    }
+
+    if (access(out->oldPath, F_OK) == 0)
+        startCompaction(out);
+
+    map[0] = recovered;
+    return out;
+}
+
+bool journalCommand(Journal *journal, vector *args) {
+    if (journal == NULL || args == NULL || vecSize(args) == 0)
+        return false;//Wrong parameters
+
+    int op = operationOf(getVec(args, 0));
+    if (op == 0)
+        return true;//Nothing to store
+    if (!validArgumentCount(op, (uint64_t) vecSize(args)))
+        return false;
+
+    ByteBuffer *payload = newByteBuffer(64);
+    if (payload == NULL)
+        return false;
+
+    bool err = !encodeCommand(payload, journal->nextLsn, op, args);
+    if (!err) {
+        size_t size = byteBufferSize(payload);
+        const unsigned char *data = byteBufferData(payload);
+        err = (putU32(journal->pending, (uint32_t) size) == NULL);
+        err = err || putU32(journal->pending, checksumBytes(data, size)) == NULL;
+        err = err || putBytes(journal->pending, data, size) == NULL;
+    }
+    destroyByteBuffer(payload);
+    if (err)
+        return false;
+
+    journal->nextLsn++;
+    journal->pendingRecords++;
+    journal->sinceCompaction++;
+    if (op == OP_BEGIN_TRANSACTION)
+        journal->transaction = true;
+    else if (op == OP_COMMIT_TRANSACTION || op == OP_ROLLBACK_TRANSACTION)
+        journal->transaction = false;
+
+    if (journal->pendingRecords >= journal->groupSize && !flushJournal(journal))
+        return false;
+
+    //The snapshot can not be written in the middle of a transaction
+    if (journal->compaction > 0 && journal->sinceCompaction >= journal->compaction
+        && !journal->transaction)
+        return startCompaction(journal);
+
+    return true;
+}
+
+void setJournalGroupSize(Journal *journal, unsigned records) {
+    journal->groupSize = (records == 0 ? 1 : records);
+}
+
+void setJournalCompaction(Journal *journal, uint64_t records) {
+    journal->compaction = records;
+}
+
+uint64_t journalLsn(Journal *journal) {
+    return journal->nextLsn - 1;
+}
+
+bool syncJournal(Journal *journal) {
+    if (journal == NULL)
+        return false;
+
+    return flushJournal(journal);
+}
+
+bool closeJournal(Journal *journal) {
+    if (journal == NULL)
+        return false;
+
+    bool ok = flushJournal(journal);
+    if (journal->compacting)
+        pthread_join(journal->compactor, NULL);
+
+    destroyJournal(journal);
+    return ok;
+}
@@ -0,0 +1,104 @@
+/** @file Journal.h
+ *  Interface for the 'Journal' class, which stores successful
+ *  map modifications so that the map can be recovered after
+ *  the program is restarted.
+ *
+ *  The journal uses three files with a common prefix:
+ *  prefix.snap        - the last snapshot of the map;
+ *  prefix.journal     - commands executed after the snapshot;
+ *  prefix.journal.old - commands which are being folded into
+ *                       a new snapshot.
+ *
+ * @author Cezary Chodun
+ */
+
+#ifndef Journal_h
+#define Journal_h
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "map.h"
+#include "vector.h"
+
+/// @private
+typedef struct Journal Journal;
+
+/**
+    @brief
+        Opens the journal and recovers the map from
+        the snapshot and the commands stored after it.
+        A partially written record at the end of the
+        journal is discarded.
+    @param[in] prefix - common prefix of the journal files;
+    @param[out] map   - the recovered map.
+    @return
+        A pointer to the journal or NULL if the files
+        could not be opened, are damaged or the memory
+        could not be allocated.
+ */
+Journal *openJournal(const char *prefix, Map **map);
+
+/**
+    @brief
+        Appends a successfully executed command to the journal.
+        Commands which do not modify the map are ignored.
+        Records are written to the disk in groups
+        (see @ref setJournalGroupSize), and every so often
+        the journal is folded into a new snapshot
+        in the background (see @ref setJournalCompaction).
+    @param[in] journal - the journal;
+    @param[in] args    - the command, as passed to the MapParser.
+    @return
+        @p true if the command was stored and
+        @p false otherwise.
+ */
+bool journalCommand(Journal *journal, vector *args);
+
+/**
+    @brief
+        Sets the number of records which are gathered
+        before they are written and flushed to the disk.
+        Value 1 makes every command durable on its own.
+ */
+void setJournalGroupSize(Journal *journal, unsigned records);
+
+/**
+    @brief
+        Sets the number of records after which the journal
+        is folded into a new snapshot.
+        Value 0 disables the compaction.
+ */
+void setJournalCompaction(Journal *journal, uint64_t records);
+
+/**
+    @brief
+        Returns the number of the last record stored in
+        the journal(including the records which were
+        not flushed yet).
+    @return
+        The number of the record, or 0 if there is none.
+ */
+uint64_t journalLsn(Journal *journal);
+
+/**
+    @brief
+        Writes every gathered record and flushes
+        the journal to the disk.
+    @return
+        @p true if the operation was successful and
+        @p false otherwise.
+ */
+bool syncJournal(Journal *journal);
+
+/**
+    @brief
+        Flushes the journal, waits for the running
+        compaction and frees the journal.
+    @return
+        @p true if every record was stored and
+        @p false otherwise.
+ */
+bool closeJournal(Journal *journal);
+
+#endif /* Journal_h */
@@ -0,0 +1,376 @@
+/** @file JourneyPlanner.c
+ *  Planning of the journeys on the routes, in rounds(RAPTOR).
+ *
+ *  The stops of all routes are kept in one array, route after route,
+ *  together with the distance of every stop from the start of its
+ *  route. Every city has the list of its stops, so the routes going
+ *  through a city are found without looking at the other routes.
+ *
+ *  Round k starts from the cities whose distance was improved in round
+ *  k - 1 and scans every route through them once in each direction,
+ *  from the first improved stop. While scanning, the best city to board
+ *  the route is carried along, so the whole route is labelled in one
+ *  pass over consecutive memory. The distances of every round are kept,
+ *  so the journey can be followed back from the target.
+ *
+ * @author Cezary Chodun
+ */
+
+#include "JourneyPlanner.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+
+#include "City.h"
+#include "Road.h"
+#include "Route.h"
+
+/// @private Distance of a city which was not reached.
+#define UNREACHED ULLONG_MAX
+
+/// Stops of the routes and the state of the last journey.
+typedef struct JourneyPlanner{
+    /// Number of the cities.
+    int cities;
+    /// Number of the routes.
+    int routes;
+    /// Number of the stops of all routes.
+    int stops;
+
+    /// Number of every route.
+    unsigned *routeNumber;
+    /// First stop of every route, and the number of the stops at the end.
+    int *routeBegin;
+    /// City id of every stop.
+    int *stopCity;
+    /// Distance of every stop from the start of its route.
+    unsigned long long *stopDistance;
+    /// Route of every stop.
+    int *stopRoute;
+    /// First stop of every city in 'cityStops', and the number of the stops at the end.
+    int *cityBegin;
+    /// The stops of the cities, city after city.
+    int *cityStops;
+
+    /// Distances of the cities in every round, round after round.
+    unsigned long long *distance;
+    /// The stop where the route to the city was boarded in every round(-1 if none).
+    int *boarded;
+    /// Number of the rounds which fit in 'distance' and 'boarded'.
+    int roundCapacity;
+
+    /// Cities improved in the last round.
+    int *marked;
+    /// Number of the cities in 'marked'.
+    int markedCount;
+    /// Number of the round which marked the city last.
+    unsigned *markedRound;
+    /// Routes to scan in the current round.
+    int *scanned;
+    /// Number of the round which scans the route.
+    unsigned *scannedRound;
+    /// The first and the last improved stop of every scanned route.
+    int *firstStop, *lastStop;
+    /// Number of the last round of all journeys.
+    unsigned round;
+
+    /// The parts of the last journey.
+    PlannedLeg *legs;
+}JourneyPlanner;
+
+JourneyPlanner *newJourneyPlanner(void) {
+    JourneyPlanner *out = (struct JourneyPlanner*) calloc(1, sizeof(JourneyPlanner));
+    if (out == NULL)
+        return NULL;
+
+    return out;
+}
+
+/// @private Frees the stops and the state of the journeys.
+static void clearJourneyPlanner(JourneyPlanner *planner) {
+    free(planner->routeNumber);
+    free(planner->routeBegin);
+    free(planner->stopCity);
+    free(planner->stopDistance);
+    free(planner->stopRoute);
+    free(planner->cityBegin);
+    free(planner->cityStops);
+    free(planner->distance);
+    free(planner->boarded);
+    free(planner->marked);
+    free(planner->markedRound);
+    free(planner->scanned);
+    free(planner->scannedRound);
+    free(planner->firstStop);
+    free(planner->lastStop);
+    free(planner->legs);
+
+    memset(planner, 0, sizeof(JourneyPlanner));
+}
+
+void destroyJourneyPlanner(JourneyPlanner *planner) {
+    if (planner == NULL)
+        return;
+
+    clearJourneyPlanner(planner);
+    free(planner);
+}
+
+/// @private Allocates the arrays for the given numbers of the cities, routes and stops.
+static bool allocPlanner(JourneyPlanner *p, int cities, int routes, int stops) {
+    p->routeNumber = (unsigned*) malloc(sizeof(unsigned) * (routes + 1));
+    p->routeBegin = (int*) malloc(sizeof(int) * (routes + 1));
+    p->stopCity = (int*) malloc(sizeof(int) * (stops + 1));
+    p->stopDistance = (unsigned long long*) malloc(sizeof(unsigned long long) * (stops + 1));
+    p->stopRoute = (int*) malloc(sizeof(int) * (stops + 1));
+    p->cityBegin = (int*) calloc(cities + 1, sizeof(int));
+    p->cityStops = (int*) malloc(sizeof(int) * (stops + 1));
+    p->marked = (int*) malloc(sizeof(int) * (cities + 1));
+    p->markedRound = (unsigned*) calloc(cities + 1, sizeof(unsigned));
+    p->scanned = (int*) malloc(sizeof(int) * (routes + 1));
+    p->scannedRound = (unsigned*) calloc(routes + 1, sizeof(unsigned));
+    p->firstStop = (int*) malloc(sizeof(int) * (routes + 1));
+    p->lastStop = (int*) malloc(sizeof(int) * (routes + 1));
+    p->legs = (PlannedLeg*) malloc(sizeof(PlannedLeg) * (routes + 1));
+
+    return p->routeNumber != NULL && p->routeBegin != NULL && p->stopCity != NULL
+           && p->stopDistance != NULL && p->stopRoute != NULL && p->cityBegin != NULL
+           && p->cityStops != NULL && p->marked != NULL && p->markedRound != NULL
+           && p->scanned != NULL && p->scannedRound != NULL && p->firstStop != NULL
+           && p->lastStop != NULL && p->legs != NULL;
+}
+
+bool buildJourneyPlanner(JourneyPlanner *planner, vector *routes, int cities) {
+    if (planner == NULL || cities < 0)
+        return false;
+    clearJourneyPlanner(planner);
+
+    int routeCount = 0, stops = 0;
+    for (int i = 0; i < vecSize(routes); i++) {
+        Route *route = getVec(routes, i);
+        if (route != NULL && getHopCountRoute(route) > 0) {
+            routeCount++;
+            stops += getHopCountRoute(route) + 1;
+        }
+    }
+
+    if (!allocPlanner(planner, cities, routeCount, stops)) {
+        clearJourneyPlanner(planner);
+        return false;
+    }
+    planner->cities = cities;
+    planner->routes = routeCount;
+    planner->stops = stops;
+
+    //The stops of every route, from its start
+    int r = 0, s = 0;
+    for (int i = 0; i < vecSize(routes); i++) {
+        Route *route = getVec(routes, i);
+        if (route == NULL || getHopCountRoute(route) == 0)
+            continue;
+
+        vector *roads = getRouteRoads(route);
+        City *last = getRouteStart(route);
+        unsigned long long distance = 0;
+
+        planner->routeNumber[r] = getRouteNumber(route);
+        planner->routeBegin[r] = s;
+        for (int j = 0; j <= vecSize(roads); j++, s++) {
+            if (j > 0) {
+                Road *road = getVec(roads, j - 1);
+                distance += getRoadLength(road);
+                last = getConnectedCity(road, last);
+            }
+
+            planner->stopCity[s] = getCityID(last);
+            planner->stopDistance[s] = distance;
+            planner->stopRoute[s] = r;
+            planner->cityBegin[getCityID(last) + 1]++;
+        }
+        r++;
+    }
+    planner->routeBegin[r] = s;
+
+    //The stops of every city, sorted by counting
+    for (int i = 0; i < cities; i++)
+        planner->cityBegin[i + 1] += planner->cityBegin[i];
+    for (int i = 0; i < stops; i++)
+        planner->cityStops[planner->cityBegin[planner->stopCity[i]]++] = i;
+    for (int i = cities; i > 0; i--)
+        planner->cityBegin[i] = planner->cityBegin[i - 1];
+    planner->cityBegin[0] = 0;
+
+    return true;
+}
+
+int plannerCities(JourneyPlanner *planner) {
+    if (planner == NULL)
+        return 0;
+    return planner->cities;
+}
+
+/// @private Makes room for the distances of the rounds from 0 to 'round'.
+static bool growRounds(JourneyPlanner *planner, int round) {
+    if (round < planner->roundCapacity)
+        return true;
+
+    int capacity = (planner->roundCapacity == 0 ? 4 : planner->roundCapacity * 2);
+    size_t cities = (size_t) planner->cities;
+
+    unsigned long long *distance = (unsigned long long*)
+        realloc(planner->distance, sizeof(unsigned long long) * cities * capacity);
+    if (distance == NULL)
+        return false;
+    planner->distance = distance;
+
+    int *boarded = (int*) realloc(planner->boarded, sizeof(int) * cities * capacity);
+    if (boarded == NULL)
+        return false;
+    planner->boarded = boarded;
+
+    planner->roundCapacity = capacity;
+    return true;
+}
+
+/// @private Marks the city improved in the current round.
+static void markCity(JourneyPlanner *planner, int city) {
+    if (planner->markedRound[city] != planner->round) {
+        planner->markedRound[city] = planner->round;
+        planner->marked[planner->markedCount++] = city;
+    }
+}
+
+/// @private Finds the routes through the cities improved in the last round.
+static int collectRoutes(JourneyPlanner *planner) {
+    int count = 0;
+
+    for (int i = 0; i < planner->markedCount; i++) {
+        int city = planner->marked[i];
+
+        for (int j = planner->cityBegin[city]; j < planner->cityBegin[city + 1]; j++) {
+            int stop = planner->cityStops[j];
+            int route = planner->stopRoute[stop];
+
+            if (planner->scannedRound[route] != planner->round) {
+                planner->scannedRound[route] = planner->round;
+                planner->firstStop[route] = planner->lastStop[route] = stop;
+                planner->scanned[count++] = route;
+            }
+            else if (stop < planner->firstStop[route])
+                planner->firstStop[route] = stop;
+            else if (stop > planner->lastStop[route])
+                planner->lastStop[route] = stop;
+        }
+    }
+    planner->markedCount = 0;
+
+    return count;
+}
+
+/**
+    @private
+    @brief
+        Labels the stops of the route reached by boarding it at the
+        stops from 'first' in the direction 'step'(1 or -1).
+ */
+static void scanRoute(JourneyPlanner *planner, int route, int first, int step,
+                      unsigned long long *previous, unsigned long long *current, int *boarded) {
+    int end = (step > 0 ? planner->routeBegin[route + 1] : planner->routeBegin[route] - 1);
+    unsigned long long board = UNREACHED;
+    int boardStop = -1;
+
+    for (int stop = first; stop != end; stop += step) {
+        int city = planner->stopCity[stop];
+        unsigned long long arrival = UNREACHED;
+
+        if (boardStop != -1) {
+            unsigned long long a = planner->stopDistance[stop], b = planner->stopDistance[boardStop];
+            arrival = board + (a > b ? a - b : b - a);
+
+            if (arrival < current[city]) {
+                current[city] = arrival;
+                boarded[city] = boardStop;
+                markCity(planner, city);
+            }
+        }
+
+        //Boarding here is better if the rest of the journey is shorter
+        if (previous[city] < arrival) {
+            board = previous[city];
+            boardStop = stop;
+        }
+    }
+}
+
+/// @private Follows the journey back from the city 'to' reached in the 'round'.
+static int followJourney(JourneyPlanner *planner, int to, int round) {
+    size_t cities = (size_t) planner->cities;
+    int count = 0, city = to;
+
+    for (; round > 0; round--) {
+        int stop = planner->boarded[cities * round + city];
+        if (stop == -1)
+            continue;//Reached in an earlier round
+
+        PlannedLeg *leg = &planner->legs[count++];
+        leg->route = planner->routeNumber[planner->stopRoute[stop]];
+        leg->from = planner->stopCity[stop];
+        leg->to = city;
+        leg->length = planner->distance[cities * round + city]
+                      - planner->distance[cities * (round - 1) + leg->from];
+        city = leg->from;
+    }
+
+    for (int i = 0; i < count / 2; i++) {
+        PlannedLeg tmp = planner->legs[i];
+        planner->legs[i] = planner->legs[count - 1 - i];
+        planner->legs[count - 1 - i] = tmp;
+    }
+
+    return count;
+}
+
+int planJourneyPlanner(JourneyPlanner *planner, int from, int to, PlannedLeg **legs) {
+    if (planner == NULL || from < 0 || to < 0 || from >= planner->cities
+        || to >= planner->cities || legs == NULL)
+        return -1;
+    legs[0] = planner->legs;
+    if (!growRounds(planner, 1))
+        return -1;
+
+    size_t cities = (size_t) planner->cities;
+    for (size_t i = 0; i < cities; i++)
+        planner->distance[i] = UNREACHED;
+    planner->distance[from] = 0;
+
+    planner->round++;
+    planner->markedCount = 0;
+    markCity(planner, from);
+
+    //Every round uses one route more, so the first round reaching 'to' has the fewest routes
+    for (int round = 1; round <= planner->routes && planner->markedCount > 0; round++) {
+        if (!growRounds(planner, round))
+            return -1;
+
+        unsigned long long *previous = planner->distance + cities * (round - 1);
+        unsigned long long *current = planner->distance + cities * round;
+        int *boarded = planner->boarded + cities * round;
+        memcpy(current, previous, sizeof(unsigned long long) * cities);
+        memset(boarded, -1, sizeof(int) * cities);
+
+        int count = collectRoutes(planner);
+        planner->round++;
+
+        for (int i = 0; i < count; i++) {
+            int route = planner->scanned[i];
+            scanRoute(planner, route, planner->firstStop[route], 1, previous, current, boarded);
+            scanRoute(planner, route, planner->lastStop[route], -1, previous, current, boarded);
+        }
+
+        if (current[to] != UNREACHED)
+            return followJourney(planner, to, round);
+    }
+
+    return 0;
+}
@@ -0,0 +1,83 @@
+/** @file JourneyPlanner.h
+ *  Interface for the 'JourneyPlanner' class, which plans journeys
+ *  on the routes(bus lines) of the map. A journey goes along the
+ *  routes, in either direction, and changes the route only in
+ *  a city of both routes. Of the journeys with the fewest routes
+ *  the shortest one is chosen.
+ *
+ *  The planner keeps a copy of the stops of the routes, so it has
+ *  to be built again after the routes change.
+ *
+ * @author Cezary Chodun
+ */
+
+#ifndef JourneyPlanner_h
+#define JourneyPlanner_h
+
+#include <stdbool.h>
+
+#include "vector.h"
+
+/// @private
+typedef struct JourneyPlanner JourneyPlanner;
+
+/** A part of the journey along one route. */
+typedef struct PlannedLeg{
+    /// Number of the route.
+    unsigned route;
+    /// Id of the city where the route is boarded.
+    int from;
+    /// Id of the city where the route is left.
+    int to;
+    /// Length of the roads between the cities.
+    unsigned long long length;
+}PlannedLeg;
+
+/**
+    @brief
+        Creates an empty planner.
+    @return
+        A pointer to the planner or NULL if the
+        memory could not be allocated.
+ */
+JourneyPlanner *newJourneyPlanner(void);
+
+/**
+    @brief
+        Destroys the planner.
+ */
+void destroyJourneyPlanner(JourneyPlanner *planner);
+
+/**
+    @brief
+        Copies the stops of the 'routes'(see @ref Route, NULL
+        elements are omitted) to the planner.
+    @param[in] cities - number of the cities in the map, the ids of
+        the cities are smaller.
+    @return
+        @p true if the planner was built and @p false if the
+        memory could not be allocated(the planner is empty then).
+ */
+bool buildJourneyPlanner(JourneyPlanner *planner, vector *routes, int cities);
+
+/**
+    @brief
+        Returns the number of the cities given to
+        @ref buildJourneyPlanner.
+ */
+int plannerCities(JourneyPlanner *planner);
+
+/**
+    @brief
+        Plans the journey from the city 'from' to the city 'to'.
+        The routes are searched in rounds, round k finds the
+        shortest journeys with at most k routes.
+    @param[out] legs - the parts of the journey from 'from' to 'to',
+        valid until the next call.
+    @return
+        Number of the parts(0 if the journey is not possible)
+        or -1 if the memory could not be allocated.
+ */
+int planJourneyPlanner(JourneyPlanner *planner, int from, int to, PlannedLeg **legs);
+
+#endif /* JourneyPlanner_h */
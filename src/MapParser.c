@@ -7,6 +7,7 @@
 #include "MapParser.h"
 
 #include <stdlib.h>
+#include <limits.h>
 
 #include "Text.h"
 #include "map.h"
@@ -224,3 +225,300 @@ bool getRouteDescriptionFoo(Map *map, vector *args) {
     
     return !err;
 }
+
+bool getRepairStatsFoo(Map *map, vector *args) {
+    if (vecSize(args) != 1)
+        return false;   //Wrong amount of parameters
+
+    RepairStats stats = getRepairStats(map);
+    fprintf(stdout, "%llu;%llu;%llu;%llu\n", stats.local, stats.widened,
+            stats.global, stats.settled);
+
+    return true;
+}
+
+bool distanceMatrixFoo(Map *map, vector *args) {
+    if (vecSize(args) < 2)
+        return false;   //Wrong amount of parameters
+
+    bool err = false;
+
+    int n = vecSize(args) - 1;
+    char **cities = (char**) calloc(n, sizeof(char*));
+    if (cities == NULL)
+        return false;   //Failed to allocate memory
+
+    for (int i = 0; i < n && !err; i++)
+        err |= ((cities[i] = to_cString(getVec(args, i + 1))) == NULL);
+
+    RouteDistance *out = NULL;
+    if (!err)
+        out = distanceMatrix(map, (const char**) cities, n);
+
+    if (err || out == NULL)
+        err = true;
+    else
+        for (int i = 0; i < n; i++)
+            for (int j = i + 1; j < n; j++) {
+                RouteDistance *rd = &out[i * n + j];
+                fprintf(stdout, "%s;%s;%u;%d;%d\n", cities[i], cities[j],
+                        rd->length, rd->oldestRoad, rd->unique ? 1 : 0);
+            }
+
+    for (int i = 0; i < n; i++)
+        FREE(cities[i]);
+    free(cities);
+    FREE(out);
+
+    return !err;
+}
+
+bool getRouteLengthFoo(Map *map, vector *args) {
+    if (vecSize(args) != 2)
+        return false;   //Wrong amount of parameters
+
+    unsigned routeID;
+    if (!toUIntVal(getVec(args, 1), &routeID))
+        return false;
+
+    unsigned long long length = getRouteLength(map, routeID);
+    if (length == 0)
+        return false;   //The route does not exist
+
+    fprintf(stdout, "%u;%llu\n", routeID, length);
+    return true;
+}
+
+bool getRouteOldestYearFoo(Map *map, vector *args) {
+    if (vecSize(args) != 2)
+        return false;   //Wrong amount of parameters
+
+    unsigned routeID;
+    if (!toUIntVal(getVec(args, 1), &routeID))
+        return false;
+
+    int year = getRouteOldestYear(map, routeID);
+    if (year == 0)
+        return false;   //The route does not exist
+
+    fprintf(stdout, "%u;%d\n", routeID, year);
+    return true;
+}
+
+bool getRouteHopCountFoo(Map *map, vector *args) {
+    if (vecSize(args) != 2)
+        return false;   //Wrong amount of parameters
+
+    unsigned routeID;
+    if (!toUIntVal(getVec(args, 1), &routeID))
+        return false;
+
+    int count = getRouteHopCount(map, routeID);
+    if (count == 0)
+        return false;   //The route does not exist
+
+    fprintf(stdout, "%u;%d\n", routeID, count);
+    return true;
+}
+
+bool getCityRoutesFoo(Map *map, vector *args) {
+    if (vecSize(args) != 2)
+        return false;   //Wrong amount of parameters
+
+    char *city = to_cString(getVec(args, 1));
+    if (city == NULL)
+        return false;
+
+    int count;
+    unsigned *routes = getCityRoutes(map, city, &count);
+    bool ok = (routes != NULL);
+    if (ok) {
+        fprintf(stdout, "%s", city);
+        for (int i = 0; i < count; i++)
+            fprintf(stdout, ";%u", routes[i]);
+        fprintf(stdout, "\n");
+    }
+
+    free(city);
+    FREE(routes);
+
+    return ok;
+}
+
+bool planJourneyFoo(Map *map, vector *args) {
+    if (vecSize(args) != 3)
+        return false;   //Wrong amount of parameters
+
+    char *city1 = to_cString(getVec(args, 1));
+    char *city2 = to_cString(getVec(args, 2));
+
+    int count = 0;
+    JourneyLeg *legs = NULL;
+    if (city1 != NULL && city2 != NULL)
+        legs = planJourney(map, city1, city2, &count);
+
+    bool ok = (legs != NULL);
+    if (ok) {
+        for (int i = 0; i < count; i++)
+            fprintf(stdout, "%s;%u;%llu;", legs[i].from, legs[i].routeId, legs[i].length);
+        if (count > 0)
+            fprintf(stdout, "%s", legs[count - 1].to);
+        fprintf(stdout, "\n");
+    }
+
+    FREE(city1);
+    FREE(city2);
+    FREE(legs);
+
+    return ok;
+}
+
+bool kShortestRoutesFoo(Map *map, vector *args) {
+    if (vecSize(args) != 4)
+        return false;   //Wrong amount of parameters
+
+    unsigned k;
+    if (!toUIntVal(getVec(args, 3), &k) || k == 0 || k > INT_MAX)
+        return false;
+
+    char *city1 = to_cString(getVec(args, 1));
+    char *city2 = to_cString(getVec(args, 2));
+
+    int count = 0;
+    AlternativeRoute *routes = NULL;
+    if (city1 != NULL && city2 != NULL)
+        routes = kShortestRoutes(map, city1, city2, (int) k, &count);
+
+    bool ok = (routes != NULL);
+    if (ok) {
+        for (int i = 0; i < count; i++) {
+            fprintf(stdout, "%llu;%d", routes[i].length, routes[i].oldestYear);
+            for (int j = 0; j < routes[i].cityCount; j++)
+                fprintf(stdout, ";%s", routes[i].cities[j]);
+            fprintf(stdout, "\n");
+        }
+        if (count == 0)
+            fprintf(stdout, "\n");
+    }
+
+    FREE(city1);
+    FREE(city2);
+    FREE(routes);
+
+    return ok;
+}
+
+/// @private Prints the city found by @ref citiesWithin.
+static void printCityWithin(void *data, const char *city, unsigned distance) {
+    (void) data;
+    fprintf(stdout, "%s;%u\n", city, distance);
+}
+
+bool citiesWithinFoo(Map *map, vector *args) {
+    if (vecSize(args) != 3)
+        return false;   //Wrong amount of parameters
+
+    unsigned distance;
+    if (!toUIntVal(getVec(args, 2), &distance))
+        return false;
+
+    char *city = to_cString(getVec(args, 1));
+    bool ok = (city != NULL && citiesWithin(map, city, distance, &printCityWithin, NULL));
+
+    FREE(city);
+
+    return ok;
+}
+
+/// @private Writes the exported text to the standard output.
+static void writeExport(void *data, const char *text, size_t size) {
+    (void) data;
+    fwrite(text, 1, size, stdout);
+}
+
+bool exportRoutesFoo(Map *map, vector *args) {
+    if (vecSize(args) != 1)
+        return false;   //Wrong amount of parameters
+
+    return exportRoutes(map, &writeExport, NULL);
+}
+
+bool exportRoadsFoo(Map *map, vector *args) {
+    if (vecSize(args) != 1)
+        return false;   //Wrong amount of parameters
+
+    return exportRoads(map, &writeExport, NULL);
+}
+
+bool beginTransactionFoo(Map *map, vector *args) {
+    if (vecSize(args) != 1)
+        return false;   //Wrong amount of parameters
+
+    return beginTransaction(map);
+}
+
+bool commitTransactionFoo(Map *map, vector *args) {
+    if (vecSize(args) != 1)
+        return false;   //Wrong amount of parameters
+
+    return commitTransaction(map);
+}
+
+bool rollbackTransactionFoo(Map *map, vector *args) {
+    if (vecSize(args) != 1 || !inTransaction(map))
+        return false;   //Wrong amount of parameters or no transaction
+
+    rollbackTransaction(map);
+    return true;
+}
+
+bool setChangeLogFoo(Map *map, vector *args) {
+    if (vecSize(args) != 2)
+        return false;   //Wrong amount of parameters
+
+    unsigned capacity;
+    if (!toUIntVal(getVec(args, 1), &capacity))
+        return false;
+
+    return setChangeLog(map, capacity);
+}
+
+/// @private Names of the kinds of the changes(see @ref MapChangeKind).
+static const char *CHANGE_NAMES[] = {
+    "roadAdded",
+    "roadRemoved",
+    "roadRepaired",
+    "routeCreated",
+    "routeExtended",
+    "routeRepaired",
+    "routeRemoved"
+};
+
+/// @private Number of the changes read at once.
+#define CHANGES_READ 64
+
+bool getChangesFoo(Map *map, vector *args) {
+    if (vecSize(args) != 2)
+        return false;   //Wrong amount of parameters
+
+    unsigned cursor;
+    if (!toUIntVal(getVec(args, 1), &cursor))
+        return false;
+
+    unsigned long long next = cursor;
+    MapChange changes[CHANGES_READ];
+    int count;
+    while ((count = readChanges(map, &next, changes, CHANGES_READ)) > 0)
+        for (int i = 0; i < count; i++) {
+            MapChange *change = &changes[i];
+            fprintf(stdout, "%llu;%s;", change->sequence, CHANGE_NAMES[change->kind]);
+            if (change->routeId == 0)
+                fprintf(stdout, "%s;%s;%u;%d\n", change->city1, change->city2,
+                        change->length, change->year);
+            else
+                fprintf(stdout, "%u;%d;%d;%d\n", change->routeId, change->first,
+                        change->removed, change->added);
+        }
+
+    return count == 0;
+}
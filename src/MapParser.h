@@ -93,5 +93,187 @@ bool removeRouteFoo(Map *map, vector *args);
  */
 bool getRouteDescriptionFoo(Map *map, vector *args);
 
+/**
+ * @brief
+ *  Prints the statistics of the searches for the detours
+ *  (see @ref getRepairStats) in the format:
+ *  local;widened;global;settled.
+ * @param[in, out] map  - the map;
+ * @param[in] args      - a vector of arguments(Text).
+ * @return @p true if the operation was successful, and
+ *  @p false otherwise.
+ */
+bool getRepairStatsFoo(Map *map, vector *args);
+
+/**
+ * @brief
+ *  Prints the best routes between every pair of the cities given
+ *  in args(see @ref distanceMatrix), a pair in a line in the format:
+ *  city1;city2;length;oldestRoad;unique, where unique is 1 if
+ *  a route could be created and 0 otherwise. Cities which are
+ *  not connected have length and oldestRoad 0.
+ * @param[in, out] map  - the map;
+ * @param[in] args      - a vector of arguments(Text).
+ * @return @p true if the operation was successful, and
+ *  @p false otherwise.
+ */
+bool distanceMatrixFoo(Map *map, vector *args);
+
+/**
+ * @brief
+ *  Prints the length of the route(see @ref getRouteLength)
+ *  in the format: id;length.
+ * @param[in, out] map  - the map;
+ * @param[in] args      - a vector of arguments(Text).
+ * @return @p true if the operation was successful, and
+ *  @p false otherwise(also if the route does not exist).
+ */
+bool getRouteLengthFoo(Map *map, vector *args);
+
+/**
+ * @brief
+ *  Prints the year of the oldest road of the route
+ *  (see @ref getRouteOldestYear) in the format: id;year.
+ * @param[in, out] map  - the map;
+ * @param[in] args      - a vector of arguments(Text).
+ * @return @p true if the operation was successful, and
+ *  @p false otherwise(also if the route does not exist).
+ */
+bool getRouteOldestYearFoo(Map *map, vector *args);
+
+/**
+ * @brief
+ *  Prints the number of the roads of the route
+ *  (see @ref getRouteHopCount) in the format: id;count.
+ * @param[in, out] map  - the map;
+ * @param[in] args      - a vector of arguments(Text).
+ * @return @p true if the operation was successful, and
+ *  @p false otherwise(also if the route does not exist).
+ */
+bool getRouteHopCountFoo(Map *map, vector *args);
+
+/**
+ * @brief
+ *  Prints the numbers of the routes going through the city
+ *  (see @ref getCityRoutes) in the format: city;id;id;...;id.
+ * @param[in, out] map  - the map;
+ * @param[in] args      - a vector of arguments(Text).
+ * @return @p true if the operation was successful, and
+ *  @p false otherwise(also if the city does not exist).
+ */
+bool getCityRoutesFoo(Map *map, vector *args);
+
+/**
+ * @brief
+ *  Prints the journey between the cities(see @ref planJourney) in
+ *  the format: city;routeId;length;city;...;routeId;length;city,
+ *  where every route is followed from the city before it to the
+ *  city after it, or an empty line if there is no journey.
+ * @param[in, out] map  - the map;
+ * @param[in] args      - a vector of arguments(Text).
+ * @return @p true if the operation was successful, and
+ *  @p false otherwise.
+ */
+bool planJourneyFoo(Map *map, vector *args);
+
+/**
+ * @brief
+ *  Prints at most k shortest routes between the cities(see
+ *  @ref kShortestRoutes), one in every line, in the format:
+ *  length;oldestYear;city;city;...;city, or an empty line if
+ *  the cities are not connected. The arguments are: city1;city2;k.
+ * @param[in, out] map  - the map;
+ * @param[in] args      - a vector of arguments(Text).
+ * @return @p true if the operation was successful, and
+ *  @p false otherwise.
+ */
+bool kShortestRoutesFoo(Map *map, vector *args);
+
+/**
+ * @brief
+ *  Prints the cities not further than the distance from the city
+ *  (see @ref citiesWithin), nearest first, one in every line, in
+ *  the format: city;distance. The arguments are: city;distance.
+ * @param[in, out] map  - the map;
+ * @param[in] args      - a vector of arguments(Text).
+ * @return @p true if the operation was successful, and
+ *  @p false otherwise(also if the city does not exist).
+ */
+bool citiesWithinFoo(Map *map, vector *args);
+
+/**
+ * @brief
+ *  Prints the descriptions of all routes(see @ref exportRoutes),
+ *  one in every line.
+ * @param[in, out] map  - the map;
+ * @param[in] args      - a vector of arguments(Text).
+ * @return @p true if the operation was successful, and
+ *  @p false otherwise.
+ */
+bool exportRoutesFoo(Map *map, vector *args);
+
+/**
+ * @brief
+ *  Prints all roads(see @ref exportRoads), one in every line,
+ *  in the format: city1;city2;length;year.
+ * @param[in, out] map  - the map;
+ * @param[in] args      - a vector of arguments(Text).
+ * @return @p true if the operation was successful, and
+ *  @p false otherwise.
+ */
+bool exportRoadsFoo(Map *map, vector *args);
+
+/**
+ * @brief
+ *  Starts the transaction(see @ref beginTransaction).
+ * @param[in, out] map  - the map;
+ * @param[in] args      - a vector of arguments(Text).
+ * @return @p true if the operation was successful, and
+ *  @p false otherwise.
+ */
+bool beginTransactionFoo(Map *map, vector *args);
+
+/**
+ * @brief
+ *  Commits the transaction(see @ref commitTransaction).
+ * @param[in, out] map  - the map;
+ * @param[in] args      - a vector of arguments(Text).
+ * @return @p true if the operation was successful, and
+ *  @p false otherwise(also if the transaction was rolled back).
+ */
+bool commitTransactionFoo(Map *map, vector *args);
+
+/**
+ * @brief
+ *  Rolls the transaction back(see @ref rollbackTransaction).
+ * @param[in, out] map  - the map;
+ * @param[in] args      - a vector of arguments(Text).
+ * @return @p true if the operation was successful, and
+ *  @p false otherwise(also if there is no transaction).
+ */
+bool rollbackTransactionFoo(Map *map, vector *args);
+
+/**
+ * @brief
+ *  Sets the number of the changes kept by the map(see @ref setChangeLog).
+ * @param[in, out] map  - the map;
+ * @param[in] args      - a vector of arguments(Text).
+ * @return @p true if the operation was successful, and
+ *  @p false otherwise.
+ */
+bool setChangeLogFoo(Map *map, vector *args);
+
+/**
+ * @brief
+ *  Prints the changes after the given one(see @ref readChanges), one in
+ *  every line, in the format: number;kind;city1;city2;length;year for the
+ *  roads and number;kind;routeId;first;removed;added for the routes.
+ * @param[in, out] map  - the map;
+ * @param[in] args      - a vector of arguments(Text).
+ * @return @p true if the operation was successful, and
+ *  @p false otherwise(also if some of the changes were overwritten).
+ */
+bool getChangesFoo(Map *map, vector *args);
+
 
 #endif /* MapParser_h */
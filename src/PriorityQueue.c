@@ -78,28 +78,24 @@ void destroyPriorityQueue(PriorityQueue *queue) {
 static void *containsNode(Node *node, void *val, void (*comparator)(void *a, void *b, int *ret)){
     if (node == NULL)
         return NULL;
-    Node *next = node;
-    
-    while (next->val != val){
-        int cmp;
-        comparator(next->val, val, &cmp);
-        
-        if (cmp == 0)
-            break;
-        else if (cmp == 1)
-            next = next->left;
-        else
-            next = next->right;
-        
-        if (next == NULL)
-            return NULL;
-    }
-    
-    return next->val;
+
+    int cmp;
+    comparator(node->val, val, &cmp);
+    if (cmp == 0)
+        return node->val;
+    if (cmp == 1)
+        return NULL;//Every value in the subtree is bigger
+
+    void *out = containsNode(node->left, val, comparator);
+    if (out != NULL)
+        return out;
+    return containsNode(node->right, val, comparator);
 }
 
 /// @private
 static void *addNode(Node *node, void *val, void (*comparator)(void *a, void *b, int *ret)) {
+    node->size++;
+
     void *next = val;
     int cmp = 0;
     comparator(node->val, val, &cmp);
@@ -124,32 +120,32 @@ static void *addNode(Node *node, void *val, void (*comparator)(void *a, void *b,
 
 /// @private
 static void fixChildren(Node *node) {
-    if (node->left == NULL) {
-        if (node->right == NULL)
-            return;
-        if (node->right->val == NULL) {
-            freeNode(node->right);
-            node->right = NULL;
-        }
+    if (node->left != NULL && node->left->val == NULL) {
+        freeNode(node->left);
+        node->left = NULL;
     }
-    else {
-        if (node->left->val == NULL) {
-            freeNode(node->left);
-            node->left = NULL;
-        }
+    if (node->right != NULL && node->right->val == NULL) {
+        freeNode(node->right);
+        node->right = NULL;
     }
 }
 
 /// @private
 static void *popValueNode(Node *node, void (*comparator)(void *a, void *b, int *ret)) {
     assert(node != NULL);
+    node->size--;
     Node *next = node->left;
 
+    int cmp = 0;
     if (node->left == NULL)
         next = node->right;
     else if (node->right == NULL);
-    else if (node->left->size < node->right->size)
-        next = node->right;
+    else {
+        //The smaller value has to go up to keep the heap order
+        comparator(node->left->val, node->right->val, &cmp);
+        if (cmp == 1)
+            next = node->right;
+    }
 
     void *out = node->val;
     if (next == NULL)
@@ -8,6 +8,8 @@
 
 #include <stdlib.h>
 
+#include "Route.h"
+
 /**
     Data structure that contains
     information about the road.
@@ -18,7 +20,7 @@ typedef struct Road{
     /// Citi connected by the road.
     City *b;
     
-    /// Routes that go through the road.
+    /// Routes that go through the road(NULL until the first route).
     vector *routes;
 
     /// The road build year.
@@ -36,11 +38,7 @@ Road *newRoad(City *a, City *b, int year, int length) {
     out->b = b;
     out->year = year;
     out->length = length;
-    out->routes = newVec(0);
-    if (out->routes == NULL) {
-        free(out);
-        return NULL;
-    }
+    out->routes = NULL;//Most roads are not used by any route
 
     return out;
 }
@@ -80,6 +78,8 @@ City *firstDifferentCityRoad(Road *road1, Road *road2) {
 }
 
 void addRouteRoad(Road *road, Route *route) {
+    if (road->routes == NULL && (road->routes = newVec(0)) == NULL)
+        return;
     pushBackVec(road->routes, route);
 }
 
@@ -94,7 +94,8 @@ vector *getRoutesRoad(Road *road) {
 }
 
 void clearRoutesRoad(Road *road) {
-    resetVec(road->routes);
+    if (road->routes != NULL)
+        resetVec(road->routes);
 }
 
 City *getConnectedCity(Road *road, City *from) {
@@ -114,7 +115,12 @@ int getRoadYear(Road *road) {
 }
 
 void setRoadYear(Road *road, int year) {
+    int old = road->year;
     road->year = year;
+
+    //The descriptions and the oldest years of the routes contain the year
+    for (int i = 0; i < vecSize(road->routes); i++)
+        changeYearRoute(getVec(road->routes, i), old, year);
 }
 
 int getRoadLength(Road *road) {
@@ -79,7 +79,8 @@ void clearRoutesRoad(Road *road);
     @brief
         Returns the routes that uses the road.
     @return
-        Pointer to the routes vector.
+        Pointer to the routes vector(NULL if no route
+        used the road yet).
  */
 vector *getRoutesRoad(Road *road);
 
@@ -101,7 +102,8 @@ int getRoadYear(Road *road);
 
 /**
     @brief
-        Sets the road repair year.
+        Sets the road repair year and marks the routes
+        which go through the road as modified.
  */
 void setRoadYear(Road *road, int year);
 
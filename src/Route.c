@@ -8,6 +8,8 @@
 
 #include <stdlib.h>
 #include <assert.h>
+#include <stdatomic.h>
+#include <limits.h>
 
 #include "Road.h"
 
@@ -25,19 +27,107 @@ typedef struct Route{
     City *start;
     ///The last city in the route.
     City *end;
+    ///Stamp of the last modification(unique among all routes).
+    unsigned long long version;
+
+    ///Sum of the lengths of the roads.
+    unsigned long long length;
+    ///The smallest year of the roads(INT_MAX without roads).
+    int oldestYear;
+    ///Number of the roads with the year 'oldestYear'.
+    int oldestCount;
+
+    ///The stored description(NULL if there is none).
+    char *description;
+    ///Length of the description.
+    size_t descriptionSize;
+    ///Stamp of the route when the description was made.
+    unsigned long long descriptionVersion;
 }Route;
 
+/// @private Source of the modification stamps, shared by every map.
+static atomic_ullong lastVersion = 0;
+
+void touchRoute(Route *route) {
+    route->version = atomic_fetch_add(&lastVersion, 1) + 1;
+}
+
+unsigned long long getRouteVersion(Route *route) {
+    return route->version;
+}
+
+unsigned long long lastRouteVersion(void) {
+    return atomic_load(&lastVersion);
+}
+
+/// @private Adds the cities of the road to the routes of the cities.
+static void addRoadCities(Route *route, Road *road) {
+    City *a = getAnyCityFromRoad(road);
+    addRouteCity(a, route);
+    addRouteCity(getConnectedCity(road, a), route);
+}
+
+/// @private Removes the cities of the road from the routes of the cities.
+static void removeRoadCities(Route *route, Road *road) {
+    City *a = getAnyCityFromRoad(road);
+    removeRouteCity(a, route);
+    removeRouteCity(getConnectedCity(road, a), route);
+}
+
+/// @private Counts the length and the oldest year of all roads of the route.
+static void sumRoadsRoute(Route *route) {
+    route->length = 0;
+    route->oldestYear = INT_MAX;
+    route->oldestCount = 0;
+
+    for (int i = 0; i < vecSize(route->roads); i++) {
+        Road *road = getVec(route->roads, i);
+        route->length += getRoadLength(road);
+
+        if (getRoadYear(road) < route->oldestYear) {
+            route->oldestYear = getRoadYear(road);
+            route->oldestCount = 0;
+        }
+        if (getRoadYear(road) == route->oldestYear)
+            route->oldestCount++;
+    }
+}
+
+/// @private Adds the year to the oldest year of the route.
+static void addYearRoute(Route *route, int year) {
+    if (year < route->oldestYear) {
+        route->oldestYear = year;
+        route->oldestCount = 0;
+    }
+    if (year == route->oldestYear)
+        route->oldestCount++;
+}
+
+/// @private Removes the year from the oldest year of the route.
+static void removeYearRoute(Route *route, int year) {
+    //Only when the last oldest road is gone the roads are checked again
+    if (year == route->oldestYear && --route->oldestCount == 0)
+        sumRoadsRoute(route);
+}
+
 Route *createRoute(unsigned number) {
     Route *out = (struct Route*) malloc(sizeof(Route));
     if (out == NULL)
         return NULL;
 
     out->number = number;
+    out->start = NULL;
+    out->end = NULL;
+    out->description = NULL;
+    out->descriptionSize = 0;
+    out->descriptionVersion = 0;
     out->roads = newVec(0);
     if (out->roads == NULL) {
         free(out);
         return NULL;
     }
+    sumRoadsRoute(out);
+    touchRoute(out);
 
     return out;
 }
@@ -46,7 +136,11 @@ void destroyRoute(Route *route) {
     if (route == NULL)
         return;
 
+    for (int i = 0; i < vecSize(route->roads); i++)
+        removeRoadCities(route, getVec(route->roads, i));
     destroyVec(route->roads);
+    touchRoute(route);//The removal is a change as well
+    free(route->description);
     free(route);
 }
 
@@ -61,8 +155,13 @@ void removeRoadRoute(Route *route, Road *road) {
             lid = i;
     }
     
-    if (lid != -1)
+    if (lid != -1) {
         popBackVec(roads);
+        removeRoadCities(route, road);
+        route->length -= getRoadLength(road);
+        removeYearRoute(route, getRoadYear(road));
+    }
+    touchRoute(route);
 }
 
 City *firstCityInRoute(Route *route, City *a, City *b) {
@@ -140,8 +239,12 @@ void insertRoadsRoute(Route *route, vector *roads, int insertionPoint) {
                       getVec(route->roads, insertionPoint - 1)) == NULL)
         reverseVec(tmp);
 
-    for (int i = 0; i < vecSize(roads); i++)
+    for (int i = 0; i < vecSize(roads); i++) {
         addRouteRoad(getVec(roads, i), route);
+        addRoadCities(route, getVec(roads, i));
+        route->length += getRoadLength(getVec(roads, i));
+        addYearRoute(route, getRoadYear(getVec(roads, i)));
+    }
 
     insertVec(route->roads, tmp, insertionPoint);
     destroyVec(tmp);
@@ -154,9 +257,12 @@ void insertRoadsRoute(Route *route, vector *roads, int insertionPoint) {
     route->end = getConnectedCity(getVec(route->roads, size - 1),
                         commonCityRoad(getVec(route->roads, size - 2),
                                        getVec(route->roads, size - 1)));
+    touchRoute(route);
 }
 
 void copyRoadsRoute(Route *route, vector *roads) {
+    for (int i = 0; i < vecSize(route->roads); i++)
+        removeRoadCities(route, getVec(route->roads, i));
     destroyVec(route->roads);
 
     route->roads = copyVec(roads);
@@ -164,8 +270,51 @@ void copyRoadsRoute(Route *route, vector *roads) {
                         route->start) == NULL)
         reverseVec(route->roads);
 
-    for (int i = 0; i < vecSize(roads); i++)
+    for (int i = 0; i < vecSize(roads); i++) {
         addRouteRoad(getVec(roads, i), route);
+        addRoadCities(route, getVec(roads, i));
+    }
+    sumRoadsRoute(route);
+    touchRoute(route);
+}
+
+void changeYearRoute(Route *route, int oldYear, int newYear) {
+    if (oldYear != newYear) {
+        addYearRoute(route, newYear);
+        removeYearRoute(route, oldYear);
+    }
+    touchRoute(route);
+}
+
+unsigned getRouteNumber(Route *route) {
+    return route->number;
+}
+
+unsigned long long getLengthRoute(Route *route) {
+    return route->length;
+}
+
+int getOldestYearRoute(Route *route) {
+    return route->oldestYear;
+}
+
+int getHopCountRoute(Route *route) {
+    return vecSize(route->roads);
+}
+
+const char *getDescriptionRoute(Route *route, size_t *size) {
+    if (route->description == NULL || route->descriptionVersion != route->version)
+        return NULL;
+
+    size[0] = route->descriptionSize;
+    return route->description;
+}
+
+void setDescriptionRoute(Route *route, char *text, size_t size, unsigned long long version) {
+    free(route->description);
+    route->description = text;
+    route->descriptionSize = size;
+    route->descriptionVersion = version;
 }
 
 vector *getRouteRoads(Route *route) {
@@ -174,6 +323,7 @@ vector *getRouteRoads(Route *route) {
 
 void setRouteStart(Route *route, City *start) {
     route->start = start;
+    touchRoute(route);
 }
 
 City *getRouteStart(Route *route) {
@@ -182,6 +332,7 @@ City *getRouteStart(Route *route) {
 
 void setRouteEnd(Route *route, City *end) {
     route->end = end;
+    touchRoute(route);
 }
 
 City *getRouteEnd(Route *route) {
@@ -8,6 +8,7 @@
 #define Route_h
 
 #include <stdbool.h>
+#include <stddef.h>
 
 #include "vector.h"
 #include "City.h"
@@ -30,6 +31,31 @@ Route *createRoute(unsigned number);
  */
 void destroyRoute(Route *route);
 
+/**
+    @brief
+        Marks the route as modified. Every function which
+        changes the route calls it.
+ */
+void touchRoute(Route *route);
+
+/**
+    @brief
+        Returns the stamp of the last modification of the route.
+        Stamps are unique among all routes, so a route created
+        in place of a removed one never repeats its stamp.
+    @return
+        The stamp(always greater than 0).
+ */
+unsigned long long getRouteVersion(Route *route);
+
+/**
+    @brief
+        Returns the stamp of the last modification of any route,
+        including the creation and the destruction of a route.
+        If it did not change, no route has changed.
+ */
+unsigned long long lastRouteVersion(void);
+
 /**
     @brief
         Creates a new vector with the cities(see \ref City)
@@ -116,4 +142,56 @@ City *getRouteEnd(Route *route);
  */
 void removeRoadRoute(Route *route, Road *road);
 
+/**
+    @brief
+        Updates the oldest year of the route after the year
+        of one of its roads was changed from 'oldYear' to 'newYear'
+        and marks the route as modified.
+ */
+void changeYearRoute(Route *route, int oldYear, int newYear);
+
+/**
+    @brief
+        Returns the number of the route.
+ */
+unsigned getRouteNumber(Route *route);
+
+/**
+    @brief
+        Returns the sum of the lengths of the roads of the route.
+ */
+unsigned long long getLengthRoute(Route *route);
+
+/**
+    @brief
+        Returns the smallest year of the roads of the route
+        (INT_MAX if it has no roads).
+ */
+int getOldestYearRoute(Route *route);
+
+/**
+    @brief
+        Returns the number of the roads of the route.
+ */
+int getHopCountRoute(Route *route);
+
+/**
+    @brief
+        Returns the description stored by @ref setDescriptionRoute
+        if the route was not modified since(see @ref getRouteVersion).
+    @param[out] size - length of the description.
+    @return
+        The description ended by '\0', valid until the next
+        call of @ref setDescriptionRoute, or NULL.
+ */
+const char *getDescriptionRoute(Route *route, size_t *size);
+
+/**
+    @brief
+        Stores the description of the route made when its stamp
+        was 'version'. The route takes over the text(allocated
+        with malloc and ended by '\0') and frees the previous one.
+ */
+void setDescriptionRoute(Route *route, char *text, size_t size, unsigned long long version);
+
 #endif /* Route_h */
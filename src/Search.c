@@ -0,0 +1,1461 @@
+/** @file Search.c
+ *  The search for the shortest routes(Dijkstra's algorithm).
+ *
+ *  The labels of the cities are kept in an array indexed by the city id.
+ *  Instead of clearing the array before every search, each label stores
+ *  the number of the search which wrote it, and labels from the earlier
+ *  searches are treated as unvisited.
+ *
+ *  A route is accepted only if, going back from its end, every city has
+ *  only one best road leading to it. A search from the other end of the
+ *  route can give the same answer: the route is reversed on the graph
+ *  of the roads lying on the shortest routes(see @ref reverseRoute).
+ *
+ *  Several searches can also run in turns in one thread, in small steps.
+ *  Every step asks the processor to load the memory needed by the next
+ *  step of the search, and while it is loaded the other searches run.
+ *
+ *  The routes to all cities of a large map can be found by many threads
+ *  at once(delta-stepping). The cities are kept in buckets of distances
+ *  of the given width, and the roads of all cities of the nearest bucket
+ *  are used at once by the threads, until the bucket is empty. A label
+ *  is packed into one number, so that the better labels are the smaller
+ *  numbers and a thread can lower it atomically. Such labels converge
+ *  to the same final labels as in the search of one thread, so the
+ *  best routes are chosen in the same way.
+ *
+ * @author Cezary Chodun
+ */
+
+#include "Search.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+
+#include "Road.h"
+
+/// @private The city can not be used.
+#define LABEL_FORBIDDEN 2
+/// @private The roads of the city were already checked.
+#define LABEL_SETTLED 4
+/// @private The city is a target, so its roads are not used.
+#define LABEL_TARGET 8
+/// @private The city is a target, whose roads are used.
+#define LABEL_GOAL 16
+
+/// @private Step settling the next city.
+#define STEP_SETTLE 0
+/// @private Step reading the roads of the settled city.
+#define STEP_ROADS 1
+/// @private Step reading the cities at the ends of the roads.
+#define STEP_ENDS 2
+/// @private Step loading the labels of the cities at the ends of the roads.
+#define STEP_LABELS 3
+/// @private Step labelling the cities at the ends of the roads.
+#define STEP_RELAX 4
+/// @private The step is not finished(see @ref stepSearch).
+#define SEARCH_RUNNING 2
+
+/// @private Asks the processor to load the memory at the address.
+#if defined(__GNUC__)
+#define PREFETCH(address) __builtin_prefetch(address)
+#else
+#define PREFETCH(address) ((void) (address))
+#endif
+
+/// @private Number of the cities whose roads are used by one task of the parallel search.
+#define PARALLEL_CHUNK 256
+/// @private Number of the labels cleared or written by one task of the parallel search.
+#define PARALLEL_LABELS 16384
+/// @private Label of a city not reached by the parallel search.
+#define UNREACHED ULLONG_MAX
+
+/// @private Label of a city.
+typedef struct Label{
+    /// Number of the search which wrote the label.
+    unsigned generation;
+    /// LABEL_* flags.
+    unsigned state;
+    /// Distance from the start.
+    unsigned distance;
+    /// The oldest road on the way from the start.
+    int oldestRoad;
+    /// Number of the reversal which marked the city(see @ref reverseRoute).
+    unsigned long long reversal;
+    /// Whether 'reversedOldest' is already found.
+    bool reversed;
+    /// The oldest road on the way to the city, for which the route is reversed.
+    int reversedOldest;
+    /// The previous city on the way(set only by @ref searchGuided).
+    City *prev;
+}Label;
+
+/// @private Element of the heap.
+typedef struct HeapEntry{
+    /// Distance from the start.
+    unsigned distance;
+    /// The oldest road on the way from the start.
+    int oldestRoad;
+    /// The city.
+    City *city;
+}HeapEntry;
+
+/// @private List of the cities.
+typedef struct CityList{
+    /// The cities.
+    City **cities;
+    /// Number of the cities.
+    int size;
+    /// Size of 'cities'.
+    int capacity;
+}CityList;
+
+/// @private State of the search run by many threads(see @ref searchAllRoutesParallel).
+typedef struct ParallelSearch{
+    /// Labels of the cities packed into numbers(see @ref packLabel).
+    atomic_ullong *keys;
+    /// Number of the frontier which took the city last.
+    unsigned long long *queued;
+    /// Size of 'keys' and 'queued'.
+    int capacity;
+    /// Number of the last frontier.
+    unsigned long long frontiers;
+    /// Width of a bucket.
+    unsigned delta;
+    /// Buckets of the cities in a ring, the bucket 'b' at 'b % ringSize'.
+    CityList *ring;
+    /// Number of the buckets in the ring.
+    int ringSize;
+    /// Cities whose roads are used in the current phase.
+    CityList frontier;
+    /// Cities labelled by every thread in the current phase.
+    CityList *labelled;
+    /// Size of 'labelled'.
+    int threads;
+    /// Number of the reached cities.
+    atomic_ullong reached;
+    /// Whether a thread could not allocate memory.
+    atomic_bool failed;
+}ParallelSearch;
+
+/// State of the search reused by the consecutive searches.
+typedef struct SearchWorkspace{
+    /// Number of the current search.
+    unsigned generation;
+    /// Labels of the cities.
+    Label *labels;
+    /// Size of 'labels'.
+    int capacity;
+    /// Number of the cities of the current search.
+    int cities;
+    /// Binary heap of the reached cities.
+    HeapEntry *heap;
+    /// Number of the elements in the heap.
+    int heapSize;
+    /// Size of 'heap'.
+    int heapCapacity;
+    /// Number of the current reversal of the routes.
+    unsigned long long reversal;
+    /// Stack of the cities for the reversal of the routes.
+    City **stack;
+    /// Size of 'stack'.
+    int stackCapacity;
+    /// The start of the current search.
+    City *from;
+    /// Number of the targets of the current search.
+    int targets;
+    /// Number of the targets already reached.
+    int reached;
+    /// Number of the cities settled by all searches.
+    unsigned long long settled;
+
+    /// Next step of the search run in steps(STEP_*).
+    int step;
+    /// The city settled by the search run in steps.
+    City *current;
+    /// Roads of 'current'.
+    Road **roads;
+    /// Cities at the ends of 'roads'.
+    City **ends;
+    /// Number of the roads of 'current'.
+    int roadCount;
+    /// Size of 'roads' and 'ends'.
+    int roadCapacity;
+
+    /// State of the search run by many threads(NULL until it is needed).
+    ParallelSearch *parallel;
+    /// The guide of the running search(NULL if it is not guided).
+    const SearchGuide *guide;
+}SearchWorkspace;
+
+void distanceComparator(void *v1, void *v2, int *ret) {
+    ret[0] = 0;
+
+    if (v2 == NULL) {
+        ret[0] = -1;
+        return;//Every distance is smaller then NULL distance
+    }
+    else if (v1 == NULL) {
+        ret[0] = 1;
+        return;
+    }
+
+    Distance *d1 = (Distance*)v1;
+    Distance *d2 = (Distance*)v2;
+
+    if (d1->distance > d2->distance)
+        ret[0] = 1;
+    else if (d1->distance < d2->distance)
+        ret[0] = -1;
+    else {
+        if (d1->oldestRoad < d2->oldestRoad)
+            ret[0] = 1;
+        else if (d1->oldestRoad > d2->oldestRoad)
+            ret[0] = -1;
+    }
+}
+
+/// @private
+static void destroyParallelSearch(ParallelSearch *ps) {
+    if (ps == NULL)
+        return;
+
+    free(ps->keys);
+    free(ps->queued);
+    for (int i = 0; i < ps->ringSize; i++)
+        free(ps->ring[i].cities);
+    free(ps->ring);
+    free(ps->frontier.cities);
+    for (int i = 0; i < ps->threads; i++)
+        free(ps->labelled[i].cities);
+    free(ps->labelled);
+    free(ps);
+}
+
+SearchWorkspace *newSearchWorkspace(void) {
+    SearchWorkspace *out = (struct SearchWorkspace*) malloc(sizeof(SearchWorkspace));
+    if (out == NULL)
+        return NULL;
+
+    out->generation = 0;
+    out->labels = NULL;
+    out->capacity = 0;
+    out->cities = 0;
+    out->heap = NULL;
+    out->heapSize = 0;
+    out->heapCapacity = 0;
+    out->reversal = 0;
+    out->stack = NULL;
+    out->stackCapacity = 0;
+    out->from = NULL;
+    out->targets = 0;
+    out->reached = 0;
+    out->settled = 0;
+    out->step = STEP_SETTLE;
+    out->current = NULL;
+    out->roads = NULL;
+    out->ends = NULL;
+    out->roadCount = 0;
+    out->roadCapacity = 0;
+    out->parallel = NULL;
+    out->guide = NULL;
+
+    return out;
+}
+
+void destroySearchWorkspace(SearchWorkspace *ws) {
+    if (ws == NULL)
+        return;
+
+    free(ws->labels);
+    free(ws->heap);
+    free(ws->stack);
+    free(ws->roads);
+    free(ws->ends);
+    destroyParallelSearch(ws->parallel);
+    free(ws);
+}
+
+/// @private Prepares the workspace for a new search.
+static bool startSearch(SearchWorkspace *ws, int cities) {
+    if (cities > ws->capacity) {
+        int capacity = ws->capacity * 2;
+        if (capacity < cities)
+            capacity = cities;
+
+        Label *labels = (Label*) realloc(ws->labels, sizeof(Label) * capacity);
+        if (labels == NULL)
+            return false;
+        memset(labels + ws->capacity, 0, sizeof(Label) * (capacity - ws->capacity));
+
+        ws->labels = labels;
+        ws->capacity = capacity;
+    }
+
+    if (ws->generation == UINT_MAX) {//The old numbers would repeat
+        memset(ws->labels, 0, sizeof(Label) * ws->capacity);
+        ws->generation = 0;
+    }
+    ws->generation++;
+    ws->heapSize = 0;
+    ws->cities = cities;
+
+    return true;
+}
+
+/// @private Returns the label of the city as it would be after clearing.
+static Label *getLabel(SearchWorkspace *ws, int city) {
+    Label *label = &ws->labels[city];
+    if (label->generation != ws->generation) {
+        label->generation = ws->generation;
+        label->state = 0;
+        label->distance = INT_MAX;
+        label->oldestRoad = INT_MIN;
+    }
+    return label;
+}
+
+/// @private Whether 'a' is better than 'b'.
+static bool lessEntry(HeapEntry *a, HeapEntry *b) {
+    if (a->distance != b->distance)
+        return a->distance < b->distance;
+    return a->oldestRoad > b->oldestRoad;
+}
+
+/// @private
+static bool pushHeap(SearchWorkspace *ws, HeapEntry entry) {
+    if (ws->heapSize == ws->heapCapacity) {
+        int capacity = (ws->heapCapacity == 0 ? 16 : ws->heapCapacity * 2);
+        HeapEntry *heap = (HeapEntry*) realloc(ws->heap, sizeof(HeapEntry) * capacity);
+        if (heap == NULL)
+            return false;
+
+        ws->heap = heap;
+        ws->heapCapacity = capacity;
+    }
+
+    int x = ws->heapSize++;
+    while (x > 0 && lessEntry(&entry, &ws->heap[(x - 1) / 2])) {
+        ws->heap[x] = ws->heap[(x - 1) / 2];
+        x = (x - 1) / 2;
+    }
+    ws->heap[x] = entry;
+
+    return true;
+}
+
+/// @private
+static HeapEntry popHeap(SearchWorkspace *ws) {
+    HeapEntry out = ws->heap[0];
+    HeapEntry last = ws->heap[--ws->heapSize];
+
+    int x = 0;
+    while (2 * x + 1 < ws->heapSize) {
+        int child = 2 * x + 1;
+        if (child + 1 < ws->heapSize && lessEntry(&ws->heap[child + 1], &ws->heap[child]))
+            child++;
+        if (!lessEntry(&ws->heap[child], &last))
+            break;
+
+        ws->heap[x] = ws->heap[child];
+        x = child;
+    }
+    if (ws->heapSize > 0)
+        ws->heap[x] = last;
+
+    return out;
+}
+
+/// @private Distance after going through the road.
+static void composeDistance(Label *last, Road *road, Distance *out) {
+    out->oldestRoad = (last->oldestRoad < getRoadYear(road))?
+    last->oldestRoad : getRoadYear(road);
+    out->distance = last->distance + getRoadLength(road);
+
+    if ((last->state & LABEL_FORBIDDEN) || last->distance == INT_MAX)
+        out->distance = INT_MAX;
+}
+
+/**
+    @private
+    @brief
+        Starts a new search from the city 'from'.
+        The roads of the targets are not used.
+ */
+static bool beginSearch(SearchWorkspace *ws, int cities, City *from, City **targets, int count,
+                        vector *forbidden) {
+    if (!startSearch(ws, cities))
+        return false;
+
+    for (int i = 0; i < vecSize(forbidden); i++) {
+        City *cf = getVec(forbidden, i);
+        if (cf != NULL)
+            getLabel(ws, getCityID(cf))->state = LABEL_FORBIDDEN;
+    }
+    for (int i = 0; i < count; i++)
+        getLabel(ws, getCityID(targets[i]))->state |= LABEL_TARGET;
+
+    Label *start = getLabel(ws, getCityID(from));
+    start->state &= LABEL_TARGET;
+    start->distance = 0;
+    start->oldestRoad = INT_MAX;
+
+    ws->from = from;
+    ws->targets = count;
+    ws->reached = 0;
+    ws->step = STEP_SETTLE;
+
+    HeapEntry first = {0, INT_MAX, from};
+    return pushHeap(ws, first);
+}
+
+/**
+    @private
+    @brief
+        Settles the nearest city, whose roads have to be used next.
+    @return
+        1 if the search is finished, 0 if the nearest city is
+        further than 'bound' and SEARCH_RUNNING if the city
+        was settled.
+ */
+static int settleCity(SearchWorkspace *ws, unsigned bound, City **city) {
+    while (ws->heapSize > 0 && (ws->targets == 0 || ws->reached < ws->targets)) {
+        if (ws->heap[0].distance > bound)
+            return 0;
+
+        HeapEntry p = popHeap(ws);
+
+        Label *label = getLabel(ws, getCityID(p.city));
+        if (label->state & LABEL_SETTLED)
+            continue;//Older entry of the city
+        label->state |= LABEL_SETTLED;
+        ws->settled++;
+
+        if (label->state & LABEL_TARGET) {
+            ws->reached++;
+            continue;
+        }
+        if (label->state & LABEL_GOAL)
+            ws->reached++;
+
+        city[0] = p.city;
+        return SEARCH_RUNNING;
+    }
+
+    return 1;
+}
+
+/**
+    @private
+    @brief
+        Labels the city 'dest' reached by the 'road'
+        from the settled 'city' with the 'label'.
+    @return
+        @p false if the memory could not be allocated.
+ */
+static bool relaxRoad(SearchWorkspace *ws, City *city, Label *label, Road *road, City *dest) {
+    Label *destLabel = getLabel(ws, getCityID(dest));
+    if (destLabel->state & LABEL_FORBIDDEN)
+        return true;
+
+    const SearchGuide *guide = ws->guide;
+    if (guide != NULL && ((destLabel->state & LABEL_SETTLED)
+                          || (guide->useRoad != NULL && !guide->useRoad(guide->data, city, dest))))
+        return true;//The guided search does not use the rejected roads
+
+    Distance next;
+    composeDistance(label, road, &next);
+
+    HeapEntry entry = {next.distance, next.oldestRoad, dest};
+    HeapEntry stored = {destLabel->distance, destLabel->oldestRoad, dest};
+    if (lessEntry(&entry, &stored)) {//The distance is smaller
+        if (guide != NULL) {
+            unsigned left = guide->estimate(guide->data, dest);
+            if (left == UINT_MAX)
+                return true;//The target can not be reached from the city
+
+            //The cities nearest to the target by the estimate are settled first
+            entry.distance += left;
+            destLabel->prev = city;
+        }
+        if (!pushHeap(ws, entry))
+            return false;
+
+        destLabel->distance = next.distance;
+        destLabel->oldestRoad = next.oldestRoad;
+    }
+
+    return true;
+}
+
+/**
+    @private
+    @brief
+        Labels the cities reached by the roads of the settled 'city'.
+    @return
+        @p false if the memory could not be allocated.
+ */
+static bool relaxCity(SearchWorkspace *ws, City *city) {
+    Label *label = getLabel(ws, getCityID(city));
+    vector *roads = getRoadsCity(city);
+
+    for (int i = vecSize(roads) - 1; i >= 0; i--) {
+        Road *road = getVec(roads, i);
+        City *dest = getConnectedCity(road, city);
+        if (dest == NULL || !relaxRoad(ws, city, label, road, dest))
+            return false;
+    }
+
+    return true;
+}
+
+/**
+    @private
+    @brief
+        Labels the cities until all targets are reached(all
+        reachable cities if there are no targets) or the
+        nearest city left is further than 'bound'.
+    @return
+        1 if the search is finished, 0 if it stopped at
+        the bound and -1 if the memory could not be allocated.
+ */
+static int labelCities(SearchWorkspace *ws, unsigned bound) {
+    City *city;
+    int ret;
+
+    while ((ret = settleCity(ws, bound, &city)) == SEARCH_RUNNING)
+        if (!relaxCity(ws, city))
+            return -1;
+
+    return ret;
+}
+
+/**
+    @private
+    @brief
+        Makes one step of the search(see @ref labelCities), which
+        reads the memory loaded by the previous step and asks for
+        the memory needed by the next one.
+    @return
+        As @ref labelCities or SEARCH_RUNNING if the search
+        is not finished.
+ */
+static int stepSearch(SearchWorkspace *ws, unsigned bound) {
+    switch (ws->step) {
+    case STEP_SETTLE: {
+        int ret = settleCity(ws, bound, &ws->current);
+        if (ret != SEARCH_RUNNING)
+            return ret;
+
+        PREFETCH(ws->current);
+        ws->step = STEP_ROADS;
+        break;
+    }
+    case STEP_ROADS: {
+        vector *roads = getRoadsCity(ws->current);
+        int count = vecSize(roads);
+
+        if (count > ws->roadCapacity) {
+            Road **r = (Road**) realloc(ws->roads, sizeof(Road*) * count);
+            if (r == NULL)
+                return -1;
+            ws->roads = r;
+
+            City **e = (City**) realloc(ws->ends, sizeof(City*) * count);
+            if (e == NULL)
+                return -1;
+            ws->ends = e;
+            ws->roadCapacity = count;
+        }
+
+        for (int i = 0; i < count; i++) {
+            ws->roads[i] = getVec(roads, i);
+            PREFETCH(ws->roads[i]);
+        }
+        ws->roadCount = count;
+        ws->step = STEP_ENDS;
+        break;
+    }
+    case STEP_ENDS:
+        for (int i = 0; i < ws->roadCount; i++) {
+            ws->ends[i] = getConnectedCity(ws->roads[i], ws->current);
+            if (ws->ends[i] == NULL)
+                return -1;
+            PREFETCH(ws->ends[i]);
+        }
+        ws->step = STEP_LABELS;
+        break;
+    case STEP_LABELS:
+        for (int i = 0; i < ws->roadCount; i++)
+            PREFETCH(&ws->labels[getCityID(ws->ends[i])]);
+        ws->step = STEP_RELAX;
+        break;
+    default: {
+        Label *label = getLabel(ws, getCityID(ws->current));
+        for (int i = ws->roadCount - 1; i >= 0; i--)
+            if (!relaxRoad(ws, ws->current, label, ws->roads[i], ws->ends[i]))
+                return -1;
+        ws->step = STEP_SETTLE;
+        break;
+    }
+    }
+
+    return SEARCH_RUNNING;
+}
+
+/**
+    @private
+    @brief
+        Checks whether the best route from 'from' to 'city' may come
+        through the 'road'. The city on the other side of the road has
+        a label which is final(the roads of the targets are not used)
+        and the route can have the oldest road not older than 'bound'.
+ */
+static bool isBestRoad(SearchWorkspace *ws, City *from, City *city, Road *road, int bound) {
+    City *prevCity = getConnectedCity(road, city);
+    Label *label = getLabel(ws, getCityID(city));
+    Label *prev = getLabel(ws, getCityID(prevCity));
+
+    if (!(prev->state & LABEL_SETTLED) || prev->distance == INT_MAX)
+        return false;
+    if ((prev->state & LABEL_TARGET) && prevCity != from)
+        return false;
+    if (getRoadYear(road) < bound || prev->oldestRoad < bound)
+        return false;
+
+    return prev->distance + getRoadLength(road) == label->distance;
+}
+
+/**
+    @private
+    @brief
+        Finds the road through which the best route from 'from'
+        to 'city' may come(see @ref isBestRoad), starting from
+        the road with number 'x'.
+    @return
+        The number of the road or -1 if there is no such road.
+ */
+static int nextBestRoad(SearchWorkspace *ws, City *from, City *city, int bound, int x) {
+    vector *roads = getRoadsCity(city);
+
+    for (; x < vecSize(roads); x++)
+        if (isBestRoad(ws, from, city, getVec(roads, x), bound))
+            return x;
+
+    return -1;
+}
+
+/// @private Puts the city on the stack of the workspace, which has 'size' cities.
+static bool pushStack(SearchWorkspace *ws, int *size, City *city) {
+    if (size[0] == ws->stackCapacity) {
+        int capacity = (ws->stackCapacity == 0 ? 16 : ws->stackCapacity * 2);
+        City **stack = (City**) realloc(ws->stack, sizeof(City*) * capacity);
+        if (stack == NULL)
+            return false;
+
+        ws->stack = stack;
+        ws->stackCapacity = capacity;
+    }
+
+    ws->stack[size[0]++] = city;
+    return true;
+}
+
+/**
+    @private
+    @brief
+        Goes back from 'to' to 'from' through the roads which give
+        the labels of the cities. Every city on the way has to have
+        exactly one such road, otherwise the choice is ambiguous.
+    @param[out] out - the roads in the reversed order(ignored if NULL).
+    @return
+        1 if the route was found, 0 if the choice is ambiguous
+        and -1 if the memory could not be allocated.
+ */
+static int backtrackRoute(SearchWorkspace *ws, City *from, City *to, vector *out) {
+    City *last = to;
+
+    while (last != from) {
+        int bound = getLabel(ws, getCityID(last))->oldestRoad;
+        int x = nextBestRoad(ws, from, last, bound, 0);
+        if (x == -1 || nextBestRoad(ws, from, last, bound, x + 1) != -1)
+            return 0;//Ambiguous route
+
+        Road *road = getVec(getRoadsCity(last), x);
+        if (out != NULL && pushBackVec(out, road) == NULL)
+            return -1;
+        last = getConnectedCity(road, last);
+    }
+
+    return 1;
+}
+
+/**
+    @private
+    @brief
+        Marks the cities on the shortest routes from the start of the
+        search to 'to', going back from 'to'. Their labels get the
+        number of the current reversal(see @ref reverseRoute).
+    @return
+        @p false if the memory could not be allocated.
+ */
+static bool markShortestRoutes(SearchWorkspace *ws, City *to) {
+    int size = 0;
+    Label *label = getLabel(ws, getCityID(to));
+    label->reversal = ws->reversal;
+    label->reversed = false;
+    if (!pushStack(ws, &size, to))
+        return false;
+
+    while (size > 0) {
+        City *city = ws->stack[--size];
+        vector *roads = getRoadsCity(city);
+
+        for (int x = nextBestRoad(ws, ws->from, city, INT_MIN, 0); x != -1;
+             x = nextBestRoad(ws, ws->from, city, INT_MIN, x + 1)) {
+            City *prev = getConnectedCity(getVec(roads, x), city);
+            Label *prevLabel = getLabel(ws, getCityID(prev));
+            if (prevLabel->reversal == ws->reversal)
+                continue;//Already marked
+
+            prevLabel->reversal = ws->reversal;
+            prevLabel->reversed = false;
+            if (!pushStack(ws, &size, prev))
+                return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+    @private
+    @brief
+        Finds the next road of the route from the start of the search
+        to the marked city 'to'(see @ref markShortestRoutes), which
+        leaves 'city', starting from the road with number 'x'.
+    @return
+        The number of the road or -1 if there is no such road.
+ */
+static int nextMarkedRoad(SearchWorkspace *ws, City *city, int x) {
+    vector *roads = getRoadsCity(city);
+
+    for (; x < vecSize(roads); x++) {
+        Road *road = getVec(roads, x);
+        City *next = getConnectedCity(road, city);
+        if (getLabel(ws, getCityID(next))->reversal == ws->reversal
+            && isBestRoad(ws, ws->from, next, road, INT_MIN))
+            return x;
+    }
+
+    return -1;
+}
+
+/**
+    @private
+    @brief
+        Finds for every marked city(see @ref markShortestRoutes) the
+        newest oldest road of the shortest routes from 'to' to it,
+        which is the label the city would have in the search from 'to'.
+        The cities are ordered by the routes from the start of the
+        search, so they are visited from the start.
+    @return
+        @p false if the memory could not be allocated.
+ */
+static bool labelReversed(SearchWorkspace *ws, City *to) {
+    int size = 0;
+    if (!pushStack(ws, &size, ws->from))
+        return false;
+
+    while (size > 0) {
+        City *city = ws->stack[size - 1];
+        Label *label = getLabel(ws, getCityID(city));
+        if (label->reversed) {
+            size--;
+            continue;//Already labelled
+        }
+
+        int oldest = (city == to ? INT_MAX : INT_MIN);
+        bool ready = true;
+        vector *roads = getRoadsCity(city);
+
+        for (int x = nextMarkedRoad(ws, city, 0); x != -1 && city != to;
+             x = nextMarkedRoad(ws, city, x + 1)) {
+            Road *road = getVec(roads, x);
+            Label *next = getLabel(ws, getCityID(getConnectedCity(road, city)));
+
+            if (!next->reversed) {
+                ready = false;//The next city has to be labelled first
+                if (!pushStack(ws, &size, getConnectedCity(road, city)))
+                    return false;
+            }
+            else if (ready) {
+                int year = (getRoadYear(road) < next->reversedOldest ?
+                            getRoadYear(road) : next->reversedOldest);
+                if (year > oldest)
+                    oldest = year;
+            }
+        }
+
+        if (ready) {
+            label->reversed = true;
+            label->reversedOldest = oldest;
+            size--;
+        }
+    }
+
+    return true;
+}
+
+/**
+    @private
+    @brief
+        Finds the route from 'to' to the start of the search, which
+        the search from 'to' would find(see @ref backtrackRoute). That
+        search would go back from the start of this one, through the
+        cities whose labels in it are found by @ref labelReversed.
+    @param[out] out - the roads from the start of the search to 'to'
+        (ignored if NULL).
+    @return
+        1 if the route was found, 0 if the choice is ambiguous
+        and -1 if the memory could not be allocated.
+ */
+static int reverseRoute(SearchWorkspace *ws, City *to, vector *out) {
+    ws->reversal++;
+    if (!markShortestRoutes(ws, to) || !labelReversed(ws, to))
+        return -1;
+
+    City *last = ws->from;
+    while (last != to) {
+        int oldest = getLabel(ws, getCityID(last))->reversedOldest;
+        vector *roads = getRoadsCity(last);
+        Road *best = NULL;
+
+        for (int x = nextMarkedRoad(ws, last, 0); x != -1; x = nextMarkedRoad(ws, last, x + 1)) {
+            Road *road = getVec(roads, x);
+            Label *next = getLabel(ws, getCityID(getConnectedCity(road, last)));
+            if (getRoadYear(road) < oldest || next->reversedOldest < oldest)
+                continue;//Worse than the label of 'last'
+
+            if (best != NULL)
+                return 0;//Ambiguous route
+            best = road;
+        }
+
+        if (best == NULL)
+            return 0;
+        if (out != NULL && pushBackVec(out, best) == NULL)
+            return -1;
+        last = getConnectedCity(best, last);
+    }
+
+    return 1;
+}
+
+/**
+    @private
+    @brief
+        Creates the result of the search for the target 'to'
+        (see @ref searchRoute). The routes through the other
+        targets are not taken into account.
+ */
+static vector *targetRoute(SearchWorkspace *ws, City *from, City *to, Distance *dst) {
+    dst->city = NULL;
+
+    Label *label = getLabel(ws, getCityID(to));
+    if (label->distance == INT_MAX) {//Cannot reach the city
+        dst->city = from;
+        dst->distance = INT_MAX;
+        return NULL;
+    }
+
+    vector *out = newVec(10);
+    if (out == NULL)
+        return NULL;
+
+    if (backtrackRoute(ws, from, to, out) != 1) {
+        destroyVec(out);
+        return NULL;//Ambiguous route or memory problems
+    }
+    reverseVec(out);
+
+    dst->city = to;
+    dst->distance = label->distance;
+    dst->oldestRoad = label->oldestRoad;
+
+    return out;
+}
+
+/**
+    @private
+    @brief
+        Creates the result of the search from 'from' to the start
+        of the finished search(see @ref reverseRoute), from its labels.
+ */
+static vector *reversedTargetRoute(SearchWorkspace *ws, City *from, Distance *dst) {
+    dst->city = NULL;
+
+    Label *label = getLabel(ws, getCityID(from));
+    if (label->distance == INT_MAX) {//Cannot reach the city
+        dst->city = from;
+        dst->distance = INT_MAX;
+        return NULL;
+    }
+
+    vector *out = newVec(10);
+    if (out == NULL)
+        return NULL;
+
+    if (reverseRoute(ws, from, out) != 1) {
+        destroyVec(out);
+        return NULL;//Ambiguous route or memory problems
+    }
+    reverseVec(out);
+
+    dst->city = ws->from;
+    dst->distance = label->distance;
+    dst->oldestRoad = label->oldestRoad;
+
+    return out;
+}
+
+vector *searchRoute(SearchWorkspace *ws, int cities, City *from, City *to,
+                    vector *forbidden, Distance *dst) {
+    dst->city = NULL;
+    if (!startRouteSearch(ws, cities, from, to, forbidden)
+        || continueRouteSearch(ws, UINT_MAX) != 1)
+        return NULL;//Failed to allocate memory
+
+    return finishRouteSearch(ws, to, dst);
+}
+
+bool searchTwoRoutes(SearchWorkspace *ws, int cities, City *from, City *to1, City *to2,
+                     vector *forbidden, vector **roads1, Distance *dst1,
+                     vector **roads2, Distance *dst2) {
+    roads1[0] = roads2[0] = NULL;
+    dst1->city = dst2->city = NULL;
+    if (ws == NULL || from == NULL || to1 == NULL || to2 == NULL || to1 == to2)
+        return false;
+
+    City *targets[2] = {to1, to2};
+    if (!beginSearch(ws, cities, from, targets, 2, forbidden) || labelCities(ws, UINT_MAX) != 1)
+        return false;//Failed to allocate memory
+
+    roads1[0] = targetRoute(ws, from, to1, dst1);
+    roads2[0] = reversedTargetRoute(ws, to2, dst2);
+
+    return true;
+}
+
+bool startRouteSearch(SearchWorkspace *ws, int cities, City *from, City *to,
+                      vector *forbidden) {
+    if (ws == NULL || from == NULL || to == NULL)
+        return false;
+
+    return beginSearch(ws, cities, from, &to, 1, forbidden);
+}
+
+int continueRouteSearch(SearchWorkspace *ws, unsigned bound) {
+    if (ws == NULL || ws->from == NULL)
+        return -1;
+
+    return labelCities(ws, bound);
+}
+
+void continueRouteSearches(SearchWorkspace **ws, unsigned *bounds, int *results, int count) {
+    int running = 0;
+    for (int i = 0; i < count; i++) {
+        results[i] = (ws[i] == NULL || ws[i]->from == NULL ? -1 : SEARCH_RUNNING);
+        if (results[i] == SEARCH_RUNNING)
+            running++;
+    }
+
+    //Every search makes a step in turn, so its memory is loaded while the others run
+    while (running > 0)
+        for (int i = 0; i < count; i++) {
+            if (results[i] != SEARCH_RUNNING)
+                continue;
+
+            results[i] = stepSearch(ws[i], bounds[i]);
+            if (results[i] != SEARCH_RUNNING)
+                running--;
+        }
+}
+
+vector *finishRouteSearch(SearchWorkspace *ws, City *to, Distance *dst) {
+    dst->city = NULL;
+    if (ws == NULL || ws->from == NULL || to == NULL)
+        return NULL;
+
+    return targetRoute(ws, ws->from, to, dst);
+}
+
+vector *finishReversedRouteSearch(SearchWorkspace *ws, City *from, Distance *dst) {
+    dst->city = NULL;
+    if (ws == NULL || ws->from == NULL || from == NULL)
+        return NULL;
+
+    return reversedTargetRoute(ws, from, dst);
+}
+
+bool searchAllRoutes(SearchWorkspace *ws, int cities, City *from) {
+    return searchManyRoutes(ws, cities, from, NULL, 0);
+}
+
+bool searchManyRoutes(SearchWorkspace *ws, int cities, City *from, City **targets, int count) {
+    return startManyRouteSearch(ws, cities, from, targets, count)
+           && labelCities(ws, UINT_MAX) == 1;
+}
+
+bool startManyRouteSearch(SearchWorkspace *ws, int cities, City *from,
+                          City **targets, int count) {
+    if (ws == NULL || from == NULL)
+        return false;
+    if (!beginSearch(ws, cities, from, NULL, 0, NULL))
+        return false;//Failed to allocate memory
+
+    for (int i = 0; i < count; i++) {
+        Label *label = getLabel(ws, getCityID(targets[i]));
+        if (!(label->state & LABEL_GOAL)) {//Repeated targets are reached once
+            label->state |= LABEL_GOAL;
+            ws->targets++;
+        }
+    }
+
+    return true;
+}
+
+/**
+    @private
+    @brief
+        Checks the best route of the finished search between the start
+        and the city 'city'(see @ref finishRouteCheck), found by the
+        search from the start if 'reversed' is false, and by the search
+        from 'city' otherwise.
+ */
+static int checkRoute(SearchWorkspace *ws, City *city, bool reversed, Distance *dst) {
+    dst->city = NULL;
+    if (ws == NULL || ws->from == NULL || city == NULL)
+        return -1;
+
+    Label *label = getLabel(ws, getCityID(city));
+    if (label->distance == INT_MAX) {//Cannot reach the city
+        dst->city = (reversed ? city : ws->from);
+        dst->distance = INT_MAX;
+        return 0;
+    }
+
+    int found = (reversed ? reverseRoute(ws, city, NULL)
+                          : backtrackRoute(ws, ws->from, city, NULL));
+    if (found == -1)
+        return -1;//Failed to allocate memory
+
+    dst->city = (reversed ? ws->from : city);
+    dst->distance = label->distance;
+    dst->oldestRoad = label->oldestRoad;
+
+    return (found == 1 ? 1 : 2);
+}
+
+int finishRouteCheck(SearchWorkspace *ws, City *to, Distance *dst) {
+    return checkRoute(ws, to, false, dst);
+}
+
+int finishReversedRouteCheck(SearchWorkspace *ws, City *from, Distance *dst) {
+    return checkRoute(ws, from, true, dst);
+}
+
+bool searchWithin(SearchWorkspace *ws, int cities, City *from, unsigned bound,
+                  void (*visit)(void *data, City *city, unsigned distance), void *data) {
+    if (ws == NULL || from == NULL || visit == NULL)
+        return false;
+    if (!beginSearch(ws, cities, from, NULL, 0, NULL))
+        return false;//Failed to allocate memory
+
+    //Only the cities not further than 'bound' are settled
+    City *city;
+    while (settleCity(ws, bound, &city) == SEARCH_RUNNING) {
+        visit(data, city, getLabel(ws, getCityID(city))->distance);
+        if (!relaxCity(ws, city))
+            return false;
+    }
+
+    return true;
+}
+
+int searchGuided(SearchWorkspace *ws, int cities, City *from, City *to, int oldestRoad,
+                 vector *forbidden, const SearchGuide *guide) {
+    if (ws == NULL || from == NULL || to == NULL || guide == NULL || guide->estimate == NULL)
+        return -1;
+    if (!beginSearch(ws, cities, from, &to, 1, forbidden))
+        return -1;//Failed to allocate memory
+
+    unsigned left = guide->estimate(guide->data, from);
+    if (left == UINT_MAX)
+        return 0;//The target can not be reached
+
+    //The search continues a way with the given oldest road
+    Label *start = getLabel(ws, getCityID(from));
+    start->oldestRoad = oldestRoad;
+    start->prev = NULL;
+    ws->heap[0].distance = left;
+    ws->heap[0].oldestRoad = oldestRoad;
+
+    ws->guide = guide;
+    int ret = labelCities(ws, UINT_MAX);
+    ws->guide = NULL;
+    if (ret == -1)
+        return -1;
+
+    return (getLabel(ws, getCityID(to))->state & LABEL_SETTLED) ? 1 : 0;
+}
+
+City *previousCity(SearchWorkspace *ws, City *city) {
+    if (ws == NULL || ws->from == NULL || city == NULL || city == ws->from)
+        return NULL;
+
+    Label *label = getLabel(ws, getCityID(city));
+    return (label->distance == INT_MAX ? NULL : label->prev);
+}
+
+void finishRouteDistance(SearchWorkspace *ws, City *to, Distance *dst) {
+    dst->city = NULL;
+    if (ws == NULL || ws->from == NULL || to == NULL)
+        return;
+
+    Label *label = getLabel(ws, getCityID(to));
+    if (label->distance == INT_MAX) {//Cannot reach the city
+        dst->city = ws->from;
+        dst->distance = INT_MAX;
+        return;
+    }
+
+    dst->city = to;
+    dst->distance = label->distance;
+    dst->oldestRoad = label->oldestRoad;
+}
+
+bool roadChangesRoutes(SearchWorkspace *ws, City *a, City *b, int length) {
+    if (ws == NULL || ws->from == NULL || a == NULL || b == NULL)
+        return true;
+    if (getCityID(a) >= ws->cities || getCityID(b) >= ws->cities)
+        return true;//A new city
+
+    Label *la = getLabel(ws, getCityID(a));
+    Label *lb = getLabel(ws, getCityID(b));
+    if (la->distance == INT_MAX && lb->distance == INT_MAX)
+        return false;//Neither city can be reached
+
+    //Only a road not longer than the difference of the distances can lie on a best route
+    unsigned long long da = la->distance, db = lb->distance;
+    return da + (unsigned) length <= db || db + (unsigned) length <= da;
+}
+
+/// @private Packs the label, so that the better labels are the smaller numbers.
+static unsigned long long packLabel(unsigned distance, int oldestRoad) {
+    return ((unsigned long long) distance << 32)
+           | (unsigned long long) ((long long) INT_MAX - oldestRoad);
+}
+
+/// @private
+static unsigned packedDistance(unsigned long long key) {
+    return (unsigned) (key >> 32);
+}
+
+/// @private
+static int packedOldestRoad(unsigned long long key) {
+    return (int) ((long long) INT_MAX - (long long) (key & UINT_MAX));
+}
+
+/// @private
+static bool pushCityList(CityList *list, City *city) {
+    if (list->size == list->capacity) {
+        int capacity = (list->capacity == 0 ? 64 : list->capacity * 2);
+        City **cities = (City**) realloc(list->cities, sizeof(City*) * capacity);
+        if (cities == NULL)
+            return false;
+
+        list->cities = cities;
+        list->capacity = capacity;
+    }
+
+    list->cities[list->size++] = city;
+    return true;
+}
+
+/// @private Prepares the state of the parallel search for the cities and the threads.
+static bool prepareParallel(SearchWorkspace *ws, int cities, int threads) {
+    if (ws->parallel == NULL) {
+        ws->parallel = (ParallelSearch*) calloc(1, sizeof(ParallelSearch));
+        if (ws->parallel == NULL)
+            return false;
+    }
+    ParallelSearch *ps = ws->parallel;
+
+    if (cities > ps->capacity) {
+        atomic_ullong *keys = (atomic_ullong*) realloc(ps->keys, sizeof(atomic_ullong) * cities);
+        if (keys == NULL)
+            return false;
+        ps->keys = keys;
+
+        unsigned long long *queued = (unsigned long long*)
+            realloc(ps->queued, sizeof(unsigned long long) * cities);
+        if (queued == NULL)
+            return false;
+        memset(queued + ps->capacity, 0, sizeof(unsigned long long) * (cities - ps->capacity));
+        ps->queued = queued;
+        ps->capacity = cities;
+    }
+
+    if (threads > ps->threads) {
+        CityList *labelled = (CityList*) realloc(ps->labelled, sizeof(CityList) * threads);
+        if (labelled == NULL)
+            return false;
+        memset(labelled + ps->threads, 0, sizeof(CityList) * (threads - ps->threads));
+        ps->labelled = labelled;
+        ps->threads = threads;
+    }
+
+    if (ps->ringSize == 0) {
+        ps->ring = (CityList*) calloc(2, sizeof(CityList));
+        if (ps->ring == NULL)
+            return false;
+        ps->ringSize = 2;
+    }
+    for (int i = 0; i < ps->ringSize; i++)
+        ps->ring[i].size = 0;
+    for (int i = 0; i < ps->threads; i++)
+        ps->labelled[i].size = 0;
+
+    atomic_store(&ps->reached, 0);
+    atomic_store(&ps->failed, false);
+
+    return true;
+}
+
+/**
+    @private
+    @brief
+        Chooses the width of the buckets, the average length of the
+        roads of the city 'from' and of its neighbours. Any width gives
+        the same labels, but with a narrow one the threads have little
+        to do at once, and with a wide one the roads are used many times.
+ */
+static unsigned bucketWidth(City *from) {
+    unsigned long long length = 0, count = 0;
+    vector *roads = getRoadsCity(from);
+
+    for (int i = 0; i < vecSize(roads); i++) {
+        vector *next = getRoadsCity(getConnectedCity(getVec(roads, i), from));
+        for (int j = 0; j < vecSize(next); j++, count++)
+            length += getRoadLength(getVec(next, j));
+    }
+
+    if (count == 0 || length / count == 0)
+        return 1;
+    return (length / count > UINT_MAX ? UINT_MAX : (unsigned) (length / count));
+}
+
+/// @private Task of the pool clearing the packed labels.
+static void clearLabels(void *data, int index, int thread) {
+    (void) thread;
+    SearchWorkspace *ws = (SearchWorkspace*) data;
+
+    int end = (index + 1) * PARALLEL_LABELS;
+    for (int i = index * PARALLEL_LABELS; i < end && i < ws->cities; i++)
+        atomic_init(&ws->parallel->keys[i], UNREACHED);
+}
+
+/// @private Task of the pool using the roads of a part of the frontier.
+static void relaxFrontier(void *data, int index, int thread) {
+    ParallelSearch *ps = ((SearchWorkspace*) data)->parallel;
+    CityList *out = &ps->labelled[thread];
+
+    int end = (index + 1) * PARALLEL_CHUNK;
+    for (int i = index * PARALLEL_CHUNK; i < end && i < ps->frontier.size; i++) {
+        City *city = ps->frontier.cities[i];
+        unsigned long long key = atomic_load_explicit(&ps->keys[getCityID(city)],
+                                                      memory_order_relaxed);
+        vector *roads = getRoadsCity(city);
+
+        for (int j = 0; j < vecSize(roads); j++) {
+            Road *road = getVec(roads, j);
+            City *dest = getConnectedCity(road, city);
+            int oldestRoad = packedOldestRoad(key);
+            if (getRoadYear(road) < oldestRoad)
+                oldestRoad = getRoadYear(road);
+
+            unsigned long long next = packLabel(packedDistance(key) + getRoadLength(road), oldestRoad);
+            atomic_ullong *stored = &ps->keys[getCityID(dest)];
+            unsigned long long old = atomic_load_explicit(stored, memory_order_relaxed);
+
+            //Another thread may lower the label at the same time
+            while (next < old) {
+                if (atomic_compare_exchange_weak_explicit(stored, &old, next, memory_order_relaxed,
+                                                          memory_order_relaxed)) {
+                    if (!pushCityList(out, dest))
+                        atomic_store(&ps->failed, true);
+                    break;
+                }
+            }
+        }
+    }
+}
+
+/// @private Task of the pool writing the final labels of the search.
+static void writeLabels(void *data, int index, int thread) {
+    (void) thread;
+    SearchWorkspace *ws = (SearchWorkspace*) data;
+    unsigned long long reached = 0;
+
+    int end = (index + 1) * PARALLEL_LABELS;
+    for (int i = index * PARALLEL_LABELS; i < end && i < ws->cities; i++) {
+        unsigned long long key = atomic_load_explicit(&ws->parallel->keys[i], memory_order_relaxed);
+        if (key == UNREACHED)
+            continue;
+
+        Label *label = &ws->labels[i];
+        label->generation = ws->generation;
+        label->state = LABEL_SETTLED;
+        label->distance = packedDistance(key);
+        label->oldestRoad = packedOldestRoad(key);
+        reached++;
+    }
+
+    atomic_fetch_add(&ws->parallel->reached, reached);
+}
+
+/// @private Makes the ring hold the buckets from 'bucket' to 'last'.
+static bool growRing(ParallelSearch *ps, unsigned long long bucket, unsigned long long last) {
+    if (last - bucket < (unsigned long long) ps->ringSize)
+        return true;
+    if (last - bucket >= INT_MAX / 2)
+        return false;
+
+    int size = ps->ringSize * 2;
+    if ((unsigned long long) size <= last - bucket)
+        size = (int) (last - bucket + 1);
+
+    CityList *ring = (CityList*) calloc(size, sizeof(CityList));
+    if (ring == NULL)
+        return false;
+
+    for (unsigned long long b = bucket; b < bucket + ps->ringSize; b++)
+        ring[b % size] = ps->ring[b % ps->ringSize];
+
+    free(ps->ring);
+    ps->ring = ring;
+    ps->ringSize = size;
+
+    return true;
+}
+
+/**
+    @private
+    @brief
+        Moves the cities of the 'bucket' to the frontier, omitting
+        the cities with a label from another bucket(they were reached
+        again by a shorter route) and the repeated cities.
+ */
+static bool takeBucket(ParallelSearch *ps, unsigned long long bucket) {
+    CityList *list = &ps->ring[bucket % ps->ringSize];
+    ps->frontier.size = 0;
+    ps->frontiers++;
+
+    for (int i = 0; i < list->size; i++) {
+        City *city = list->cities[i];
+        int id = getCityID(city);
+        unsigned long long key = atomic_load_explicit(&ps->keys[id], memory_order_relaxed);
+
+        if (packedDistance(key) / ps->delta != bucket || ps->queued[id] == ps->frontiers)
+            continue;
+        ps->queued[id] = ps->frontiers;
+        if (!pushCityList(&ps->frontier, city))
+            return false;
+    }
+    list->size = 0;
+
+    return true;
+}
+
+/// @private Moves the cities labelled by the threads to their buckets.
+static bool collectLabelled(ParallelSearch *ps, unsigned long long bucket, int threads,
+                            unsigned long long *pending) {
+    for (int t = 0; t < threads; t++) {
+        CityList *list = &ps->labelled[t];
+
+        for (int i = 0; i < list->size; i++) {
+            City *city = list->cities[i];
+            unsigned long long key = atomic_load_explicit(&ps->keys[getCityID(city)],
+                                                          memory_order_relaxed);
+            unsigned long long next = packedDistance(key) / ps->delta;
+
+            if (!growRing(ps, bucket, next)
+                || !pushCityList(&ps->ring[next % ps->ringSize], city))
+                return false;
+            pending[0]++;
+        }
+        list->size = 0;
+    }
+
+    return true;
+}
+
+bool searchAllRoutesParallel(SearchWorkspace *ws, int cities, City *from, ThreadPool *pool) {
+    if (pool == NULL || threadPoolSize(pool) < 2)
+        return searchAllRoutes(ws, cities, from);
+    if (ws == NULL || from == NULL)
+        return false;
+
+    int threads = threadPoolSize(pool);
+    if (!startSearch(ws, cities) || !prepareParallel(ws, cities, threads))
+        return false;//Failed to allocate memory
+
+    ParallelSearch *ps = ws->parallel;
+    ws->from = from;
+    ws->targets = 0;
+    ws->reached = 0;
+    ws->step = STEP_SETTLE;
+
+    int labelTasks = (cities + PARALLEL_LABELS - 1) / PARALLEL_LABELS;
+    runThreadPool(pool, &clearLabels, ws, labelTasks);
+
+    ps->delta = bucketWidth(from);
+    atomic_store_explicit(&ps->keys[getCityID(from)], packLabel(0, INT_MAX), memory_order_relaxed);
+    if (!pushCityList(&ps->ring[0], from))
+        return false;
+
+    //The bucket is used until its cities are not labelled again
+    unsigned long long bucket = 0, pending = 1;
+    while (pending > 0) {
+        while (ps->ring[bucket % ps->ringSize].size == 0)
+            bucket++;
+
+        pending -= ps->ring[bucket % ps->ringSize].size;
+        if (!takeBucket(ps, bucket))
+            return false;
+
+        int tasks = (ps->frontier.size + PARALLEL_CHUNK - 1) / PARALLEL_CHUNK;
+        if (tasks == 1)
+            relaxFrontier(ws, 0, 0);//Not worth waking the threads
+        else if (tasks > 1)
+            runThreadPool(pool, &relaxFrontier, ws, tasks);
+
+        if (atomic_load(&ps->failed) || !collectLabelled(ps, bucket, threads, &pending))
+            return false;//Failed to allocate memory
+    }
+
+    runThreadPool(pool, &writeLabels, ws, labelTasks);
+    ws->settled += atomic_load(&ps->reached);
+
+    return true;
+}
+
+unsigned long long settledCities(SearchWorkspace *ws) {
+    if (ws == NULL)
+        return 0;
+    return ws->settled;
+}
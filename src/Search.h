@@ -0,0 +1,311 @@
+/** @file Search.h
+ *  Interface of the search for the shortest routes between cities.
+ *
+ *  The search keeps its state in a SearchWorkspace, which is reused
+ *  by the consecutive searches. A workspace can be used by one thread
+ *  at a time, but many threads can search the same map at once,
+ *  each with its own workspace, as long as nobody modifies the map.
+ *
+ * @author Cezary Chodun
+ */
+
+#ifndef Search_h
+#define Search_h
+
+#include <stdbool.h>
+
+#include "vector.h"
+#include "City.h"
+#include "ThreadPool.h"
+
+/**
+    Length of the route to a city, compared first by
+    the distance and then by the oldest road(the newer the better).
+ */
+typedef struct Distance{
+    /// The city(NULL if the search failed).
+    City *city;
+    /// Sum of the lengths of the roads.
+    unsigned distance;
+    /// The smallest year of the roads.
+    int oldestRoad;
+}Distance;
+
+/// @private
+typedef struct SearchWorkspace SearchWorkspace;
+
+/**
+    Directs the search of @ref searchGuided towards its target(A*)
+    and rejects some of the roads.
+ */
+typedef struct SearchGuide{
+    /// Returns a distance from the city to the target, not longer than
+    /// the length of any road from the city and the distance from its
+    /// other end, or UINT_MAX if the target can not be reached.
+    unsigned (*estimate)(void *data, City *city);
+    /// Returns whether the road from 'city' to 'next' can be used(NULL if all can).
+    bool (*useRoad)(void *data, City *city, City *next);
+    /// Passed to the functions.
+    void *data;
+}SearchGuide;
+
+/**
+    @brief
+        Compares two distances.
+    @param[out] ret - -1 if 'v1' is better, 1 if 'v2' is better
+        and 0 if they are equal. NULL is worse than every distance.
+ */
+void distanceComparator(void *v1, void *v2, int *ret);
+
+/**
+    @brief
+        Creates a new workspace.
+    @return
+        A pointer to the workspace or NULL if
+        the memory could not be allocated.
+ */
+SearchWorkspace *newSearchWorkspace(void);
+
+/**
+    @brief
+        Destroys the workspace.
+ */
+void destroySearchWorkspace(SearchWorkspace *ws);
+
+/**
+    @brief
+        Finds the shortest route from the city 'from' to the city 'to'
+        which omits the 'forbidden' cities('from' is never forbidden).
+        Of the routes with the same length the one with the newest
+        oldest road is chosen. Going back from 'to', every city of
+        the route has to have only one best road leading to it(of
+        the routes from 'from' to the city), otherwise the search
+        fails.
+    @param[in] cities - number of the cities in the map, the ids of
+        the cities are smaller.
+    @param[out] dst - the distance to 'to' if the route was found,
+        'from' with distance INT_MAX if 'to' can not be reached, or
+        NULL city if the choice is ambiguous or the memory could
+        not be allocated.
+    @return
+        A vector of the roads from 'from' to 'to' or NULL
+        if the route could not be found.
+ */
+vector *searchRoute(SearchWorkspace *ws, int cities, City *from, City *to,
+                    vector *forbidden, Distance *dst);
+
+/**
+    @brief
+        Finds at once the shortest route from the city 'from' to
+        the city 'to1' and the shortest route from the city 'to2'
+        to 'from'(see @ref searchRoute), the same as the two searches
+        started at 'from' and 'to2'. Neither route goes through the
+        other target and every city is labelled once for both of them.
+    @param[out] roads1 - the roads from 'from' to 'to1' or NULL;
+    @param[out] dst1 - the distance to 'to1' as in @ref searchRoute;
+    @param[out] roads2 - the roads from 'to2' to 'from' or NULL;
+    @param[out] dst2 - the distance to 'from' as in @ref searchRoute
+        started at 'to2'.
+    @return
+        @p false if the parameters are wrong or the memory
+        could not be allocated, and @p true otherwise.
+ */
+bool searchTwoRoutes(SearchWorkspace *ws, int cities, City *from, City *to1, City *to2,
+                     vector *forbidden, vector **roads1, Distance *dst1,
+                     vector **roads2, Distance *dst2);
+
+/**
+    @brief
+        Starts the search of the shortest route from the city
+        'from' to the city 'to'(see @ref searchRoute), which is
+        carried out by @ref continueRouteSearch. A search started
+        earlier with the workspace is abandoned.
+    @return
+        @p false if the parameters are wrong or the memory
+        could not be allocated, and @p true otherwise.
+ */
+bool startRouteSearch(SearchWorkspace *ws, int cities, City *from, City *to,
+                      vector *forbidden);
+
+/**
+    @brief
+        Continues the search until the target is reached, or
+        all cities not further than 'bound' from the start are
+        labelled. The search can be continued with a greater
+        bound, without repeating the work.
+    @return
+        1 if the search is finished(the target is reached or can
+        not be reached), 0 if the target is further than 'bound'
+        and -1 if the memory could not be allocated.
+ */
+int continueRouteSearch(SearchWorkspace *ws, unsigned bound);
+
+/**
+    @brief
+        Continues the 'count' searches(see @ref continueRouteSearch)
+        with the workspaces 'ws' and the 'bounds' in turns, in the
+        calling thread. Each search makes a small step and asks the
+        processor to load the memory of its next step, which is
+        loaded while the other searches run.
+    @param[out] results - the results of the searches, as
+        returned by @ref continueRouteSearch.
+ */
+void continueRouteSearches(SearchWorkspace **ws, unsigned *bounds, int *results, int count);
+
+/**
+    @brief
+        Creates the result of the finished search(see @ref searchRoute).
+    @param[in] to - the target given to @ref startRouteSearch.
+ */
+vector *finishRouteSearch(SearchWorkspace *ws, City *to, Distance *dst);
+
+/**
+    @brief
+        Creates the route from the city 'from' to the start of the
+        finished search, the same as the search started at 'from'
+        would find(see @ref searchRoute), if the forbidden cities
+        and the other targets are the same.
+    @param[out] dst - the distance to the start of the search as in
+        @ref searchRoute started at 'from'.
+ */
+vector *finishReversedRouteSearch(SearchWorkspace *ws, City *from, Distance *dst);
+
+/**
+    @brief
+        Finds the shortest routes from the city 'from' to all
+        cities, so that @ref finishRouteSearch can be called for
+        any of them until the map changes.
+    @return
+        @p false if the parameters are wrong or the memory
+        could not be allocated, and @p true otherwise.
+ */
+bool searchAllRoutes(SearchWorkspace *ws, int cities, City *from);
+
+/**
+    @brief
+        Finds the same routes as @ref searchAllRoutes with all
+        threads of the 'pool' at once. Without the pool(or with
+        one thread) the search is run by the calling thread.
+    @return
+        @p false if the parameters are wrong or the memory
+        could not be allocated, and @p true otherwise.
+ */
+bool searchAllRoutesParallel(SearchWorkspace *ws, int cities, City *from, ThreadPool *pool);
+
+/**
+    @brief
+        Finds the shortest routes from the city 'from' to the
+        'count' cities in 'targets', so that @ref finishRouteSearch
+        and @ref finishRouteCheck can be called for them. Unlike
+        in @ref searchTwoRoutes, the routes can go through the
+        other targets. Without the targets all cities are labelled.
+    @return
+        @p false if the parameters are wrong or the memory
+        could not be allocated, and @p true otherwise.
+ */
+bool searchManyRoutes(SearchWorkspace *ws, int cities, City *from, City **targets, int count);
+
+/**
+    @brief
+        Starts the search of @ref searchManyRoutes, which is
+        carried out by @ref continueRouteSearch.
+    @return
+        @p false if the parameters are wrong or the memory
+        could not be allocated, and @p true otherwise.
+ */
+bool startManyRouteSearch(SearchWorkspace *ws, int cities, City *from,
+                          City **targets, int count);
+
+/**
+    @brief
+        Checks whether the route of the finished search to the
+        city 'to' can be chosen(see @ref searchRoute), without
+        creating it.
+    @param[out] dst - the distance to 'to', or 'from' with distance
+        INT_MAX if 'to' can not be reached.
+    @return
+        1 if the route can be chosen, 2 if the choice is ambiguous,
+        0 if 'to' can not be reached and -1 if the memory could
+        not be allocated.
+ */
+int finishRouteCheck(SearchWorkspace *ws, City *to, Distance *dst);
+
+/**
+    @brief
+        Checks whether the route from the city 'from' to the start
+        of the finished search can be chosen, as in
+        @ref finishReversedRouteSearch, without creating it.
+    @param[out] dst - the distance as in @ref finishReversedRouteSearch.
+    @return
+        The same as @ref finishRouteCheck.
+ */
+int finishReversedRouteCheck(SearchWorkspace *ws, City *from, Distance *dst);
+
+/**
+    @brief
+        Finds the cities not further than 'bound' from the city
+        'from' and gives them to 'visit', nearest first(starting
+        with 'from'), as soon as their distance is known. Only the
+        cities given to 'visit' and their neighbours are labelled.
+    @param[in] data - passed to 'visit'.
+    @return
+        @p false if the parameters are wrong or the memory
+        could not be allocated(some cities may be given to
+        'visit' before), and @p true otherwise.
+ */
+bool searchWithin(SearchWorkspace *ws, int cities, City *from, unsigned bound,
+                  void (*visit)(void *data, City *city, unsigned distance), void *data);
+
+/**
+    @brief
+        Finds the shortest route from the city 'from' to the city 'to'
+        which omits the 'forbidden' cities and the roads rejected by the
+        'guide', settling first the cities nearest to 'to' by its estimate.
+        The route continues a way whose oldest road is 'oldestRoad', and
+        of the routes with the same length the one with the newest oldest
+        road is found. Its distance is given by @ref finishRouteDistance
+        and its cities by @ref previousCity.
+    @return
+        1 if the route was found, 0 if 'to' can not be reached
+        and -1 if the parameters are wrong or the memory could
+        not be allocated.
+ */
+int searchGuided(SearchWorkspace *ws, int cities, City *from, City *to, int oldestRoad,
+                 vector *forbidden, const SearchGuide *guide);
+
+/**
+    @brief
+        Returns the city before 'city' on the route found by the
+        last @ref searchGuided(NULL for its start or if 'city'
+        was not reached).
+ */
+City *previousCity(SearchWorkspace *ws, City *city);
+
+/**
+    @brief
+        Reads the distance to the city 'to' found by the finished
+        search, without checking the best route.
+    @param[out] dst - the distance to 'to', or 'from' with distance
+        INT_MAX if 'to' can not be reached(NULL city if the
+        parameters are wrong).
+ */
+void finishRouteDistance(SearchWorkspace *ws, City *to, Distance *dst);
+
+/**
+    @brief
+        Checks whether the road between the cities 'a' and 'b'
+        with the given length, added, removed or repaired after
+        the last search of the workspace, may change the routes
+        found by it. A road longer than the difference of the
+        distances of its cities does not change them.
+ */
+bool roadChangesRoutes(SearchWorkspace *ws, City *a, City *b, int length);
+
+/**
+    @brief
+        Returns the number of the cities settled by all
+        searches with the workspace.
+ */
+unsigned long long settledCities(SearchWorkspace *ws);
+
+#endif /* Search_h */
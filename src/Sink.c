@@ -0,0 +1,71 @@
+/** @file Sink.c
+ *  Buffer of the text given to a function in large parts.
+ *
+ * @author Cezary Chodun
+ */
+
+#include "Sink.h"
+
+#include <string.h>
+
+void initSink(Sink *sink, void (*write)(void *data, const char *text, size_t size),
+              void *data) {
+    sink->write = write;
+    sink->data = data;
+    sink->size = 0;
+}
+
+void flushSink(Sink *sink) {
+    if (sink->size == 0)
+        return;
+
+    sink->buffer[sink->size] = '\0';
+    sink->write(sink->data, sink->buffer, sink->size);
+    sink->size = 0;
+}
+
+void putSinkChar(Sink *sink, char c) {
+    if (sink->size == SINK_BUFFER)
+        flushSink(sink);
+    sink->buffer[sink->size++] = c;
+}
+
+void putSinkString(Sink *sink, const char *s) {
+    size_t size = strlen(s);
+
+    while (size > 0) {
+        if (sink->size == SINK_BUFFER)
+            flushSink(sink);
+
+        size_t part = SINK_BUFFER - sink->size;
+        if (part > size)
+            part = size;
+
+        memcpy(sink->buffer + sink->size, s, part);
+        sink->size += part;
+        s += part;
+        size -= part;
+    }
+}
+
+void putSinkUInt(Sink *sink, unsigned long long val) {
+    char digits[20];
+    int size = 0;
+
+    do {
+        digits[size++] = (char) ('0' + val % 10);
+        val /= 10;
+    } while (val > 0);
+
+    while (size > 0)
+        putSinkChar(sink, digits[--size]);
+}
+
+void putSinkInt(Sink *sink, long long val) {
+    if (val < 0) {
+        putSinkChar(sink, '-');
+        putSinkUInt(sink, 0ull - (unsigned long long) val);
+    }
+    else
+        putSinkUInt(sink, (unsigned long long) val);
+}
@@ -0,0 +1,69 @@
+/** @file Sink.h
+ *  Interface of the 'Sink', which collects text in a buffer of
+ *  a fixed size and gives it to a function in large parts. The
+ *  sink does not allocate memory, so it can be kept on the stack.
+ *
+ * @author Cezary Chodun
+ */
+
+#ifndef Sink_h
+#define Sink_h
+
+#include <stddef.h>
+
+/// @private Size of the buffer of a sink.
+#define SINK_BUFFER 8192
+
+/**
+    Text waiting to be given to the function.
+ */
+typedef struct Sink{
+    /// Function receiving the text(not ended by '\0').
+    void (*write)(void *data, const char *text, size_t size);
+    /// Data passed to 'write'.
+    void *data;
+    /// Number of the characters in 'buffer'.
+    size_t size;
+    /// The text, with place for '\0' after it.
+    char buffer[SINK_BUFFER + 1];
+}Sink;
+
+/**
+    @brief
+        Prepares the sink giving the text to 'write' with 'data'.
+ */
+void initSink(Sink *sink, void (*write)(void *data, const char *text, size_t size),
+              void *data);
+
+/**
+    @brief
+        Gives the collected text to the function. The text
+        is followed by '\0', which is not counted in its size.
+ */
+void flushSink(Sink *sink);
+
+/**
+    @brief
+        Adds the character to the sink.
+ */
+void putSinkChar(Sink *sink, char c);
+
+/**
+    @brief
+        Adds the C string to the sink.
+ */
+void putSinkString(Sink *sink, const char *s);
+
+/**
+    @brief
+        Adds the decimal form of the number to the sink.
+ */
+void putSinkUInt(Sink *sink, unsigned long long val);
+
+/**
+    @brief
+        Adds the decimal form of the number to the sink.
+ */
+void putSinkInt(Sink *sink, long long val);
+
+#endif /* Sink_h */
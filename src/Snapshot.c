@@ -0,0 +1,145 @@
+/** @file Snapshot.c
+ *  Snapshot files which store the whole Map.
+ *
+ *  File layout:
+ *  magic "BLNS", version(1 byte), lsn(8 bytes), size of
+ *  the map data(8 bytes), checksum of the map data(4 bytes),
+ *  the map data(see @ref encodeMap).
+ *
+ * @author Cezary Chodun
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "Snapshot.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "ByteBuffer.h"
+
+/// @private
+static const char SNAPSHOT_MAGIC[4] = {'B', 'L', 'N', 'S'};
+/// @private
+static const unsigned char SNAPSHOT_VERSION = 1;
+/// @private Size of the header(magic, version, lsn, size, checksum).
+static const size_t SNAPSHOT_HEADER = 4 + 1 + 8 + 8 + 4;
+
+bool syncDirectoryOf(const char *path) {
+    size_t size = strlen(path);
+    char *dir = (char*) malloc(size + 2);
+    if (dir == NULL)
+        return false;
+
+    memcpy(dir, path, size + 1);
+    char *slash = strrchr(dir, '/');
+    if (slash == NULL)
+        strcpy(dir, ".");
+    else if (slash == dir)
+        dir[1] = '\0';
+    else
+        slash[0] = '\0';
+
+    int fd = open(dir, O_RDONLY);
+    free(dir);
+    if (fd < 0)
+        return false;
+
+    bool ok = (fsync(fd) == 0);
+    close(fd);
+    return ok;
+}
+
+bool writeSnapshot(Map *map, const char *path, uint64_t lsn) {
+    if (map == NULL || path == NULL)
+        return false;//Wrong parameters
+
+    ByteBuffer *body = newByteBuffer(1 << 16);
+    ByteBuffer *header = newByteBuffer(SNAPSHOT_HEADER);
+    size_t pathSize = strlen(path);
+    char *tmpPath = (char*) malloc(pathSize + 5);
+
+    bool err = (body == NULL || header == NULL || tmpPath == NULL);
+    if (!err)
+        err = !encodeMap(map, body);
+
+    if (!err) {
+        putBytes(header, SNAPSHOT_MAGIC, 4);
+        putByte(header, SNAPSHOT_VERSION);
+        putU64(header, lsn);
+        putU64(header, byteBufferSize(body));
+        err = (putU32(header, checksumBytes(byteBufferData(body),
+                                            byteBufferSize(body))) == NULL);
+    }
+
+    int fd = -1;
+    if (!err) {
+        memcpy(tmpPath, path, pathSize);
+        strcpy(tmpPath + pathSize, ".tmp");
+
+        fd = open(tmpPath, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        err = (fd < 0);
+    }
+
+    if (!err) {
+        err |= !writeByteBuffer(header, fd);
+        err |= !writeByteBuffer(body, fd);
+        err |= (fsync(fd) != 0);
+    }
+    if (fd >= 0)
+        err |= (close(fd) != 0);
+
+    if (!err)
+        err = (rename(tmpPath, path) != 0);
+    else if (fd >= 0)
+        unlink(tmpPath);
+    if (!err)
+        err = !syncDirectoryOf(path);
+
+    free(tmpPath);
+    destroyByteBuffer(header);
+    destroyByteBuffer(body);
+
+    return !err;
+}
+
+Map *readSnapshot(const char *path, uint64_t *lsn) {
+    if (path == NULL || lsn == NULL)
+        return NULL;//Wrong parameters
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return NULL;
+
+    ByteBuffer *data = newByteBuffer(1 << 16);
+    bool err = (data == NULL || !readByteBuffer(data, fd));
+    close(fd);
+
+    ByteReader in;
+    char magic[4];
+    unsigned char version;
+    uint64_t size;
+    uint32_t checksum;
+
+    Map *map = NULL;
+    if (!err) {
+        initByteReader(&in, byteBufferData(data), byteBufferSize(data));
+
+        for (int i = 0; i < 4 && !err; i++)
+            err = !getByte(&in, (unsigned char*) &magic[i]);
+        err = err || memcmp(magic, SNAPSHOT_MAGIC, 4) != 0;
+        err = err || !getByte(&in, &version) || version != SNAPSHOT_VERSION;
+        err = err || !getU64(&in, lsn) || !getU64(&in, &size);
+        err = err || !getU32(&in, &checksum) || size != in.size - in.pos;
+        err = err || checksum != checksumBytes(in.data + in.pos, size);
+    }
+
+    if (!err)
+        map = decodeMap(&in);
+
+    destroyByteBuffer(data);
+    return map;
+}
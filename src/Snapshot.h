@@ -0,0 +1,55 @@
+/** @file Snapshot.h
+ *  Interface for the snapshot files which store the whole Map.
+ *
+ * @author Cezary Chodun
+ */
+
+#ifndef Snapshot_h
+#define Snapshot_h
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "map.h"
+
+/**
+    @brief
+        Writes the map to the snapshot file.
+        The data is first written to a temporary file,
+        which replaces 'path' only after it is safely
+        stored on the disk, so the previous snapshot
+        survives a failed write.
+    @param[in] map  - the map;
+    @param[in] path - path of the snapshot file;
+    @param[in] lsn  - number of the last journal record
+                      reflected in the map.
+    @return
+        @p true if the snapshot was written and
+        @p false otherwise.
+ */
+bool writeSnapshot(Map *map, const char *path, uint64_t lsn);
+
+/**
+    @brief
+        Reads the map from the snapshot file.
+    @param[in] path - path of the snapshot file;
+    @param[out] lsn - number of the last journal record
+                      reflected in the map.
+    @return
+        A pointer to the map, or NULL if the file could
+        not be read or is damaged.
+ */
+Map *readSnapshot(const char *path, uint64_t *lsn);
+
+/**
+    @brief
+        Flushes the directory containing 'path', so
+        that a renamed or created file is not lost
+        after a crash.
+    @return
+        @p true if the operation was successful and
+        @p false otherwise.
+ */
+bool syncDirectoryOf(const char *path);
+
+#endif /* Snapshot_h */
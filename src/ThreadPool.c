@@ -0,0 +1,202 @@
+/** @file ThreadPool.c
+ *  Threads running independent tasks.
+ *
+ *  The tasks of a batch are numbered and every thread takes
+ *  the next free number until none is left, so the threads
+ *  which finish early take more tasks.
+ *
+ * @author Cezary Chodun
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "ThreadPool.h"
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <unistd.h>
+
+/// @private Limit of the threads chosen automatically.
+#define MAX_AUTO_THREADS 8
+
+/// @private
+typedef struct Worker{
+    /// The pool.
+    struct ThreadPool *pool;
+    /// Number of the thread(greater than 0).
+    int number;
+    /// The thread.
+    pthread_t thread;
+}Worker;
+
+/// Threads running the tasks.
+typedef struct ThreadPool{
+    /// Number of the threads including the calling thread.
+    int size;
+    /// Threads besides the calling one(size - 1).
+    Worker *workers;
+
+    /// Guards the fields below.
+    pthread_mutex_t lock;
+    /// Signals a new batch or the end of the pool.
+    pthread_cond_t start;
+    /// Signals the end of the batch.
+    pthread_cond_t finish;
+    /// Number of the current batch.
+    unsigned long long batch;
+    /// Number of the workers still running the batch.
+    int running;
+    /// Whether the threads should end.
+    bool stop;
+
+    /// Task of the batch.
+    PoolTask task;
+    /// Data of the task.
+    void *data;
+    /// Number of the tasks.
+    int count;
+    /// The next task to take.
+    atomic_int next;
+}ThreadPool;
+
+/// @private Runs the tasks of the current batch.
+static void runTasks(ThreadPool *pool, int number) {
+    int index;
+    while ((index = atomic_fetch_add(&pool->next, 1)) < pool->count)
+        pool->task(pool->data, index, number);
+}
+
+/// @private
+static void *workerMain(void *arg) {
+    Worker *worker = (Worker*) arg;
+    ThreadPool *pool = worker->pool;
+    unsigned long long batch = 0;
+
+    pthread_mutex_lock(&pool->lock);
+    while (true) {
+        while (!pool->stop && pool->batch == batch)
+            pthread_cond_wait(&pool->start, &pool->lock);
+        if (pool->stop)
+            break;
+
+        batch = pool->batch;
+        pthread_mutex_unlock(&pool->lock);
+
+        runTasks(pool, worker->number);
+
+        pthread_mutex_lock(&pool->lock);
+        if (--pool->running == 0)
+            pthread_cond_signal(&pool->finish);
+    }
+    pthread_mutex_unlock(&pool->lock);
+
+    return NULL;
+}
+
+/// @private Stops the first 'started' workers.
+static void stopWorkers(ThreadPool *pool, int started) {
+    pthread_mutex_lock(&pool->lock);
+    pool->stop = true;
+    pthread_cond_broadcast(&pool->start);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (int i = 0; i < started; i++)
+        pthread_join(pool->workers[i].thread, NULL);
+}
+
+ThreadPool *newThreadPool(int threads) {
+    if (threads <= 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = (cpus < 1 ? 1 : (cpus > MAX_AUTO_THREADS ? MAX_AUTO_THREADS : (int) cpus));
+    }
+
+    ThreadPool *out = (struct ThreadPool*) malloc(sizeof(ThreadPool));
+    if (out == NULL)
+        return NULL;
+
+    out->size = threads;
+    out->workers = (Worker*) malloc(sizeof(Worker) * threads);
+    if (out->workers == NULL) {
+        free(out);
+        return NULL;
+    }
+
+    out->batch = 0;
+    out->running = 0;
+    out->stop = false;
+    out->task = NULL;
+    out->data = NULL;
+    out->count = 0;
+    atomic_init(&out->next, 0);
+
+    if (pthread_mutex_init(&out->lock, NULL) != 0) {
+        free(out->workers);
+        free(out);
+        return NULL;
+    }
+    pthread_cond_init(&out->start, NULL);
+    pthread_cond_init(&out->finish, NULL);
+
+    for (int i = 0; i < threads - 1; i++) {
+        Worker *worker = &out->workers[i];
+        worker->pool = out;
+        worker->number = i + 1;
+
+        if (pthread_create(&worker->thread, NULL, &workerMain, worker) != 0) {
+            out->size = i + 1;//Only the started threads are stopped
+            destroyThreadPool(out);
+            return NULL;
+        }
+    }
+
+    return out;
+}
+
+void destroyThreadPool(ThreadPool *pool) {
+    if (pool == NULL)
+        return;
+
+    stopWorkers(pool, pool->size - 1);
+
+    pthread_cond_destroy(&pool->start);
+    pthread_cond_destroy(&pool->finish);
+    pthread_mutex_destroy(&pool->lock);
+    free(pool->workers);
+    free(pool);
+}
+
+int threadPoolSize(ThreadPool *pool) {
+    if (pool == NULL)
+        return 0;
+    return pool->size;
+}
+
+void runThreadPool(ThreadPool *pool, PoolTask task, void *data, int count) {
+    if (pool == NULL || task == NULL || count <= 0)
+        return;
+
+    if (pool->size == 1 || count == 1) {//Waking the threads would cost more
+        for (int i = 0; i < count; i++)
+            task(data, i, 0);
+        return;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    pool->task = task;
+    pool->data = data;
+    pool->count = count;
+    atomic_store(&pool->next, 0);
+    pool->running = pool->size - 1;
+    pool->batch++;
+    pthread_cond_broadcast(&pool->start);
+    pthread_mutex_unlock(&pool->lock);
+
+    runTasks(pool, 0);
+
+    pthread_mutex_lock(&pool->lock);
+    while (pool->running > 0)
+        pthread_cond_wait(&pool->finish, &pool->lock);
+    pthread_mutex_unlock(&pool->lock);
+}
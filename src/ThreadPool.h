@@ -0,0 +1,58 @@
+/** @file ThreadPool.h
+ *  Interface for the 'ThreadPool' class, a set of threads which
+ *  run independent tasks together with the calling thread.
+ *
+ * @author Cezary Chodun
+ */
+
+#ifndef ThreadPool_h
+#define ThreadPool_h
+
+/// @private
+typedef struct ThreadPool ThreadPool;
+
+/**
+    @brief
+        Task run by the pool.
+    @param[in] data     - data given to @ref runThreadPool;
+    @param[in] index    - number of the task;
+    @param[in] thread   - number of the thread running the task,
+        0 for the calling thread. No two tasks with the same
+        'thread' run at once.
+ */
+typedef void (*PoolTask)(void *data, int index, int thread);
+
+/**
+    @brief
+        Creates a new pool.
+    @param[in] threads - number of the threads running the tasks,
+        including the calling thread. If it is not positive,
+        one thread per processor is used.
+    @return
+        A pointer to the pool or NULL if the memory could
+        not be allocated or the threads could not be started.
+ */
+ThreadPool *newThreadPool(int threads);
+
+/**
+    @brief
+        Stops the threads and destroys the pool.
+ */
+void destroyThreadPool(ThreadPool *pool);
+
+/**
+    @brief
+        Returns the number of the threads running the tasks,
+        including the calling thread.
+ */
+int threadPoolSize(ThreadPool *pool);
+
+/**
+    @brief
+        Runs the tasks with numbers from 0 to count - 1 and
+        waits until all of them finish. The calling thread
+        runs the tasks as well.
+ */
+void runThreadPool(ThreadPool *pool, PoolTask task, void *data, int count);
+
+#endif /* ThreadPool_h */
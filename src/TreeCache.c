@@ -0,0 +1,123 @@
+/** @file TreeCache.c
+ *  Trees of the shortest routes from the recently used cities.
+ *
+ *  A tree stays valid as long as the changed roads are longer than
+ *  the differences of the distances of their cities, because such
+ *  roads do not lie on any best route. Only the trees which a road
+ *  may change are removed, the others keep answering.
+ *
+ * @author Cezary Chodun
+ */
+
+#include "TreeCache.h"
+
+#include <stdlib.h>
+
+/// @private A tree in the cache.
+typedef struct CachedTree{
+    /// Start of the routes(NULL if the place is free).
+    City *from;
+    /// Number of the cities in the map when the tree was found.
+    int cities;
+    /// Number of the last use of the tree.
+    unsigned long long used;
+    /// The finished search(NULL until the place is used).
+    SearchWorkspace *ws;
+}CachedTree;
+
+/// Cache of the trees of the routes.
+typedef struct TreeCache{
+    /// Number of the places for the trees.
+    int size;
+    /// The trees.
+    CachedTree *trees;
+    /// Number of the last use of any tree.
+    unsigned long long uses;
+}TreeCache;
+
+TreeCache *newTreeCache(int size) {
+    if (size <= 0)
+        return NULL;
+
+    TreeCache *out = (struct TreeCache*) malloc(sizeof(TreeCache));
+    if (out == NULL)
+        return NULL;
+
+    out->trees = (CachedTree*) calloc(size, sizeof(CachedTree));
+    if (out->trees == NULL) {
+        free(out);
+        return NULL;
+    }
+
+    out->size = size;
+    out->uses = 0;
+
+    return out;
+}
+
+void destroyTreeCache(TreeCache *cache) {
+    if (cache == NULL)
+        return;
+
+    for (int i = 0; i < cache->size; i++)
+        destroySearchWorkspace(cache->trees[i].ws);
+    free(cache->trees);
+    free(cache);
+}
+
+SearchWorkspace *findTreeCache(TreeCache *cache, City *from, int cities) {
+    if (cache == NULL || from == NULL)
+        return NULL;
+
+    for (int i = 0; i < cache->size; i++) {
+        CachedTree *tree = &cache->trees[i];
+        if (tree->from == from && tree->cities == cities) {
+            tree->used = ++cache->uses;
+            return tree->ws;
+        }
+    }
+
+    return NULL;
+}
+
+SearchWorkspace *addTreeCache(TreeCache *cache, City *from, int cities, ThreadPool *pool) {
+    if (cache == NULL || from == NULL)
+        return NULL;
+
+    //A free place or the tree used least recently
+    CachedTree *tree = &cache->trees[0];
+    for (int i = 0; i < cache->size && tree->from != NULL; i++)
+        if (cache->trees[i].from == NULL || cache->trees[i].used < tree->used)
+            tree = &cache->trees[i];
+
+    tree->from = NULL;
+    if (tree->ws == NULL && (tree->ws = newSearchWorkspace()) == NULL)
+        return NULL;
+    if (!searchAllRoutesParallel(tree->ws, cities, from, pool))
+        return NULL;
+
+    tree->from = from;
+    tree->cities = cities;
+    tree->used = ++cache->uses;
+
+    return tree->ws;
+}
+
+void changeRoadTreeCache(TreeCache *cache, City *a, City *b, int length) {
+    if (cache == NULL)
+        return;
+
+    for (int i = 0; i < cache->size; i++) {
+        CachedTree *tree = &cache->trees[i];
+        if (tree->from != NULL && roadChangesRoutes(tree->ws, a, b, length))
+            tree->from = NULL;
+    }
+}
+
+void clearTreeCache(TreeCache *cache) {
+    if (cache == NULL)
+        return;
+
+    for (int i = 0; i < cache->size; i++)
+        cache->trees[i].from = NULL;
+}
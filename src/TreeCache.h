@@ -0,0 +1,73 @@
+/** @file TreeCache.h
+ *  Interface for the 'TreeCache' class, which keeps the shortest
+ *  routes from the recently used cities to all other cities
+ *  (see @ref searchAllRoutes). When the cache is full, the tree
+ *  used least recently is replaced.
+ *
+ * @author Cezary Chodun
+ */
+
+#ifndef TreeCache_h
+#define TreeCache_h
+
+#include <stdbool.h>
+
+#include "City.h"
+#include "Search.h"
+#include "ThreadPool.h"
+
+/// @private
+typedef struct TreeCache TreeCache;
+
+/**
+    @brief
+        Creates a cache for at most 'size' trees.
+    @return
+        A pointer to the cache or NULL if the
+        memory could not be allocated.
+ */
+TreeCache *newTreeCache(int size);
+
+/**
+    @brief
+        Destroys the cache.
+ */
+void destroyTreeCache(TreeCache *cache);
+
+/**
+    @brief
+        Finds the tree of the routes from the city 'from'.
+    @param[in] cities - the current number of the cities in the map.
+    @return
+        The workspace of the finished search(see @ref finishRouteSearch)
+        or NULL if the tree is not in the cache.
+ */
+SearchWorkspace *findTreeCache(TreeCache *cache, City *from, int cities);
+
+/**
+    @brief
+        Finds the routes from the city 'from' and adds
+        their tree to the cache.
+    @param[in] cities - the current number of the cities in the map;
+    @param[in] pool - the threads finding the routes together
+        (see @ref searchAllRoutesParallel) or NULL.
+    @return
+        The workspace of the finished search(see @ref finishRouteSearch)
+        or NULL if the memory could not be allocated.
+ */
+SearchWorkspace *addTreeCache(TreeCache *cache, City *from, int cities, ThreadPool *pool);
+
+/**
+    @brief
+        Removes the trees which may be changed by the road between
+        the cities 'a' and 'b'(see @ref roadChangesRoutes).
+ */
+void changeRoadTreeCache(TreeCache *cache, City *a, City *b, int length);
+
+/**
+    @brief
+        Removes all trees, after many roads were changed at once.
+ */
+void clearTreeCache(TreeCache *cache);
+
+#endif /* TreeCache_h */
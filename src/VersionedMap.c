@@ -0,0 +1,338 @@
+/** @file VersionedMap.c
+ *  Immutable views of the routes published with epoch
+ *  based reclamation.
+ *
+ *  Every reader occupies a slot with the global epoch it has seen
+ *  when it started. A writer publishes a new table of views, moves
+ *  the global epoch forward and retires the replaced objects with
+ *  the epoch from before the move. A retired object is freed when
+ *  every occupied slot holds a later epoch, because such readers
+ *  started after the new table had been published.
+ *
+ * @author Cezary Chodun
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "VersionedMap.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <sched.h>
+
+/// @private Number of the readers which can read at once.
+#define READER_SLOTS 128
+/// @private Size of the table of views(route ids are below 1000).
+#define ROUTE_SLOTS 1000
+/// @private Size of the cache line, the slots do not share lines.
+#define CACHE_LINE 64
+
+/// @private Immutable view of a route.
+typedef struct RouteView{
+    /// Stamp of the route version(see @ref getMapRouteVersion).
+    unsigned long long version;
+    /// Description of the route.
+    char *description;
+}RouteView;
+
+/// @private Published version of the map.
+typedef struct RouteTable{
+    /// Views of the routes, indexed by the route id.
+    RouteView *views[ROUTE_SLOTS];
+}RouteTable;
+
+/// @private Epoch seen by a reader(0 if the slot is free).
+typedef struct ReaderSlot{
+    /// The epoch.
+    atomic_uint_least64_t epoch;
+    /// Fills the rest of the cache line.
+    char padding[CACHE_LINE - sizeof(atomic_uint_least64_t)];
+}ReaderSlot;
+
+/// @private Object waiting until no reader can see it.
+typedef struct Retired{
+    /// The object.
+    void *ptr;
+    /// Whether it is a RouteTable(or a RouteView).
+    bool table;
+    /// The last epoch in which it was published.
+    uint64_t epoch;
+}Retired;
+
+/// Map with published views of the routes.
+typedef struct VersionedMap{
+    /// Slots of the readers.
+    ReaderSlot slots[READER_SLOTS];
+    /// The global epoch(starts with 1).
+    atomic_uint_least64_t epoch;
+    /// The published table.
+    _Atomic(RouteTable*) current;
+    /// The map.
+    Map *map;
+    /// Lets in one writer at a time.
+    pthread_mutex_t writer;
+    /// Retired objects(Retired*), used only by the writer.
+    vector *retired;
+}VersionedMap;
+
+/// @private
+static void destroyView(RouteView *view) {
+    if (view == NULL)
+        return;
+
+    free(view->description);
+    free(view);
+}
+
+/// @private
+static RouteView *newView(Map *map, unsigned routeId, unsigned long long version) {
+    RouteView *out = (struct RouteView*) malloc(sizeof(RouteView));
+    if (out == NULL)
+        return NULL;
+
+    out->version = version;
+    out->description = (char*) getRouteDescription(map, routeId);
+    if (out->description == NULL) {
+        free(out);
+        return NULL;
+    }
+
+    return out;
+}
+
+/// @private
+static void freeRetired(Retired *r) {
+    if (r->table)
+        free(r->ptr);
+    else
+        destroyView(r->ptr);
+    free(r);
+}
+
+/// @private
+static bool retire(VersionedMap *vmap, void *ptr, bool table, uint64_t epoch) {
+    Retired *r = (struct Retired*) malloc(sizeof(Retired));
+    if (r == NULL)
+        return false;
+
+    r->ptr = ptr;
+    r->table = table;
+    r->epoch = epoch;
+    if (pushBackVec(vmap->retired, r) == NULL) {
+        free(r);
+        return false;
+    }
+    return true;
+}
+
+/// @private Frees the retired objects which no reader can see.
+static void reclaim(VersionedMap *vmap) {
+    uint64_t oldest = UINT64_MAX;
+    for (int i = 0; i < READER_SLOTS; i++) {
+        uint64_t e = atomic_load(&vmap->slots[i].epoch);
+        if (e != 0 && e < oldest)
+            oldest = e;
+    }
+
+    for (int i = 0; i < vecSize(vmap->retired); i++) {
+        Retired *r = getVec(vmap->retired, i);
+        if (r->epoch < oldest) {
+            freeRetired(r);
+            removeVec(vmap->retired, i);
+            i--;
+        }
+    }
+}
+
+/**
+    @private
+    @brief
+        Creates a table with the views of the routes which changed
+        since the 'old' table was published. Replaced views are
+        added to 'replaced'. If a view can not be created,
+        the old one is kept.
+    @return
+        The new table, 'old' if nothing changed or NULL if
+        the memory could not be allocated.
+ */
+static RouteTable *nextTable(Map *map, RouteTable *old, vector *replaced) {
+    RouteTable *out = old;
+
+    for (unsigned id = 1; id < ROUTE_SLOTS; id++) {
+        unsigned long long version = getMapRouteVersion(map, id);
+        RouteView *view = old->views[id];
+        if ((view == NULL ? 0 : view->version) == version)
+            continue;
+
+        RouteView *next = NULL;
+        if (version != 0 && (next = newView(map, id, version)) == NULL)
+            continue;//Out of memory, the old view stays until the next update
+
+        if (out == old) {
+            out = (struct RouteTable*) malloc(sizeof(RouteTable));
+            if (out == NULL) {
+                destroyView(next);
+                return NULL;
+            }
+            memcpy(out, old, sizeof(RouteTable));
+        }
+
+        out->views[id] = next;
+        if (view != NULL && pushBackVec(replaced, view) == NULL)
+            out->views[id] = view;//Can not be retired, so it stays
+        if (out->views[id] == view)
+            destroyView(next);
+    }
+
+    return out;
+}
+
+/// @private Publishes the changes made by the writer.
+static void publish(VersionedMap *vmap) {
+    vector *replaced = newVec(4);
+    if (replaced == NULL)
+        return;//The changes will be published by the next writer
+
+    RouteTable *old = atomic_load(&vmap->current);
+    RouteTable *next = nextTable(vmap->map, old, replaced);
+    if (next == NULL || next == old) {
+        destroyVec(replaced);
+        return;
+    }
+
+    atomic_store(&vmap->current, next);
+    uint64_t epoch = atomic_fetch_add(&vmap->epoch, 1);
+
+    //If retiring fails, the object is leaked rather than freed too early
+    retire(vmap, old, true, epoch);
+    for (int i = 0; i < vecSize(replaced); i++)
+        retire(vmap, getVec(replaced, i), false, epoch);
+
+    destroyVec(replaced);
+    reclaim(vmap);
+}
+
+VersionedMap *newVersionedMap(Map *map) {
+    if (map == NULL)
+        return NULL;
+
+    size_t size = (sizeof(VersionedMap) + CACHE_LINE - 1) / CACHE_LINE * CACHE_LINE;
+    VersionedMap *out = (struct VersionedMap*) aligned_alloc(CACHE_LINE, size);
+    if (out == NULL)
+        return NULL;
+
+    for (int i = 0; i < READER_SLOTS; i++)
+        atomic_init(&out->slots[i].epoch, 0);
+    atomic_init(&out->epoch, 1);
+    out->map = map;
+    out->retired = newVec(16);
+
+    //Views of the routes which already exist
+    vector *replaced = newVec(0);
+    RouteTable *empty = (struct RouteTable*) malloc(sizeof(RouteTable));
+    RouteTable *table = NULL;
+    if (out->retired != NULL && replaced != NULL && empty != NULL) {
+        memset(empty, 0, sizeof(RouteTable));
+        table = nextTable(map, empty, replaced);
+        if (table != empty)
+            free(empty);
+    }
+    else
+        free(empty);
+    destroyVec(replaced);
+
+    if (table == NULL || pthread_mutex_init(&out->writer, NULL) != 0) {
+        if (table != NULL)
+            for (int i = 0; i < ROUTE_SLOTS; i++)
+                destroyView(table->views[i]);
+        free(table);
+        destroyVec(out->retired);
+        free(out);
+        return NULL;
+    }
+    atomic_init(&out->current, table);
+
+    return out;
+}
+
+void deleteVersionedMap(VersionedMap *vmap) {
+    if (vmap == NULL)
+        return;
+
+    for (int i = 0; i < vecSize(vmap->retired); i++)
+        freeRetired(getVec(vmap->retired, i));
+    destroyVec(vmap->retired);
+
+    RouteTable *table = atomic_load(&vmap->current);
+    for (int i = 0; i < ROUTE_SLOTS; i++)
+        destroyView(table->views[i]);
+    free(table);
+
+    pthread_mutex_destroy(&vmap->writer);
+    deleteMap(vmap->map);
+    free(vmap);
+}
+
+Map *beginMapUpdate(VersionedMap *vmap) {
+    pthread_mutex_lock(&vmap->writer);
+    return vmap->map;
+}
+
+void endMapUpdate(VersionedMap *vmap) {
+    publish(vmap);
+    pthread_mutex_unlock(&vmap->writer);
+}
+
+bool versionedCommand(VersionedMap *vmap, bool (*command)(Map *map, vector *args),
+                      vector *args) {
+    bool out = command(beginMapUpdate(vmap), args);
+    endMapUpdate(vmap);
+    return out;
+}
+
+/// @private Occupies a free slot with the current epoch.
+static ReaderSlot *enterReader(VersionedMap *vmap) {
+    static _Thread_local unsigned hint = 0;
+
+    while (true) {
+        for (unsigned i = 0; i < READER_SLOTS; i++) {
+            unsigned x = (hint + i) % READER_SLOTS;
+            uint_least64_t expected = 0;
+            uint_least64_t epoch = atomic_load(&vmap->epoch);
+
+            if (atomic_compare_exchange_strong(&vmap->slots[x].epoch, &expected, epoch)) {
+                hint = x;
+                return &vmap->slots[x];
+            }
+        }
+
+        sched_yield();//Every slot is taken
+    }
+}
+
+/// @private
+static void leaveReader(ReaderSlot *slot) {
+    atomic_store(&slot->epoch, 0);
+}
+
+char const *versionedRouteDescription(VersionedMap *vmap, unsigned routeId) {
+    if (vmap == NULL)
+        return NULL;
+
+    ReaderSlot *slot = enterReader(vmap);
+    RouteTable *table = atomic_load(&vmap->current);
+
+    RouteView *view = (routeId < ROUTE_SLOTS ? table->views[routeId] : NULL);
+    const char *description = (view == NULL ? "" : view->description);
+
+    size_t size = strlen(description);
+    char *out = (char*) malloc(size + 1);
+    if (out != NULL)
+        memcpy(out, description, size + 1);
+
+    leaveReader(slot);
+    return out;
+}
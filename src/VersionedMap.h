@@ -0,0 +1,80 @@
+/** @file VersionedMap.h
+ *  Interface for the 'VersionedMap' class, which publishes immutable
+ *  views of the routes. Readers never wait: they see the views
+ *  published before they started, while a writer modifies the map
+ *  and prepares the next version. Old views are freed when the last
+ *  reader which could see them leaves(epoch based reclamation).
+ *
+ * @author Cezary Chodun
+ */
+
+#ifndef VersionedMap_h
+#define VersionedMap_h
+
+#include <stdbool.h>
+
+#include "map.h"
+#include "vector.h"
+
+/// @private
+typedef struct VersionedMap VersionedMap;
+
+/**
+    @brief
+        Wraps the map and publishes the views of its routes.
+        From now on the map should be used only through the
+        VersionedMap.
+    @param[in] map - the map.
+    @return
+        A pointer to the VersionedMap or NULL if the memory
+        could not be allocated.
+ */
+VersionedMap *newVersionedMap(Map *map);
+
+/**
+    @brief
+        Frees the VersionedMap, the views and the map.
+        No thread may use it at the time.
+ */
+void deleteVersionedMap(VersionedMap *vmap);
+
+/**
+    @brief
+        Gives the map for modification. Writers are executed
+        one at a time, readers are not stopped.
+        Has to be followed by @ref endMapUpdate.
+    @return
+        The map.
+ */
+Map *beginMapUpdate(VersionedMap *vmap);
+
+/**
+    @brief
+        Publishes the views of the routes changed since
+        @ref beginMapUpdate, frees the views which no reader
+        can see any more and lets in the next writer.
+ */
+void endMapUpdate(VersionedMap *vmap);
+
+/**
+    @brief
+        Executes the modifying command(one of the MapParser functions)
+        between @ref beginMapUpdate and @ref endMapUpdate.
+    @return
+        The result of the command.
+ */
+bool versionedCommand(VersionedMap *vmap, bool (*command)(Map *map, vector *args),
+                      vector *args);
+
+/**
+    @brief
+        Returns the description of the route(see @ref getRouteDescription)
+        from the last published version. Never waits for the writer.
+        The memory has to be freed with the free function.
+    @return
+        A pointer to the description(an empty string if the route
+        does not exist) or NULL if the memory could not be allocated.
+ */
+char const *versionedRouteDescription(VersionedMap *vmap, unsigned routeId);
+
+#endif /* VersionedMap_h */
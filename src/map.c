@@ -8,8 +8,10 @@
 #include "map.h"
 
 #include <stdlib.h>
+#include <string.h>
 #include <limits.h>
-#include <assert.h>
+#include <stdatomic.h>
+#include <pthread.h>
 
 #include "PriorityQueue.h"
 #include "Route.h"
@@ -17,6 +19,25 @@
 #include "Trie.h"
 #include "City.h"
 #include "Text.h"
+#include "Search.h"
+#include "ThreadPool.h"
+#include "Components.h"
+#include "TreeCache.h"
+#include "JourneyPlanner.h"
+#include "Alternatives.h"
+#include "Sink.h"
+
+/// @private Bounded log of the changes of the map(see @ref setChangeLog).
+typedef struct ChangeLog{
+    /// The change with number 'n' is kept at the position (n - 1) % capacity.
+    MapChange *changes;
+    /// Number of the kept changes(0 if the changes are not recorded).
+    unsigned capacity;
+    /// Number of the first change recorded since the log was set.
+    unsigned long long first;
+    /// Number of the last change.
+    unsigned long long last;
+}ChangeLog;
 
 /**
     A data structure containing a map of routes.
@@ -33,20 +54,120 @@ typedef struct Map{
 
     ///@private
     vector *id_ptrs;
+
+    /** Workspaces of the searches(see @ref SearchWorkspace),
+        one for every thread of the pool. */
+    vector *workspaces;
+
+    /** Threads searching for the detours in @ref removeRoad and for the routes
+        in @ref distanceMatrix and @ref newRoutes(NULL until they are needed). */
+    ThreadPool *pool;
+
+    /** Requested number of the threads(0 - one per processor). */
+    int threads;
+
+    /** Number of the searches run in turns by the calling thread,
+        when the threads are not used(1 - one after another). */
+    int interleave;
+
+    /** Number of the cities from which the trees of the routes
+        are found by all threads at once. */
+    int parallelCities;
+
+    /** Searches for the detours finished within the first radius. */
+    atomic_ullong localRepairs;
+    /** Searches for the detours finished after widening the radius. */
+    atomic_ullong widenedRepairs;
+    /** Searches for the detours which were not bounded. */
+    atomic_ullong globalRepairs;
+    /** Cities settled by the searches for the detours. */
+    atomic_ullong repairSettled;
+
+    /** Connected components of the map(see @ref Components). */
+    Components *components;
+
+    /** Whether the components have to be found again, because
+        the memory for the labels could not be allocated. */
+    bool componentsStale;
+
+    /** Trees of the routes from the recent starts of
+        the new routes(see @ref TreeCache). */
+    TreeCache *trees;
+
+    /** Stops of the routes for the journeys(see @ref JourneyPlanner,
+        NULL until a journey is planned). */
+    JourneyPlanner *journeys;
+
+    /** Stamp of the last change of the routes when the stops
+        were copied(see @ref lastRouteVersion). */
+    unsigned long long journeysVersion;
+
+    /** Search for the alternative routes(see @ref AlternativeSearch,
+        NULL until the routes are searched). */
+    AlternativeSearch *alternatives;
+
+    /** Changes of the open transaction(see @ref beginTransaction,
+        NULL if there is none). */
+    struct Transaction *transaction;
+
+    /** Guards the stored descriptions of the routes(see @ref getDescriptionRoute),
+        which are made also by the readers of a shared map. */
+    pthread_mutex_t descriptions;
+
+    /** The recorded changes(see @ref readChanges). */
+    ChangeLog changeLog;
 }Map;
 
+/// @private Number of the trees of the routes kept by the map.
+#define ROUTE_TREES 8
+/// @private Number of the searches run in turns by one thread, unless it is changed.
+#define INTERLEAVED_SEARCHES 8
+/// @private Limit of the searches run in turns by one thread.
+#define MAX_INTERLEAVED 16
+/// @private Number of the cities from which one search is run by many threads, unless it is changed.
+#define PARALLEL_SEARCH_CITIES 1000000
+
 Map *newMap() {
     Map *out = (struct Map*) malloc(sizeof(Map));
     if (out == NULL)
         return NULL;
+    if (pthread_mutex_init(&out->descriptions, NULL) != 0) {
+        free(out);
+        return NULL;
+    }
 
     out->cityNames = newTrie(260);
     out->cities = newVec(10);
     out->routes = newVec(1000);
     out->id_ptrs = newVec(10);
+    out->workspaces = newVec(1);
+    out->pool = NULL;
+    out->threads = 0;
+    out->interleave = INTERLEAVED_SEARCHES;
+    out->parallelCities = PARALLEL_SEARCH_CITIES;
+    atomic_init(&out->localRepairs, 0);
+    atomic_init(&out->widenedRepairs, 0);
+    atomic_init(&out->globalRepairs, 0);
+    atomic_init(&out->repairSettled, 0);
+    out->components = newComponents();
+    out->componentsStale = false;
+    out->trees = newTreeCache(ROUTE_TREES);
+    out->journeys = NULL;
+    out->journeysVersion = 0;
+    out->alternatives = NULL;
+    out->transaction = NULL;
+    out->changeLog.changes = NULL;
+    out->changeLog.capacity = 0;
+    out->changeLog.first = 1;
+    out->changeLog.last = 0;
+
+    if (out->workspaces != NULL)
+        pushBackVec(out->workspaces, newSearchWorkspace());
 
     if (out->cityNames == NULL || out->cities == NULL ||
-       out->routes == NULL || out->id_ptrs == NULL) {
+       out->routes == NULL || out->id_ptrs == NULL ||
+       out->workspaces == NULL || getVec(out->workspaces, 0) == NULL ||
+       out->components == NULL || out->trees == NULL) {
         deleteMap(out);
         return NULL;
     }
@@ -61,10 +182,15 @@ Map *newMap() {
 ///@private
 static Road *remRoad(City *c1, City *c2);
 
+///@private
+static ThreadPool *searchPool(Map *map, int count);
+
 void deleteMap(Map *map) {
     if (map == NULL)
         return;
 
+    rollbackTransaction(map);
+
     for (int i = 0; i < vecSize(map->routes); i++)
         destroyRoute(getVec(map->routes, i));
 
@@ -95,6 +221,17 @@ void deleteMap(Map *map) {
     if (map->id_ptrs)
         destroyVec(map->id_ptrs);
 
+    destroyThreadPool(map->pool);
+    destroyComponents(map->components);
+    destroyTreeCache(map->trees);
+    destroyJourneyPlanner(map->journeys);
+    destroyAlternativeSearch(map->alternatives);
+    for (int i = 0; i < vecSize(map->workspaces); i++)
+        destroySearchWorkspace(getVec(map->workspaces, i));
+    destroyVec(map->workspaces);
+    pthread_mutex_destroy(&map->descriptions);
+    free(map->changeLog.changes);
+
     free(map);
 }
 
@@ -187,343 +324,367 @@ static City *getCity(Map *map, const char *city) {
     return getVec(map->cities, id[0]);
 }
 
-/// @private
-typedef struct Distance{
-    City *city;
-    unsigned distance;
-    int oldestRoad;
-}Distance;
+/// @private Returns the components of the map(NULL if the memory could not be allocated).
+static Components *getComponents(Map *map) {
+    if (!map->componentsStale)
+        return map->components;
 
-/// @private
-static Distance *newDistance() {
-    Distance *out = (struct Distance*) malloc(sizeof(Distance));
-    if (out == NULL)
+    if (!resetComponents(map->components, map->cities))
         return NULL;
 
-    out->city = NULL;
-    return out;
+    map->componentsStale = false;
+    return map->components;
 }
 
-/// @private
-static void destroyDistance(Distance *d) {
-    if (d != NULL)
-        free(d);
+/// @private Adds the road between the cities to the components of the map.
+static void joinComponents(Map *map, City *a, City *b) {
+    if (!map->componentsStale && !addRoadComponents(map->components, a, b))
+        map->componentsStale = true;
 }
 
-/// @private
-static void distanceComparator(void *v1, void *v2, int *ret) {
-    ret[0] = 0;
-
-    if (v2 == NULL) {
-        ret[0] = -1;
-        return;//Every distance is smaller then NULL distance
-    }
-    else if (v1 == NULL) {
-        ret[0] = 1;
-        return;
-    }
+/// @private Removes the road between the cities from the components of the map.
+static void splitComponents(Map *map, City *a, City *b) {
+    if (!map->componentsStale && !removeRoadComponents(map->components, a, b))
+        map->componentsStale = true;
+}
 
-    Distance *d1 = (Distance*)v1;
-    Distance *d2 = (Distance*)v2;
+/// @private Checks whether the cities are connected(@p true if it is not known).
+static bool connectedCities(Map *map, City *a, City *b) {
+    Components *components = getComponents(map);
+    return components == NULL || connectedComponents(components, a, b);
+}
 
-    assert(d1->city != NULL && d2->city != NULL);
+/// @private Adds the new road to the components of the map.
+static void indexRoad(Map *map, Road *road) {
+    City *a = getAnyCityFromRoad(road);
+    joinComponents(map, a, getConnectedCity(road, a));
+}
 
-    if (d1->distance > d2->distance)
-        ret[0] = 1;
-    else if (d1->distance < d2->distance)
-        ret[0] = -1;
-    else {
-        if (d1->oldestRoad < d2->oldestRoad)
-            ret[0] = 1;
-        else if (d1->oldestRoad > d2->oldestRoad)
-            ret[0] = -1;
-    }
+/// @private Removes the trees of the routes which may be changed by the road.
+static void changeRoad(Map *map, Road *road) {
+    City *a = getAnyCityFromRoad(road);
+    changeRoadTreeCache(map->trees, a, getConnectedCity(road, a), getRoadLength(road));
 }
 
-/// @private
-static Distance *composeNewDistance(Distance *last, City *dest, Road *road, bool plus) {
-    Distance *out = newDistance();//Calculating the next distance
-    if (out == NULL)
+/// @private Returns the next change in the log(NULL if the changes are not recorded).
+static MapChange *nextChange(Map *map) {
+    ChangeLog *log = &map->changeLog;
+    if (log->capacity == 0)
         return NULL;
 
-    out->city = dest;
-    out->oldestRoad = (last->oldestRoad < getRoadYear(road))?
-    last->oldestRoad : getRoadYear(road);
-    out->distance = last->distance;
-    if (plus)
-        out->distance += getRoadLength(road);
-    else
-        out->distance -= getRoadLength(road);
+    log->last++;
+    MapChange *out = &log->changes[(log->last - 1) % log->capacity];
+    out->sequence = log->last;
+    return out;
+}
 
-    if (last->city == NULL)
-        out->distance = INT_MAX;
-    if (last->distance == INT_MAX)
-        out->distance = INT_MAX;
+/// @private Records the change of the road between the cities(after the change).
+static void logRoadChange(Map *map, MapChangeKind kind, Road *road, City *c1, City *c2) {
+    MapChange *change = nextChange(map);
+    if (change == NULL)
+        return;
 
-    return out;
+    change->kind = kind;
+    change->city1 = getCityName(c1);
+    change->city2 = getCityName(c2);
+    change->length = (unsigned) getRoadLength(road);
+    change->year = getRoadYear(road);
+    change->routeId = 0;
+    change->first = 0;
+    change->removed = 0;
+    change->added = 0;
 }
 
-/// @private
-static vector *createDistanceMap(Map *map, City *from, City *to, vector *forbidden, Distance *dst) {
-    bool fatalError = false;
-    dst->city = NULL;
-    PriorityQueue *queue = newPriorityQueue(&distanceComparator);
-    if (queue == NULL)
-        return NULL;
-    
-    vector *visited = newVec(nextID(map)); //Distance list
-    if (visited == NULL) {
-        destroyPriorityQueue(queue);
-        return NULL;
-    }
-    
-    int inQueue[nextID(map)];
-    
-    for (int i = 0; i < nextID(map); i++) {
-        Distance *d = newDistance();
-        d->city = getVec(map->cities, i);
-        d->distance = INT_MAX;
-        d->oldestRoad = INT_MIN;
-        pushBackVec(visited, d);
-        inQueue[i] = 0;
-    }
-    
-    if (forbidden != NULL && fatalError != true) {
-        for (int i = 0; i < vecSize(forbidden); i++) {
-            Distance *forbiddenDistance = newDistance();
-            forbiddenDistance->city = NULL;//This distance cannot be changed
-            forbiddenDistance->distance = INT_MAX;
-            forbiddenDistance->oldestRoad = INT_MIN;
-            
-            City *cf = getVec(forbidden, i);
-            if (cf != NULL) {
-                destroyDistance(getVec(visited, getCityID(cf)));
-                setVec(visited, getCityID(cf), forbiddenDistance);
-            }
-            else
-                destroyDistance(forbiddenDistance);
-        }
-    }
-    
-    //Create the first element
-    Distance *start = newDistance();
-    if (start == NULL)
-        fatalError = true;
-    else {
-        start->city = from;
-        start->distance = 0;
-        start->oldestRoad = INT_MAX;
-        
-        destroyDistance(getVec(visited, getCityID(from)));
-        setVec(visited, getCityID(from), start);
-        
-        //Add the first element
-        if (addPQueue(queue, start) == NULL)
-            fatalError = true;  //Failed to add to the queue
-    }
-    
-    //Stores the Distance pointers(to be freed)
-    vector *distanceMemoryCrap = newVec(nextID(map) + 10);
-    if (distanceMemoryCrap == NULL)
-        fatalError = true;  //Failed to allocate memory
-    
-    if (fatalError) {
-        destroyPriorityQueue(queue);
-        destroyVec(visited);
-        if (distanceMemoryCrap != NULL)
-            free(distanceMemoryCrap);
-        return NULL;
-    }
-    
-    while (getPQueue(queue) != NULL) {
-        Distance *p = popPQueue(queue);
-        if (p == NULL)
-            break;
-        if (p->city == to)
-            break;
-        
-        if (inQueue[getCityID(p->city)] == 0) {
-            inQueue[getCityID(p->city)] = 1;
-            vector *roads = getRoadsCity(p->city);
-            
-            for (int i = vecSize(roads) - 1; i >= 0; i--) {
-                Road *road = getVec(roads, i);
-                City *dest = getConnectedCity(road, p->city);
-                int destId = getCityID(dest);
-                if (dest == NULL) {
-                    fatalError = true;
-                    break;
-                }
-                
-                //Calculating the next distance
-                Distance *nextDis = composeNewDistance(p, dest, road, true);
-                if (nextDis == NULL) {
-                    fatalError = true;
-                    break;
-                }
-                
-                //Checking if the new distance is smaller
-                Distance *fromVisited = getVec(visited, destId);
-                if (fromVisited == NULL || (fromVisited->city != NULL)) {
-                    int ret = 0;
-                    distanceComparator(nextDis, fromVisited, &ret);
-                    if (ret == -1) {//The distance is smaller
-                        if (addPQueue(queue, nextDis) == NULL) {
-                            fatalError = true;
-                            free(nextDis);
-                            break;
-                        }
-                        pushBackVec(distanceMemoryCrap, fromVisited);
-                        setVec(visited, destId, nextDis);
-                    }
-                    else
-                        destroyDistance(nextDis);
-                }
-                else
-                    destroyDistance(nextDis);
-                
-            }
-            
-            if (fatalError)
-                break;  //Eroor occured
-        }
+/// @private Records the change of the roads of the route from the road 'first'.
+static void logRouteChange(Map *map, MapChangeKind kind, Route *route,
+                           int first, int removed, int added) {
+    MapChange *change = nextChange(map);
+    if (change == NULL)
+        return;
+
+    change->kind = kind;
+    change->city1 = NULL;
+    change->city2 = NULL;
+    change->length = 0;
+    change->year = 0;
+    change->routeId = getRouteNumber(route);
+    change->first = first;
+    change->removed = removed;
+    change->added = added;
+}
+
+/// @private Records the change of the year of the road in the routes going through it, except 'skip'.
+static void logRoadRoutes(Map *map, Road *road, Route *skip) {
+    vector *routes = getRoutesRoad(road);
+    City *a = getAnyCityFromRoad(road);
+    City *b = getConnectedCity(road, a);
+
+    for (int i = 0; i < vecSize(routes); i++) {
+        Route *route = getVec(routes, i);
+        if (route != skip)
+            logRouteChange(map, CHANGE_ROUTE_REPAIRED, route,
+                           getCityIndexInRoute(route, firstCityInRoute(route, a, b)), 1, 1);
     }
-    
-    
-    //Cleaning up
-    for (int i = vecSize(distanceMemoryCrap) - 1; i >= 0; i--)
-        free(getVec(distanceMemoryCrap, i));
-    
-    destroyVec(distanceMemoryCrap);
-    destroyPriorityQueue(queue);
-    
-    return visited;
 }
 
-/// @private
+/// @private Searches with the workspace of the calling thread.
 static vector *shortestRoute(Map *map, City *from, City *to, vector *forbidden, Distance *dst) {
-    if (from == NULL || to == NULL)
-        return NULL;
-    bool fatalError = false;
-    
-    vector *visited = createDistanceMap(map, from, to, forbidden, dst);
-    if (visited == NULL)
-        return NULL;
+    return searchRoute(getVec(map->workspaces, 0), nextID(map), from, to, forbidden, dst);
+}
 
-    //List of routes from cities 'from' to 'to'.
-    vector *out = newVec(10);;
-    if (out == NULL)
-        fatalError = true;
+/**
+ @private
+ @brief
+ Finds the route with the cached tree of the routes from one of
+ its ends. If neither is cached, the tree from 'from' is found,
+ as the next routes will likely start there again.
+ */
+static vector *cachedRoute(Map *map, City *from, City *to, Distance *dst) {
+    SearchWorkspace *tree = findTreeCache(map->trees, from, nextID(map));
+    if (tree != NULL)
+        return finishRouteSearch(tree, to, dst);
+
+    //The tree from 'to' gives the route as the search from 'from' would
+    tree = findTreeCache(map->trees, to, nextID(map));
+    if (tree != NULL)
+        return finishReversedRouteSearch(tree, from, dst);
+
+    //A tree of a large map is found by all threads
+    ThreadPool *pool = NULL;
+    if (nextID(map) >= map->parallelCities)
+        pool = searchPool(map, nextID(map));
+
+    tree = addTreeCache(map->trees, from, nextID(map), pool);
+    if (tree == NULL)
+        return shortestRoute(map, from, to, NULL, dst);//Failed to allocate memory for the tree
+    return finishRouteSearch(tree, to, dst);
+}
 
-    if (!fatalError) {
-        City *last = to;
-        int lastID = getCityID(last);
-        Distance *lastDistance = getVec(visited, lastID);
+/// @private Radius of the first search for a detour, in the lengths of the removed road.
+#define DETOUR_RADIUS 4
+/// @private How many times the radius is widened before the search is not bounded.
+#define DETOUR_WIDENINGS 3
+
+/// @private State of the search for a detour(see @ref fixRouteVec).
+typedef struct DetourSearch{
+    /// Workspace of the search.
+    SearchWorkspace *ws;
+    /// The city where the detour ends.
+    City *second;
+    /// Bound of the next part of the search.
+    unsigned radius;
+    /// Number of the finished parts of the search.
+    int widenings;
+    /// Result of the last part(see @ref continueRouteSearch).
+    int ret;
+    /// Cities settled by the workspace before the search.
+    unsigned long long settled;
+}DetourSearch;
 
-        Distance *best = NULL;
-        bool ambi = false;
+/**
+ @private
+ @brief
+ Starts the search for the detour of the 'route' around the
+ road between the cities 'c1' and 'c2'. The workspace and the
+ first radius have to be set. If the search can not be started,
+ its result is -1.
+ */
+static void startDetour(Map *map, DetourSearch *search, Route *route, City *c1, City *c2) {
+    City *first = firstCityInRoute(route, c1, c2);
+    search->second = (c1 == first ? c2 : c1);
+    search->widenings = 0;
+    search->ret = -1;
+    search->settled = settledCities(search->ws);
 
-        while (last != from && lastDistance->distance != INT_MAX) {
-            vector *roads = getRoadsCity(last);
-            Road *bestRoad = NULL;
-            best = NULL;
+    //Concurrent searches only read the labels, which are updated before them
+    if (!connectedComponents(map->components, first, search->second))
+        return;//No detour exists
 
-            for (int i = vecSize(roads) - 1; i >= 0; i--) {
-                Road *road = getVec(roads, i);
-                City *dest = getConnectedCity(road, last);
+    vector *forbidden = getNewCitiesRoute(route, true, true);
+    if (forbidden == NULL)
+        return;//Failed to allocate memory
+    for (int i = 0; i < vecSize(forbidden); i++)
+        if (getVec(forbidden, i) == search->second) {
+            removeVec(forbidden, i);
+            i--;
+        }
 
-                int ret = 0;
-                Distance *stored = composeNewDistance(getVec(visited, getCityID(dest)), dest, road, true);
-                if (stored == NULL) {
-                    fatalError = true;//Cannot reach the city
-                    break;
-                }
-                distanceComparator(best, stored, &ret);
-                if (ret == 1 && stored->city != NULL) {
-                    free(best);
-                    best = stored;
-                    bestRoad = road;
-                    ambi = false;
-                }
-                else
-                    destroyDistance(stored);
+    if (startRouteSearch(search->ws, nextID(map), first, search->second, forbidden))
+        search->ret = 0;
+    destroyVec(forbidden);
+}
 
-                if (ret == 0)
-                    ambi = true;
-            }
+/// @private Returns the bound of the next part of the search for the detour.
+static unsigned detourBound(DetourSearch *search) {
+    return (search->widenings > DETOUR_WIDENINGS ? UINT_MAX : search->radius);
+}
 
-            if (ambi) {
-                destroyDistance(best);
-                best = NULL;
-            }
+/// @private Records the result of the part of the search and widens the radius.
+static void continuedDetour(Map *map, DetourSearch *search, int ret) {
+    unsigned bound = detourBound(search);
+    search->ret = ret;
 
-            if (best == NULL || lastDistance->distance != best->distance) {
-                fatalError = true;
-                if (best != NULL)
-                    destroyDistance(best);
-            }
-            if (fatalError)
-                break;
+    if (ret == 1 && search->widenings == 0 && bound != UINT_MAX)
+        atomic_fetch_add(&map->localRepairs, 1);
+    else if (ret == 1 && bound != UINT_MAX)
+        atomic_fetch_add(&map->widenedRepairs, 1);
+    else if (ret == 1)
+        atomic_fetch_add(&map->globalRepairs, 1);
 
-            last = best->city;
-            lastID = getCityID(last);
-            lastDistance = getVec(visited, lastID);
-            pushBackVec(out, bestRoad);
-            free(best);
-        }
+    search->radius = (search->radius > UINT_MAX / 4 ? UINT_MAX : search->radius * 4);
+    search->widenings++;
+}
 
-        reverseVec(out);
-    }
+/// @private Returns the detour found by the finished search(NULL if there is none).
+static vector *finishDetour(Map *map, DetourSearch *search) {
+    atomic_fetch_add(&map->repairSettled, settledCities(search->ws) - search->settled);
 
+    Distance d;
+    if (search->ret != 1)
+        return NULL;//No detour or failed to allocate memory
+    return finishRouteSearch(search->ws, search->second, &d);
+}
 
-    Distance *tmpDis = getVec(visited, getCityID(to));
-    if (tmpDis == NULL || tmpDis->distance == INT_MAX) {//Cannot reach the city
-        dst->city = from;
-        dst->distance = INT_MAX;
-        fatalError = true;
-    }
-    else {
-        if (fatalError == true)
-            dst->city = NULL;//Some other error(eg. memory)
-        else {
-            dst->city = tmpDis->city;//Route found
-            dst->distance = tmpDis->distance;
-            dst->oldestRoad = tmpDis->oldestRoad;
+/**
+ @private
+ @brief
+ Searches for the detour within the 'radius' from the city
+ where it starts. If the detour is further, the radius is
+ widened a few times and then the search is not bounded.
+ The search is continued, not repeated, after widening.
+ */
+static vector *fixRouteVec(Map *map, SearchWorkspace *ws, Route *route, City *c1, City *c2,
+                           unsigned radius) {
+    DetourSearch search;
+    search.ws = ws;
+    search.radius = radius;
+
+    startDetour(map, &search, route, c1, c2);
+    while (search.ret == 0)
+        continuedDetour(map, &search, continueRouteSearch(ws, detourBound(&search)));
+
+    return finishDetour(map, &search);
+}
+
+/// @private Detours of the routes which used the removed road.
+typedef struct Detours{
+    /// The map.
+    Map *map;
+    /// Routes which used the road.
+    vector *routes;
+    /// Cities connected by the road.
+    City *c1, *c2;
+    /// Radius of the first search for a detour.
+    unsigned radius;
+    /// Roads replacing the road, for every route(NULL if not found).
+    vector **inserts;
+    /// The city of the route from which the detour starts.
+    City **insertionPoints;
+}Detours;
+
+/// @private Finds the detour of the route with number 'index'.
+static void findDetour(void *data, int index, int thread) {
+    Detours *detours = (Detours*) data;
+    Route *route = getVec(detours->routes, index);
+
+    detours->insertionPoints[index] = firstCityInRoute(route, detours->c1, detours->c2);
+    detours->inserts[index] = fixRouteVec(detours->map, getVec(detours->map->workspaces, thread),
+                                          route, detours->c1, detours->c2, detours->radius);
+}
+
+/**
+ @private
+ @brief
+ Prepares the workspaces of the searches run in turns by the
+ calling thread(see @ref continueRouteSearches).
+ @return
+ Number of the searches which can run in turns, at most 'count'.
+ */
+static int interleavedSearches(Map *map, int count) {
+    if (count > map->interleave)
+        count = map->interleave;
+
+    while (vecSize(map->workspaces) < count) {
+        SearchWorkspace *ws = newSearchWorkspace();
+        if (ws == NULL || pushBackVec(map->workspaces, ws) == NULL) {
+            destroySearchWorkspace(ws);
+            break;
         }
     }
 
-    for (int i = 0; i < vecSize(visited); i++)
-       destroyDistance(getVec(visited, i));
-    
-    destroyVec(visited);
+    return (count < vecSize(map->workspaces) ? count : vecSize(map->workspaces));
+}
+
+/**
+ @private
+ @brief
+ Finds the detours of the routes with numbers from 'begin' to
+ 'end' - 1, running their searches in turns in the calling thread.
+ */
+static void findDetoursInterleaved(Detours *detours, int begin, int end) {
+    Map *map = detours->map;
+    DetourSearch searches[MAX_INTERLEAVED];
+    SearchWorkspace *ws[MAX_INTERLEAVED];
+    unsigned bounds[MAX_INTERLEAVED];
+    int results[MAX_INTERLEAVED], running[MAX_INTERLEAVED];
+
+    for (int i = begin; i < end; i++) {
+        Route *route = getVec(detours->routes, i);
+        DetourSearch *search = &searches[i - begin];
+
+        detours->insertionPoints[i] = firstCityInRoute(route, detours->c1, detours->c2);
+        search->ws = getVec(map->workspaces, i - begin);
+        search->radius = detours->radius;
+        startDetour(map, search, route, detours->c1, detours->c2);
+    }
+
+    //The searches stopped at the bound are widened and continued together
+    while (true) {
+        int count = 0;
+        for (int i = 0; i < end - begin; i++)
+            if (searches[i].ret == 0) {
+                ws[count] = searches[i].ws;
+                bounds[count] = detourBound(&searches[i]);
+                running[count++] = i;
+            }
+        if (count == 0)
+            break;
 
-    if (fatalError) {
-        destroyVec(out);
-        return NULL;//Problems with memory allocation
+        continueRouteSearches(ws, bounds, results, count);
+        for (int i = 0; i < count; i++)
+            continuedDetour(map, &searches[running[i]], results[i]);
     }
-    return out;//Everything went well
+
+    for (int i = begin; i < end; i++)
+        detours->inserts[i] = finishDetour(map, &searches[i - begin]);
 }
 
+/**
+ @private
+ @brief
+ Prepares the threads running 'count' searches at once.
+ @return
+ The pool or NULL if the searches should be run
+ by the calling thread.
+ */
+static ThreadPool *searchPool(Map *map, int count) {
+    if (count < 2 || map->threads == 1)
+        return NULL;
 
-/// @private
-static vector *fixRouteVec(Map *map, Route *route, City *c1, City *c2) {
-    City *first = firstCityInRoute(route, c1, c2);
-    City *second = c1;
-    if (second == first)
-        second = c2;
+    if (map->pool == NULL)
+        map->pool = newThreadPool(map->threads);
+    if (map->pool == NULL || threadPoolSize(map->pool) < 2)
+        return NULL;//The searches can run without the threads
 
-    vector *forbidden = getNewCitiesRoute(route, true, true);
-    for (int i = 0; i < vecSize(forbidden); i++)
-        if (getVec(forbidden, i) == second) {
-            removeVec(forbidden, i);
-            i--;
+    while (vecSize(map->workspaces) < threadPoolSize(map->pool)) {
+        SearchWorkspace *ws = newSearchWorkspace();
+        if (ws == NULL || pushBackVec(map->workspaces, ws) == NULL) {
+            destroySearchWorkspace(ws);
+            return NULL;
         }
+    }
 
-    Distance d;
-    vector *roads = shortestRoute(map, first, second, forbidden, &d);
-    destroyVec(forbidden);
-
-    return roads;
+    return map->pool;
 }
 
 /// @private
@@ -554,6 +715,25 @@ static Road *remRoad(City *from, City *to) {
     return out;
 }
 
+/**
+ @private
+ @brief
+ Puts the road back at the position 'x' in the list of roads
+ of the city, so that a failed operation does not change
+ the order of the roads. Undoes @ref remRoad, which moves
+ the last road of the list to the position of the removed one.
+ */
+static void restoreRoad(City *city, Road *road, int x) {
+    vector *roads = getRoadsCity(city);
+    if (x == vecSize(roads)) {
+        addCityRoad(city, road);
+        return;
+    }
+
+    addCityRoad(city, getVec(roads, x));
+    setVec(roads, x, road);
+}
+
 /**
  @private
  @brief
@@ -571,6 +751,103 @@ static void *getRoadCity(City *from, City *to) {
     return NULL;
 }
 
+/// @private Kinds of the changes made in a transaction.
+typedef enum ChangeKind{
+    /// The road was added.
+    ADDED_ROAD,
+    /// The road was removed from the cities.
+    REMOVED_ROAD,
+    /// The road was repaired.
+    REPAIRED_ROAD
+}ChangeKind;
+
+/// @private Change of the map made in a transaction(see @ref rollbackTransaction).
+typedef struct TransactionChange{
+    /// Kind of the change.
+    ChangeKind kind;
+    /// The changed road.
+    Road *road;
+    /// Cities of the road.
+    City *c1, *c2;
+    /// Positions of the removed road in the lists of the roads of 'c1' and 'c2'.
+    int x, y;
+    /// Year of the repaired road before the repair.
+    int year;
+}TransactionChange;
+
+/// @private Changes made since @ref beginTransaction, in order.
+typedef struct Transaction{
+    /// The changes.
+    TransactionChange *changes;
+    /// Number of the changes.
+    int size;
+    /// Size of the array 'changes'.
+    int capacity;
+}Transaction;
+
+/**
+ @private
+ @brief
+ Makes space for the next change of the open transaction, so that
+ it can be recorded after the map is changed.
+ @return
+ @p false if the memory could not be allocated.
+ */
+static bool reserveChange(Map *map) {
+    Transaction *transaction = map->transaction;
+    if (transaction == NULL || transaction->size < transaction->capacity)
+        return true;
+
+    int capacity = (transaction->capacity == 0 ? 16 : transaction->capacity * 2);
+    TransactionChange *changes = (TransactionChange*) realloc(transaction->changes,
+                                                              sizeof(TransactionChange) * capacity);
+    if (changes == NULL)
+        return false;
+
+    transaction->changes = changes;
+    transaction->capacity = capacity;
+    return true;
+}
+
+/// @private Records the change in the open transaction(see @ref reserveChange).
+static void recordChange(Map *map, ChangeKind kind, Road *road, City *c1, City *c2,
+                         int x, int y, int year) {
+    Transaction *transaction = map->transaction;
+    if (transaction == NULL)
+        return;
+
+    TransactionChange *change = &transaction->changes[transaction->size++];
+    change->kind = kind;
+    change->road = road;
+    change->c1 = c1;
+    change->c2 = c2;
+    change->x = x;
+    change->y = y;
+    change->year = year;
+}
+
+/**
+ @private
+ @brief
+ Removes the road from the cities in the open transaction. The routes
+ keep the road until they are repaired by @ref commitTransaction.
+ */
+static bool deferRemoveRoad(Map *map, City *c1, City *c2) {
+    if (!reserveChange(map))
+        return false;//Failed to allocate memory
+
+    int x = connectedRoadID(getRoadsCity(c1), c2);
+    int y = connectedRoadID(getRoadsCity(c2), c1);
+    Road *road = remRoad(c1, c2);
+
+    splitComponents(map, c1, c2);
+    changeRoad(map, road);
+    recordChange(map, REMOVED_ROAD, road, c1, c2, x, y, 0);
+    logRoadChange(map, CHANGE_ROAD_REMOVED, road, c1, c2);
+
+    return true;
+}
+
 // Defined in map.h
 
 bool addRoad(Map *map, const char *city1, const char *city2,
@@ -578,6 +855,11 @@ bool addRoad(Map *map, const char *city1, const char *city2,
     if (builtYear == 0 || map == NULL || length == 0)
         return false;//Wrong parameters
 
+    //A failed command must not leave new cities in the map
+    if (city1 == NULL || city2 == NULL || strcmp(city1, city2) == 0
+        || getCityNameSize(city1) <= 0 || getCityNameSize(city2) <= 0)
+        return false;//Wrong parameters
+
     City *c1, *c2;
 
     if ((c1 = getCity(map, city1)) == NULL)
@@ -594,44 +876,396 @@ bool addRoad(Map *map, const char *city1, const char *city2,
         if (getConnectedCity(getVec(roads, i), c1) == c2)
             return NULL;
 
+    if (!reserveChange(map))
+        return false;//Failed to allocate memory
+
     Road *r = newRoad(c1, c2, builtYear, length);
     if (r == NULL)
         return false;//Failed to allocate memory
 
     addCityRoad(c1, r);
     addCityRoad(c2, r);
+    indexRoad(map, r);
+    changeRoad(map, r);
+    recordChange(map, ADDED_ROAD, r, c1, c2, 0, 0, 0);
+    logRoadChange(map, CHANGE_ROAD_ADDED, r, c1, c2);
 
     return true;//Everything went well
 }
 
-bool repairRoad(Map *map, const char *city1, const char *city2, int repairYear) {
-    if (map == NULL || city1 == NULL || city2 == NULL)
-        return false;//Wrong parameters
+/// @private Road waiting in the batch(see @ref RoadBatch).
+typedef struct BatchRoad{
+    /// Positions of the names of the cities in 'names' of the batch.
+    size_t name1, name2;
+    /// The road length.
+    unsigned length;
+    /// The road build year.
+    int year;
+    /// Ids of the cities(found by @ref commitRoadBatch).
+    int city1, city2;
+    /// The created road(set by @ref commitRoadBatch).
+    Road *road;
+}BatchRoad;
 
-    if (repairYear == 0)
-        return false;//Wrong parameters
+/**
+    Roads added to the map at once. The names of the cities are
+    copied one after another to a single array, and the cities
+    and roads are created only when the batch is committed.
+ */
+typedef struct RoadBatch{
+    /// The map.
+    Map *map;
+    /// Names of the cities, each followed by '\0'.
+    char *names;
+    /// Used size of 'names'.
+    size_t namesSize;
+    /// Size of 'names'.
+    size_t namesCapacity;
+    /// The roads in the order of adding.
+    BatchRoad *roads;
+    /// Number of the roads.
+    int size;
+    /// Size of 'roads'.
+    int capacity;
+}RoadBatch;
+
+/// @private Pair of the cities of a road in the batch, used to find the repeated roads.
+typedef struct BatchPair{
+    /// The smaller id of the cities.
+    int a;
+    /// The greater id of the cities.
+    int b;
+    /// Number of the road in the batch.
+    int road;
+}BatchPair;
+
+RoadBatch *beginRoadBatch(Map *map) {
+    if (map == NULL)
+        return NULL;//Wrong parameters
 
-    City *c1, *c2;
+    RoadBatch *out = (struct RoadBatch*) calloc(1, sizeof(RoadBatch));
+    if (out == NULL)
+        return NULL;
 
-    if ((c1 = getCity(map, city1)) == NULL)
-        return false;//City not found
-    if ((c2 = getCity(map, city2)) == NULL)
-        return false;//City not found
+    out->map = map;
+    return out;
+}
 
-    if (c1 == c2)
-        return false;//Same city
+void abortRoadBatch(RoadBatch *batch) {
+    if (batch == NULL)
+        return;
 
-    vector *roads = getRoadsCity(c1);
-    int roadsSize = vecSize(roads);
+    free(batch->names);
+    free(batch->roads);
+    free(batch);
+}
 
-    for (int i = 0; i < roadsSize; i++) {
-        City *c = getConnectedCity(getVec(roads, i), c1);
-        if (c == c2) {
-            Road *r = getVec(roads, i);
-            if (getRoadYear(r) > repairYear)
+/// @private Copies the name to the batch(returns its position or -1).
+static long long copyBatchName(RoadBatch *batch, const char *name, int size) {
+    if (batch->namesSize + size + 1 > batch->namesCapacity) {
+        size_t capacity = (batch->namesCapacity == 0 ? 1024 : batch->namesCapacity * 2);
+        while (capacity < batch->namesSize + size + 1)
+            capacity *= 2;
+
+        char *names = (char*) realloc(batch->names, capacity);
+        if (names == NULL)
+            return -1;
+
+        batch->names = names;
+        batch->namesCapacity = capacity;
+    }
+
+    size_t out = batch->namesSize;
+    memcpy(batch->names + out, name, size + 1);
+    batch->namesSize += size + 1;
+
+    return (long long) out;
+}
+
+bool addRoadBatch(RoadBatch *batch, const char *city1, const char *city2,
+                  unsigned length, int builtYear) {
+    if (batch == NULL || builtYear == 0 || length == 0)
+        return false;//Wrong parameters
+
+    int size1 = getCityNameSize(city1), size2 = getCityNameSize(city2);
+    if (size1 <= 0 || size2 <= 0 || strcmp(city1, city2) == 0)
+        return false;//Wrong names of the cities
+
+    if (batch->size == batch->capacity) {
+        int capacity = (batch->capacity == 0 ? 256 : batch->capacity * 2);
+        BatchRoad *roads = (BatchRoad*) realloc(batch->roads, sizeof(BatchRoad) * capacity);
+        if (roads == NULL)
+            return false;
+
+        batch->roads = roads;
+        batch->capacity = capacity;
+    }
+
+    size_t namesSize = batch->namesSize;
+    long long name1 = copyBatchName(batch, city1, size1);
+    long long name2 = (name1 < 0 ? -1 : copyBatchName(batch, city2, size2));
+    if (name2 < 0) {
+        batch->namesSize = namesSize;
+        return false;//Failed to allocate memory
+    }
+
+    BatchRoad *road = &batch->roads[batch->size++];
+    road->name1 = (size_t) name1;
+    road->name2 = (size_t) name2;
+    road->length = length;
+    road->year = builtYear;
+
+    return true;
+}
+
+/// @private
+static unsigned long long hashName(const char *name) {
+    unsigned long long hash = 14695981039346656037ull;//FNV-1a
+    for (; *name != '\0'; name++)
+        hash = (hash ^ (unsigned char) *name) * 1099511628211ull;
+    return hash;
+}
+
+/**
+    @private
+    @brief
+        Finds the ids of the cities of the roads in the batch,
+        adding the missing cities to the map in the order of
+        their first use. Every name is looked up in the map once,
+        the repeated names are found in a hash table of the batch.
+    @return
+        @p false if the memory could not be allocated.
+ */
+static bool findBatchCities(RoadBatch *batch) {
+    size_t slots = 16;
+    while (slots < 4 * (size_t) batch->size)
+        slots *= 2;
+
+    //Every slot keeps the position of a name(+1, 0 for a free slot) and its city
+    size_t *names = (size_t*) calloc(slots, sizeof(size_t));
+    int *ids = (int*) malloc(sizeof(int) * slots);
+    if (names == NULL || ids == NULL) {
+        free(names);
+        free(ids);
+        return false;
+    }
+
+    bool ok = true;
+    for (int i = 0; i < 2 * batch->size && ok; i++) {
+        BatchRoad *road = &batch->roads[i / 2];
+        size_t name = (i % 2 == 0 ? road->name1 : road->name2);
+        const char *city = batch->names + name;
+
+        size_t x = hashName(city) & (slots - 1);
+        while (names[x] != 0 && strcmp(batch->names + names[x] - 1, city) != 0)
+            x = (x + 1) & (slots - 1);
+
+        if (names[x] == 0) {//The first use of the name
+            City *c = getCity(batch->map, city);
+            if (c == NULL && (c = addCity(batch->map, city)) == NULL) {
+                ok = false;//Failed to allocate memory
+                break;
+            }
+            names[x] = name + 1;
+            ids[x] = getCityID(c);
+        }
+
+        if (i % 2 == 0)
+            road->city1 = ids[x];
+        else
+            road->city2 = ids[x];
+    }
+
+    free(names);
+    free(ids);
+    return ok;
+}
+
+/// @private Orders the pairs by the cities and then by the order of adding.
+static int comparePairs(const void *x, const void *y) {
+    const BatchPair *p = (const BatchPair*) x, *q = (const BatchPair*) y;
+    if (p->a != q->a)
+        return (p->a > q->a) - (p->a < q->a);
+    if (p->b != q->b)
+        return (p->b > q->b) - (p->b < q->b);
+    return (p->road > q->road) - (p->road < q->road);
+}
+
+/**
+    @private
+    @brief
+        Marks the roads of the batch which are already in the map
+        or were added to the batch earlier(their 'length' is set
+        to 0).
+    @param[in] cities - number of the cities before the batch, only
+        the roads between them may already be in the map.
+    @return
+        @p false if the memory could not be allocated.
+ */
+static bool markRepeatedRoads(RoadBatch *batch, int cities) {
+    BatchPair *pairs = (BatchPair*) malloc(sizeof(BatchPair) * (batch->size + 1));
+    if (pairs == NULL)
+        return false;
+
+    for (int i = 0; i < batch->size; i++) {
+        BatchRoad *road = &batch->roads[i];
+        pairs[i].a = (road->city1 < road->city2 ? road->city1 : road->city2);
+        pairs[i].b = (road->city1 < road->city2 ? road->city2 : road->city1);
+        pairs[i].road = i;
+    }
+    qsort(pairs, batch->size, sizeof(BatchPair), &comparePairs);
+
+    for (int i = 0; i < batch->size; i++) {
+        BatchRoad *road = &batch->roads[pairs[i].road];
+        if (i > 0 && pairs[i].a == pairs[i - 1].a && pairs[i].b == pairs[i - 1].b)
+            road->length = 0;//Added earlier in the batch
+        else if (pairs[i].b < cities) {
+            City *a = getVec(batch->map->cities, pairs[i].a);
+            City *b = getVec(batch->map->cities, pairs[i].b);
+            if (vecSize(getRoadsCity(b)) < vecSize(getRoadsCity(a)))
+                a = b, b = getVec(batch->map->cities, pairs[i].a);
+            if (getRoadCity(a, b) != NULL)
+                road->length = 0;//Already in the map
+        }
+    }
+
+    free(pairs);
+    return true;
+}
+
+/// @private Removes the first 'count' roads of the batch added to the cities.
+static void discardBatchRoads(RoadBatch *batch, int count) {
+    for (int i = count - 1; i >= 0; i--) {
+        BatchRoad *road = &batch->roads[i];
+        if (road->length == 0)
+            continue;
+
+        City *a = getVec(batch->map->cities, road->city1);
+        City *b = getVec(batch->map->cities, road->city2);
+        Road *r = popBackVec(getRoadsCity(a));
+        popBackVec(getRoadsCity(b));
+        destroyRoad(r);
+    }
+}
+
+/// @private Makes space in the lists of the roads of the cities for the new roads.
+static bool reserveBatchRoads(RoadBatch *batch) {
+    int cities = nextID(batch->map);
+    int *degree = (int*) calloc(cities + 1, sizeof(int));
+    if (degree == NULL)
+        return false;
+
+    for (int i = 0; i < batch->size; i++)
+        if (batch->roads[i].length != 0) {
+            degree[batch->roads[i].city1]++;
+            degree[batch->roads[i].city2]++;
+        }
+
+    bool ok = true;
+    for (int i = 0; i < cities && ok; i++)
+        if (degree[i] > 0) {
+            vector *roads = getRoadsCity(getVec(batch->map->cities, i));
+            ok = (reserveVec(roads, vecSize(roads) + degree[i]) != NULL);
+        }
+
+    free(degree);
+    return ok;
+}
+
+int commitRoadBatch(RoadBatch *batch) {
+    if (batch == NULL)
+        return -1;//Wrong parameters
+
+    Map *map = batch->map;
+    if (map->transaction != NULL) {
+        abortRoadBatch(batch);
+        return -1;//Roads added at once can not be rolled back
+    }
+
+    int cities = nextID(map);
+    if (!findBatchCities(batch) || !markRepeatedRoads(batch, cities)
+        || !reserveBatchRoads(batch)) {
+        abortRoadBatch(batch);
+        return -1;//Failed to allocate memory
+    }
+
+    int added = 0;
+    for (int i = 0; i < batch->size; i++) {
+        BatchRoad *road = &batch->roads[i];
+        if (road->length == 0)
+            continue;//Repeated road
+
+        City *a = getVec(map->cities, road->city1);
+        City *b = getVec(map->cities, road->city2);
+        Road *r = newRoad(a, b, road->year, road->length);
+        if (r == NULL) {
+            discardBatchRoads(batch, i);
+            abortRoadBatch(batch);
+            return -1;//Failed to allocate memory
+        }
+
+        //The space was reserved, so the roads are always added
+        addCityRoad(a, r);
+        addCityRoad(b, r);
+        road->road = r;
+        added++;
+    }
+
+    //The roads are logged only when all of them are added
+    for (int i = 0; i < batch->size; i++) {
+        BatchRoad *road = &batch->roads[i];
+        if (road->length != 0)
+            logRoadChange(map, CHANGE_ROAD_ADDED, road->road,
+                          getVec(map->cities, road->city1), getVec(map->cities, road->city2));
+    }
+
+    //The components are found again with all new roads at once
+    if (added > 0) {
+        map->componentsStale = true;
+        clearTreeCache(map->trees);
+    }
+
+    abortRoadBatch(batch);
+    return added;
+}
+
+bool repairRoad(Map *map, const char *city1, const char *city2, int repairYear) {
+    if (map == NULL || city1 == NULL || city2 == NULL)
+        return false;//Wrong parameters
+
+    if (repairYear == 0)
+        return false;//Wrong parameters
+
+    City *c1, *c2;
+
+    if ((c1 = getCity(map, city1)) == NULL)
+        return false;//City not found
+    if ((c2 = getCity(map, city2)) == NULL)
+        return false;//City not found
+
+    if (c1 == c2)
+        return false;//Same city
+
+    vector *roads = getRoadsCity(c1);
+    int roadsSize = vecSize(roads);
+
+    for (int i = 0; i < roadsSize; i++) {
+        City *c = getConnectedCity(getVec(roads, i), c1);
+        if (c == c2) {
+            Road *r = getVec(roads, i);
+            if (getRoadYear(r) > repairYear)
                 return false;//Wrong repair year
 
-            setRoadYear(r, repairYear);
+            if (getRoadYear(r) != repairYear) {
+                if (!reserveChange(map))
+                    return false;//Failed to allocate memory
+
+                recordChange(map, REPAIRED_ROAD, r, c1, c2, 0, 0, getRoadYear(r));
+                setRoadYear(r, repairYear);
+                changeRoad(map, r);
+                logRoadChange(map, CHANGE_ROAD_REPAIRED, r, c1, c2);
+                logRoadRoutes(map, r, NULL);
+            }
             return true;//Everything went well
         }
     }
@@ -643,6 +1277,8 @@ bool newRoute(Map *map, unsigned routeId,
               const char *city1, const char *city2) {
     if (map == NULL || city1 == NULL || city2 == NULL)
         return false;
+    if (map->transaction != NULL)
+        return false;//Routes are not changed in a transaction
 
     if (getRoute(map, routeId) != NULL)
         return false;//Route with the same number already exists
@@ -656,12 +1292,15 @@ bool newRoute(Map *map, unsigned routeId,
     if (from == to)
         return false;//Cities are the same
 
+    if (!connectedCities(map, from, to))
+        return false;//No route can connect the cities
+
     Route *route = addRoute(map, routeId);
     if (route == NULL)
         return false;//Failed to allocate memory
 
     Distance routeLength;
-    vector *roads = shortestRoute(map, from, to, NULL, &routeLength);
+    vector *roads = cachedRoute(map, from, to, &routeLength);
     if (roads == NULL) {
         destroyRoute(route);
         setVec(map->routes, routeId, NULL);
@@ -671,11 +1310,249 @@ bool newRoute(Map *map, unsigned routeId,
     setRouteStart(route, from);
     setRouteEnd(route, to);
     copyRoadsRoute(route, roads);
+    logRouteChange(map, CHANGE_ROUTE_CREATED, route, 0, 0, vecSize(roads));
     destroyVec(roads);
 
     return true;
 }
 
+/// @private Routes created at once, grouped by the city in which they start or end.
+typedef struct RouteBatch{
+    /// The map.
+    Map *map;
+    /// Cities searched from, for every group.
+    City **sources;
+    /// The routes of the group 'g' are 'order[first[g]]', ..., 'order[first[g + 1] - 1]'.
+    int *first;
+    /// Numbers of the routes, by the groups.
+    int *order;
+    /// Ends of the routes(see @ref newRoute).
+    City **from, **to;
+    /// Roads of the routes from 'from' to 'to'(NULL if not found).
+    vector **roads;
+}RouteBatch;
+
+/// @private Returns the ends of the routes of the group other than its city(NULL if the memory could not be allocated).
+static City **groupTargets(RouteBatch *batch, int index) {
+    City *source = batch->sources[index];
+    int begin = batch->first[index], end = batch->first[index + 1];
+
+    City **targets = (City**) malloc(sizeof(City*) * (end - begin));
+    if (targets == NULL)
+        return NULL;//Failed to allocate memory
+
+    for (int i = begin; i < end; i++) {
+        int x = batch->order[i];
+        targets[i - begin] = (batch->from[x] == source ? batch->to[x] : batch->from[x]);
+    }
+
+    return targets;
+}
+
+/// @private Creates the roads of the routes of the group from the finished search.
+static void finishRouteGroup(RouteBatch *batch, int index, SearchWorkspace *ws, City **targets) {
+    City *source = batch->sources[index];
+    int begin = batch->first[index], end = batch->first[index + 1];
+
+    for (int i = begin; i < end; i++) {
+        int x = batch->order[i];
+        Distance d;
+
+        if (batch->from[x] == source)
+            batch->roads[x] = finishRouteSearch(ws, targets[i - begin], &d);
+        else//As the search from the other end would find it
+            batch->roads[x] = finishReversedRouteSearch(ws, targets[i - begin], &d);
+    }
+}
+
+/// @private Finds the routes of the group with number 'index' by a single search.
+static void findRouteGroup(void *data, int index, int thread) {
+    RouteBatch *batch = (RouteBatch*) data;
+    SearchWorkspace *ws = getVec(batch->map->workspaces, thread);
+
+    City **targets = groupTargets(batch, index);
+    if (targets == NULL)
+        return;//Failed to allocate memory
+
+    //The routes can go through the other targets, as if they were searched alone
+    int count = batch->first[index + 1] - batch->first[index];
+    if (searchManyRoutes(ws, nextID(batch->map), batch->sources[index], targets, count))
+        finishRouteGroup(batch, index, ws, targets);
+
+    free(targets);
+}
+
+/**
+ @private
+ @brief
+ Finds the routes of the groups with numbers from 'begin' to
+ 'end' - 1, running their searches in turns in the calling thread.
+ */
+static void findRouteGroupsInterleaved(RouteBatch *batch, int begin, int end) {
+    City **targets[MAX_INTERLEAVED];
+    SearchWorkspace *ws[MAX_INTERLEAVED];
+    unsigned bounds[MAX_INTERLEAVED];
+    int results[MAX_INTERLEAVED], running[MAX_INTERLEAVED];
+    int count = 0;
+
+    for (int g = begin; g < end; g++) {
+        SearchWorkspace *w = getVec(batch->map->workspaces, g - begin);
+        int size = batch->first[g + 1] - batch->first[g];
+
+        targets[g - begin] = groupTargets(batch, g);
+        if (targets[g - begin] != NULL &&
+            startManyRouteSearch(w, nextID(batch->map), batch->sources[g], targets[g - begin], size)) {
+            ws[count] = w;
+            bounds[count] = UINT_MAX;
+            running[count++] = g;
+        }
+    }
+
+    continueRouteSearches(ws, bounds, results, count);
+    for (int i = 0; i < count; i++)
+        if (results[i] == 1)
+            finishRouteGroup(batch, running[i], ws[i], targets[running[i] - begin]);
+
+    for (int g = begin; g < end; g++)
+        free(targets[g - begin]);
+}
+
+/**
+ @private
+ @brief
+ Groups the routes which can be created, so that every group
+ shares the city searched from. A route joins the group of its
+ start or its end, and a new group is started from its start
+ if there is none.
+ @return
+ Number of the groups or -1 if the memory could not be allocated.
+ */
+static int groupRoutes(RouteBatch *batch, int n) {
+    int *group = (int*) malloc(sizeof(int) * (nextID(batch->map) + 1));
+    int *routeGroup = (int*) malloc(sizeof(int) * (n + 1));
+    if (group == NULL || routeGroup == NULL) {
+        free(group);
+        free(routeGroup);
+        return -1;
+    }
+
+    int groups = 0;
+    for (int i = 0; i < nextID(batch->map); i++)
+        group[i] = -1;
+
+    for (int x = 0; x < n; x++) {
+        routeGroup[x] = -1;
+        if (batch->from[x] == NULL)
+            continue;//The route can not be created
+
+        int a = getCityID(batch->from[x]), b = getCityID(batch->to[x]);
+        if (group[a] == -1 && group[b] == -1) {
+            batch->sources[groups] = batch->from[x];
+            group[a] = groups++;
+        }
+        routeGroup[x] = (group[a] != -1 ? group[a] : group[b]);
+    }
+
+    //Counting sort of the routes by the groups
+    for (int g = 0; g <= groups; g++)
+        batch->first[g] = 0;
+    for (int x = 0; x < n; x++)
+        if (routeGroup[x] != -1)
+            batch->first[routeGroup[x] + 1]++;
+    for (int g = 0; g < groups; g++)
+        batch->first[g + 1] += batch->first[g];
+    for (int x = 0; x < n; x++)
+        if (routeGroup[x] != -1)
+            batch->order[batch->first[routeGroup[x]]++] = x;
+    for (int g = groups; g > 0; g--)
+        batch->first[g] = batch->first[g - 1];
+    batch->first[0] = 0;
+
+    free(group);
+    free(routeGroup);
+    return groups;
+}
+
+int newRoutes(Map *map, unsigned *routeIds, const char **cities1,
+              const char **cities2, int n, bool *created) {
+    if (map == NULL || routeIds == NULL || cities1 == NULL || cities2 == NULL || n <= 0)
+        return 0;//Wrong parameters
+    if (map->transaction != NULL)
+        return 0;//Routes are not changed in a transaction
+
+    RouteBatch batch;
+    batch.map = map;
+    batch.sources = (City**) malloc(sizeof(City*) * n);
+    batch.first = (int*) malloc(sizeof(int) * (n + 1));
+    batch.order = (int*) malloc(sizeof(int) * n);
+    batch.from = (City**) calloc(n, sizeof(City*));
+    batch.to = (City**) calloc(n, sizeof(City*));
+    batch.roads = (vector**) calloc(n, sizeof(vector*));
+
+    int groups = -1;
+    if (batch.sources != NULL && batch.first != NULL && batch.order != NULL &&
+        batch.from != NULL && batch.to != NULL && batch.roads != NULL) {
+        //The same checks as in newRoute, a repeated number is checked when the routes are created
+        for (int x = 0; x < n; x++) {
+            unsigned id = routeIds[x];
+            if (id == 0 || id > 999 || getRoute(map, id) != NULL)
+                continue;
+
+            City *from = (cities1[x] == NULL ? NULL : getCity(map, cities1[x]));
+            City *to = (cities2[x] == NULL ? NULL : getCity(map, cities2[x]));
+            if (from == NULL || to == NULL || from == to || !connectedCities(map, from, to))
+                continue;
+
+            batch.from[x] = from;
+            batch.to[x] = to;
+        }
+
+        groups = groupRoutes(&batch, n);
+    }
+
+    if (groups > 0) {
+        //The searches only read the map, so they run at once
+        ThreadPool *pool = searchPool(map, groups);
+        int interleaved = (pool == NULL ? interleavedSearches(map, groups) : 1);
+        if (pool != NULL)
+            runThreadPool(pool, &findRouteGroup, &batch, groups);
+        else if (interleaved > 1)
+            for (int g = 0; g < groups; g += interleaved)
+                findRouteGroupsInterleaved(&batch, g, (g + interleaved < groups ? g + interleaved : groups));
+        else
+            for (int g = 0; g < groups; g++)
+                findRouteGroup(&batch, g, 0);
+    }
+
+    int out = 0;
+    for (int x = 0; x < n; x++) {
+        Route *route = NULL;
+        if (batch.roads != NULL && batch.roads[x] != NULL && getRoute(map, routeIds[x]) == NULL)
+            route = addRoute(map, routeIds[x]);
+
+        if (route != NULL) {
+            setRouteStart(route, batch.from[x]);
+            setRouteEnd(route, batch.to[x]);
+            copyRoadsRoute(route, batch.roads[x]);
+            logRouteChange(map, CHANGE_ROUTE_CREATED, route, 0, 0, vecSize(batch.roads[x]));
+            out++;
+        }
+        if (created != NULL)
+            created[x] = (route != NULL);
+        if (batch.roads != NULL)
+            destroyVec(batch.roads[x]);
+    }
+
+    free(batch.sources);
+    free(batch.first);
+    free(batch.order);
+    free(batch.from);
+    free(batch.to);
+    free(batch.roads);
+
+    return out;
+}
+
 /// @private
 static void cityComparator(void *a, void *b, int *ret){
     City *c1 = (City *) a;
@@ -689,16 +1566,67 @@ static void cityComparator(void *a, void *b, int *ret){
         ret[0] = 0;
 }
 
+/// @private Compares the names of the cities.
+static int compareNames(const void *a, const void *b) {
+    return strcmp(*(char* const*) a, *(char* const*) b);
+}
+
+/**
+ @private
+ @brief
+ Checks the description of the route given to @ref exactRoute before any
+ city is created, so that a wrong description does not change the map.
+ The cities can not repeat and every road has to fit the existing one.
+ */
+static bool checkRouteDescription(Map *map, vector *cityNames, vector *roadLengths,
+                                  vector *roadBuiltYears) {
+    int size = vecSize(cityNames);
+    if (size < 2 || vecSize(roadLengths) != size - 1 || vecSize(roadBuiltYears) != size - 1)
+        return false;
+
+    for (int i = 1; i < size; i++) {
+        int length = *(int*) getVec(roadLengths, i - 1);
+        int year = *(int*) getVec(roadBuiltYears, i - 1);
+        if (length == 0 || year == 0)
+            return false;//Cannot create road with zero build year, and/or zero length.
+
+        City *a = getCity(map, (char*) getVec(cityNames, i - 1));
+        City *b = getCity(map, (char*) getVec(cityNames, i));
+        Road *r = (a != NULL && b != NULL ? getRoadCity(a, b) : NULL);
+        if (r != NULL && (getRoadLength(r) != length || getRoadYear(r) > year))
+            return false;//Wrong built year or length
+    }
+
+    char **names = (char**) malloc(sizeof(char*) * size);
+    if (names == NULL)
+        return false;
+    for (int i = 0; i < size; i++)
+        names[i] = getVec(cityNames, i);
+
+    //The sorted names repeat next to each other
+    qsort(names, size, sizeof(char*), &compareNames);
+    bool ok = true;
+    for (int i = 1; i < size && ok; i++)
+        ok = (strcmp(names[i - 1], names[i]) != 0);
+
+    free(names);
+    return ok;
+}
+
 bool exactRoute(Map *map, unsigned num, vector *cityNames, vector *roadLengths, vector *roadBuiltYears) {
     if (map == NULL || cityNames == NULL || roadLengths == NULL || roadBuiltYears == NULL)
         return false;   //Wrong parameters
     if (num < 1 || num > 999)
         return false;   //Wrong parameters
+    if (map->transaction != NULL)
+        return false;//Routes are not changed in a transaction
     if (getVec(map->routes, num) != NULL)
         return false;   //Route with that number already exists
     for (int i = 0; i < vecSize(cityNames); i++)
         if (getCityNameSize((char*) getVec(cityNames, i)) <= 0)
             return false;   //Wrong city name
+    if (!checkRouteDescription(map, cityNames, roadLengths, roadBuiltYears))
+        return false;   //Wrong route description
     
     bool err = false;
     
@@ -787,8 +1715,17 @@ bool exactRoute(Map *map, unsigned num, vector *cityNames, vector *roadLengths,
         copyRoadsRoute(route, routeRoads);
         
         for (int i = 0; i < vecSize(routeRoads); i++) {
-            setRoadYear(getVec(routeRoads, i), *(int*) getVec(roadBuiltYears, i));
-            addRouteRoad(getVec(routeRoads, i), route);
+            Road *road = getVec(routeRoads, i);
+            int year = getRoadYear(road);
+            setRoadYear(road, *(int*) getVec(roadBuiltYears, i));
+            changeRoad(map, road);
+
+            //The new roads are created with the right year
+            City *a = getAnyCityFromRoad(road);
+            if (year != getRoadYear(road)) {
+                logRoadChange(map, CHANGE_ROAD_REPAIRED, road, a, getConnectedCity(road, a));
+                logRoadRoutes(map, road, route);
+            }
         }
         for (int i = 0; i < vecSize(roadsToAdd); i++) {
             Road *road = getVec(roadsToAdd, i);
@@ -797,9 +1734,12 @@ bool exactRoute(Map *map, unsigned num, vector *cityNames, vector *roadLengths,
             
             addCityRoad(a, road);
             addCityRoad(b, road);
+            indexRoad(map, road);
+            logRoadChange(map, CHANGE_ROAD_ADDED, road, a, b);
         }
         
         setVec(map->routes, num, route);
+        logRouteChange(map, CHANGE_ROUTE_CREATED, route, 0, 0, vecSize(routeRoads));
     }
     
     
@@ -820,6 +1760,8 @@ bool exactRoute(Map *map, unsigned num, vector *cityNames, vector *roadLengths,
 bool extendRoute(Map *map, unsigned routeId, const char *city) {
     if (map == NULL || city == NULL)
         return NULL; //Wrong pareameters
+    if (map->transaction != NULL)
+        return false;//Routes are not changed in a transaction
 
     City *c = getCity(map, city);
     if (c == NULL)
@@ -834,7 +1776,14 @@ bool extendRoute(Map *map, unsigned routeId, const char *city) {
         if (getConnectedCity(getVec(roads, i), c) != NULL)
             return NULL; //The route contains the City
 
-    vector *forbidden = getNewCitiesRoute(route, false, true);
+    //The ends of the route are connected, so it is enough to check one of them
+    if (!connectedCities(map, c, getRouteStart(route)))
+        return false;//The city can not be reached
+
+    //The ends of the route are the targets, so only its inner cities are forbidden
+    vector *forbidden = getNewCitiesRoute(route, false, false);
+    if (forbidden == NULL)
+        return false;//Failed to allocate memory
 
     Distance fromStart, fromEnd;
     fromStart.city = NULL;
@@ -844,12 +1793,11 @@ bool extendRoute(Map *map, unsigned routeId, const char *city) {
     fromEnd.distance = INT_MAX;
     fromEnd.oldestRoad = INT_MIN;
 
-    vector *roadsFromStart =
-        shortestRoute(map, c, getRouteStart(route), forbidden, &fromStart);
-
-    pushBackVec(forbidden, getRouteStart(route));
-    vector *roadsFromEnd =
-        shortestRoute(map, getRouteEnd(route), c, forbidden, &fromEnd);
+    //Both extensions are searched from the city at once
+    vector *roadsFromStart, *roadsFromEnd;
+    searchTwoRoutes(getVec(map->workspaces, 0), nextID(map), c,
+                    getRouteStart(route), getRouteEnd(route), forbidden,
+                    &roadsFromStart, &fromStart, &roadsFromEnd, &fromEnd);
 
     bool fatalError = false;
     if (fromStart.city == NULL || fromEnd.city == NULL)
@@ -860,10 +1808,15 @@ bool extendRoute(Map *map, unsigned routeId, const char *city) {
 
         if (ret == 0 && fromStart.city != NULL && fromEnd.city != NULL)
             fatalError = true;//Choice is ambiguous
-        else if ((ret == 1 || roadsFromStart == NULL) && roadsFromEnd != NULL)
-            insertRoadsRoute(route, roadsFromEnd, vecSize(roads));
-        else if ((ret == -1 || roadsFromEnd == NULL) && roadsFromStart != NULL)
+        else if ((ret == 1 || roadsFromStart == NULL) && roadsFromEnd != NULL) {
+            int first = vecSize(roads);
+            insertRoadsRoute(route, roadsFromEnd, first);
+            logRouteChange(map, CHANGE_ROUTE_EXTENDED, route, first, 0, vecSize(roadsFromEnd));
+        }
+        else if ((ret == -1 || roadsFromEnd == NULL) && roadsFromStart != NULL) {
             insertRoadsRoute(route, roadsFromStart, 0);
+            logRouteChange(map, CHANGE_ROUTE_EXTENDED, route, 0, 0, vecSize(roadsFromStart));
+        }
         else
             fatalError = true;//Cannot reach the city
     }
@@ -889,120 +1842,1027 @@ bool removeRoad(Map *map, const char *city1, const char *city2) {
     if (c1 == c2)
         return false;
 
+    Road *existing = getRoadCity(c1, c2);
+    if (existing == NULL)
+        return false;//Road not found
+
+    if (map->transaction != NULL)
+        return deferRemoveRoad(map, c1, c2);
+
+    int x = connectedRoadID(getRoadsCity(c1), c2);
+    int y = connectedRoadID(getRoadsCity(c2), c1);
     Road *road = remRoad(c1, c2);
     if (road == NULL)
         return false;
 
     bool err = false;
     vector *routes = getRoutesRoad(road);
-    vector *inserts = newVec(vecSize(routes));
-    vector *insertionPoints = newVec(vecSize(routes));
-
-    if (routes != NULL)
-        for (int i = 0; i < vecSize(routes); i++) {
-            vector *insert = fixRouteVec(map, getVec(routes, i), c1, c2);
-            City *insertionPoint = firstCityInRoute(getVec(routes, i), c1, c2);
-            if (insert == NULL || insertionPoint == NULL) {
-                err = true;
-                break;
-            }
+    int count = vecSize(routes);
+
+    //The detours look at the components without the road
+    splitComponents(map, c1, c2);
+    if (count > 0 && getComponents(map) == NULL)
+        err = true;//Failed to allocate memory
+    else if (count > 0 && !connectedComponents(map->components, c1, c2))
+        err = true;//The road was a bridge, so no detour exists
+
+    //The searches only read the map, so they run at once
+    Detours detours;
+    detours.map = map;
+    detours.routes = routes;
+    detours.c1 = c1;
+    detours.c2 = c2;
+    detours.radius = (getRoadLength(road) > INT_MAX / DETOUR_RADIUS ?
+                      UINT_MAX : (unsigned) getRoadLength(road) * DETOUR_RADIUS);
+    detours.inserts = (vector**) calloc(count + 1, sizeof(vector*));
+    detours.insertionPoints = (City**) calloc(count + 1, sizeof(City*));
+
+    if (err || detours.inserts == NULL || detours.insertionPoints == NULL)
+        err = true;
+    else {
+        ThreadPool *pool = searchPool(map, count);
+        int interleaved = (pool == NULL ? interleavedSearches(map, count) : 1);
+        if (pool != NULL)
+            runThreadPool(pool, &findDetour, &detours, count);
+        else if (interleaved > 1)
+            for (int i = 0; i < count; i += interleaved)
+                findDetoursInterleaved(&detours, i, (i + interleaved < count ? i + interleaved : count));
+        else
+            for (int i = 0; i < count; i++)
+                findDetour(&detours, i, 0);
 
-            pushBackVec(inserts, insert);
-            pushBackVec(insertionPoints, insertionPoint);
-        }
+        for (int i = 0; i < count; i++)
+            if (detours.inserts[i] == NULL || detours.insertionPoints[i] == NULL)
+                err = true;
+    }
 
     if (!err) {
-        for (int i = 0; i < vecSize(routes); i++) {
+        logRoadChange(map, CHANGE_ROAD_REMOVED, road, c1, c2);
+        for (int i = 0; i < count; i++) {
             Route *route = getVec(routes, i);
-            vector *insert = getVec(inserts, i);
-            int ip = getCityIndexInRoute(route, getVec(insertionPoints, i));
+            vector *insert = detours.inserts[i];
+            int ip = getCityIndexInRoute(route, detours.insertionPoints[i]);
 
             removeRoadRoute(route, road);
             insertRoadsRoute(route, insert, ip);
-
-            destroyVec(insert);
+            logRouteChange(map, CHANGE_ROUTE_REPAIRED, route, ip, 1, vecSize(insert));
         }
 
+        changeRoad(map, road);
         destroyRoad(road);
     }
     else {
-        for (int i = 0; i < vecSize(inserts); i++)
-            destroyVec((vector *) getVec(inserts, i));
-
-        addCityRoad(c1, road);
-        addCityRoad(c2, road);
+        restoreRoad(c1, road, x);
+        restoreRoad(c2, road, y);
+        joinComponents(map, c1, c2);
     }
 
-    destroyVec(inserts);
-    destroyVec(insertionPoints);
+    if (detours.inserts != NULL)
+        for (int i = 0; i < count; i++)
+            destroyVec(detours.inserts[i]);
+    free(detours.inserts);
+    free(detours.insertionPoints);
 
     return !err;
 }
 
-//TODO: Check this function for memory leaks
-bool removeRoute(Map *map, unsigned routeId){
-    if (map == NULL || routeId == 0 || routeId > 999)
-        return false; //Wrong parameters
-    
-    Route *route = getVec(map->routes, routeId);
-    if (route == NULL)
-        return false; //Route does not exist
-    
-    vector *roads = getRouteRoads(route);
-    for (int i = 0; i < vecSize(roads); i++)
-        removeRouteRoad(getVec(roads, i), route);
-    
-    destroyRoute(route);
-    setVec(map->routes, routeId, NULL);
-    
-    return true; //Route successfuly deleted
+bool beginTransaction(Map *map) {
+    if (map == NULL || map->transaction != NULL)
+        return false;//Wrong parameters or the transaction is open
+
+    map->transaction = (struct Transaction*) calloc(1, sizeof(Transaction));
+    return map->transaction != NULL;
 }
 
-char const *getRouteDescription(Map *map, unsigned routeId) {
-    if (map == NULL)
-        return NULL;//Wrong parameters
+bool inTransaction(Map *map) {
+    return map != NULL && map->transaction != NULL;
+}
 
-    Text *out = newText("");
-    if (out == NULL)
-        return NULL;//Failed to allocate memory
-    
-    Route *route = getRoute(map, routeId);
-    if (route == NULL) {
-        char *str_out = to_cString(out);
-        destroyText(out);
-        return str_out;
+/// @private Frees the closed transaction.
+static void closeTransaction(Map *map) {
+    free(map->transaction->changes);
+    free(map->transaction);
+    map->transaction = NULL;
+}
+
+void rollbackTransaction(Map *map) {
+    if (map == NULL || map->transaction == NULL)
+        return;
+
+    //The changes are undone from the last one, so the positions of the roads are valid
+    Transaction *transaction = map->transaction;
+    for (int i = transaction->size - 1; i >= 0; i--) {
+        TransactionChange *change = &transaction->changes[i];
+        if (change->kind == ADDED_ROAD) {
+            remRoad(change->c1, change->c2);
+            logRoadChange(map, CHANGE_ROAD_REMOVED, change->road, change->c1, change->c2);
+            destroyRoad(change->road);
+        }
+        else if (change->kind == REMOVED_ROAD) {
+            restoreRoad(change->c1, change->road, change->x);
+            restoreRoad(change->c2, change->road, change->y);
+            logRoadChange(map, CHANGE_ROAD_ADDED, change->road, change->c1, change->c2);
+        }
+        else {
+            setRoadYear(change->road, change->year);
+            logRoadChange(map, CHANGE_ROAD_REPAIRED, change->road, change->c1, change->c2);
+            logRoadRoutes(map, change->road, NULL);
+        }
     }
-    
-    Text *tmp = out;
-    tmp = appendUInt(out, routeId);
-    tmp = appendString(out, ";");
 
-    City *last = getRouteStart(route);
-    vector *roads = getRouteRoads(route);
-    for (int i = 0; i < vecSize(roads) && tmp != NULL; i++) {
-        tmp = appendString(out, getCityName(last));
-        tmp = appendString(out, ";");
+    if (transaction->size > 0) {
+        map->componentsStale = true;
+        clearTreeCache(map->trees);
+    }
+    closeTransaction(map);
+}
 
+/// @private Returns the first road of the route removed in the transaction(NULL if there is none).
+static Road *removedRoadRoute(Route *route) {
+    vector *roads = getRouteRoads(route);
+    for (int i = 0; i < vecSize(roads); i++) {
         Road *road = getVec(roads, i);
+        City *a = getAnyCityFromRoad(road);
+        if (getRoadCity(a, getConnectedCity(road, a)) != road)
+            return road;
+    }
 
-        tmp = appendInt(out, getRoadLength(road));
-        tmp = appendString(out, ";");
-        tmp = appendInt(out, getRoadYear(road));
-        tmp = appendString(out, ";");
+    return NULL;
+}
 
-        last = getConnectedCity(road, last);
+/**
+ @private
+ @brief
+ Replaces the removed roads of the route with the detours, from
+ the start of the route, as @ref removeRoad would replace them
+ one by one in the map after the transaction.
+ @return
+ @p false if some detour does not exist or the memory
+ could not be allocated.
+ */
+static bool repairRoute(Map *map, Route *route) {
+    SearchWorkspace *ws = getVec(map->workspaces, 0);
+
+    Road *road;
+    while ((road = removedRoadRoute(route)) != NULL) {
+        City *c1 = getAnyCityFromRoad(road);
+        City *c2 = getConnectedCity(road, c1);
+        unsigned radius = (getRoadLength(road) > INT_MAX / DETOUR_RADIUS ?
+                           UINT_MAX : (unsigned) getRoadLength(road) * DETOUR_RADIUS);
+
+        vector *insert = fixRouteVec(map, ws, route, c1, c2, radius);
+        if (insert == NULL)
+            return false;
+
+        int ip = getCityIndexInRoute(route, firstCityInRoute(route, c1, c2));
+        removeRoadRoute(route, road);
+        if (vecSize(getRouteRoads(route)) == 0)
+            copyRoadsRoute(route, insert);//The detour replaces the only road
+        else
+            insertRoadsRoute(route, insert, ip);
+        destroyVec(insert);
     }
-    tmp = appendString(out, getCityName(getRouteEnd(route)));
 
-    if (tmp == NULL) {
-        destroyText(out);
-        return NULL;//Failed to add data to the string
-    }
+    return true;
+}
 
-    char *ready = to_cString(out);
-    destroyText(out);
-    if (ready == NULL)
-        return NULL;//Failed to allocate memory
+/// @private Gives the route its roads from before @ref repairRoute.
+static void restoreRouteRoads(Route *route, vector *roads) {
+    vector *current = getRouteRoads(route);
+    for (int i = 0; i < vecSize(current); i++)
+        removeRouteRoad(getVec(current, i), route);
+    for (int i = 0; i < vecSize(roads); i++)
+        removeRouteRoad(getVec(roads, i), route);
+
+    copyRoadsRoute(route, roads);
+}
+
+/// @private Records the change of the route which had the roads 'before'.
+static void logRepairedRoute(Map *map, Route *route, vector *before) {
+    vector *after = getRouteRoads(route);
+    int prefix = 0, suffix = 0;
+    int size = (vecSize(before) < vecSize(after) ? vecSize(before) : vecSize(after));
+
+    while (prefix < size && getVec(before, prefix) == getVec(after, prefix))
+        prefix++;
+    while (suffix < size - prefix && getVec(before, vecSize(before) - 1 - suffix)
+                                     == getVec(after, vecSize(after) - 1 - suffix))
+        suffix++;
+
+    logRouteChange(map, CHANGE_ROUTE_REPAIRED, route, prefix,
+                   vecSize(before) - prefix - suffix, vecSize(after) - prefix - suffix);
+}
+
+bool commitTransaction(Map *map) {
+    if (map == NULL || map->transaction == NULL)
+        return false;//Wrong parameters
+
+    Transaction *transaction = map->transaction;
+    int routes = vecSize(map->routes);
+    vector **saved = (vector**) calloc(routes + 1, sizeof(vector*));
+    bool *affected = (bool*) calloc(routes + 1, sizeof(bool));
+    bool err = (saved == NULL || affected == NULL);
+
+    //Every route is repaired once, after all roads are changed
+    for (int i = 0; i < transaction->size && !err; i++)
+        if (transaction->changes[i].kind == REMOVED_ROAD) {
+            vector *roadRoutes = getRoutesRoad(transaction->changes[i].road);
+            for (int j = 0; j < vecSize(roadRoutes); j++)
+                affected[getRouteNumber(getVec(roadRoutes, j))] = true;
+        }
+
+    if (!err && getComponents(map) == NULL)
+        err = true;//Failed to allocate memory
+
+    //The routes are repaired in the order of their numbers
+    for (int i = 0; i < routes && !err; i++) {
+        if (!affected[i])
+            continue;
+
+        Route *route = getRoute(map, i);
+        saved[i] = copyVec(getRouteRoads(route));
+        err = (saved[i] == NULL || !repairRoute(map, route));
+    }
+
+    for (int i = 0; i < routes && saved != NULL; i++)
+        if (saved[i] != NULL) {
+            if (err)
+                restoreRouteRoads(getRoute(map, i), saved[i]);
+            else
+                logRepairedRoute(map, getRoute(map, i), saved[i]);
+            destroyVec(saved[i]);
+        }
+    free(saved);
+    free(affected);
+
+    if (err) {
+        rollbackTransaction(map);
+        return false;
+    }
+
+    for (int i = 0; i < transaction->size; i++)
+        if (transaction->changes[i].kind == REMOVED_ROAD)
+            destroyRoad(transaction->changes[i].road);
+    closeTransaction(map);
+
+    return true;
+}
+
+bool setChangeLog(Map *map, unsigned capacity) {
+    if (map == NULL)
+        return false;//Wrong parameters
+
+    MapChange *changes = NULL;
+    if (capacity > 0 && (changes = (MapChange*) malloc(sizeof(MapChange) * capacity)) == NULL)
+        return false;//Failed to allocate memory
+
+    //The numbers continue, so an old cursor is not mistaken for a new one
+    ChangeLog *log = &map->changeLog;
+    free(log->changes);
+    log->changes = changes;
+    log->capacity = capacity;
+    log->first = log->last + 1;
+    return true;
+}
+
+unsigned long long lastChange(Map *map) {
+    return (map == NULL ? 0 : map->changeLog.last);
+}
+
+int readChanges(Map *map, unsigned long long *cursor, MapChange *changes, int max) {
+    if (map == NULL || cursor == NULL || max < 0 || (changes == NULL && max > 0))
+        return -1;//Wrong parameters
+
+    ChangeLog *log = &map->changeLog;
+    if (log->capacity == 0 || cursor[0] > log->last)
+        return -1;//The changes are not recorded or the cursor is wrong
+
+    unsigned long long oldest = (log->last > log->capacity ? log->last - log->capacity + 1 : 1);
+    if (oldest < log->first)
+        oldest = log->first;
+    if (cursor[0] + 1 < oldest)
+        return -1;//Some changes after the cursor were overwritten
+
+    int count = 0;
+    while (count < max && cursor[0] < log->last) {
+        cursor[0]++;
+        changes[count++] = log->changes[(cursor[0] - 1) % log->capacity];
+    }
+
+    return count;
+}
+
+void setMapInterleaving(Map *map, int searches) {
+    if (map == NULL)
+        return;
+
+    map->interleave = (searches < 1 ? 1 : (searches > MAX_INTERLEAVED ? MAX_INTERLEAVED : searches));
+}
+
+void setMapParallelSearch(Map *map, int cities) {
+    if (map == NULL)
+        return;
+
+    map->parallelCities = (cities < 0 ? 0 : cities);
+}
+
+void setMapThreads(Map *map, int threads) {
+    if (map == NULL)
+        return;
+
+    map->threads = (threads < 0 ? 0 : threads);
+    destroyThreadPool(map->pool);
+    map->pool = NULL;
+}
+
+//TODO: Check this function for memory leaks
+bool removeRoute(Map *map, unsigned routeId){
+    if (map == NULL || routeId == 0 || routeId > 999)
+        return false; //Wrong parameters
+    if (map->transaction != NULL)
+        return false;//Routes are not changed in a transaction
+    
+    Route *route = getVec(map->routes, routeId);
+    if (route == NULL)
+        return false; //Route does not exist
+    
+    vector *roads = getRouteRoads(route);
+    for (int i = 0; i < vecSize(roads); i++)
+        removeRouteRoad(getVec(roads, i), route);
+    logRouteChange(map, CHANGE_ROUTE_REMOVED, route, 0, vecSize(roads), 0);
+    
+    destroyRoute(route);
+    setVec(map->routes, routeId, NULL);
+    
+    return true; //Route successfuly deleted
+}
+
+RepairStats getRepairStats(Map *map) {
+    RepairStats out = {0, 0, 0, 0};
+    if (map == NULL)
+        return out;
+
+    out.local = atomic_load(&map->localRepairs);
+    out.widened = atomic_load(&map->widenedRepairs);
+    out.global = atomic_load(&map->globalRepairs);
+    out.settled = atomic_load(&map->repairSettled);
+    return out;
+}
+
+/// @private Distances between the cities of a list.
+typedef struct Distances{
+    /// The map.
+    Map *map;
+    /// The cities.
+    City **cities;
+    /// Number of the cities.
+    int n;
+    /// The results(see @ref distanceMatrix).
+    RouteDistance *out;
+    /// Whether the memory could not be allocated.
+    atomic_bool failed;
+}Distances;
+
+/// @private Finds the distances from the city with number 'index' to the next cities.
+static void findDistances(void *data, int index, int thread) {
+    Distances *distances = (Distances*) data;
+    SearchWorkspace *ws = getVec(distances->map->workspaces, thread);
+    City **cities = distances->cities;
+    int n = distances->n;
+
+    //The search ends when the next cities are reached
+    if (!searchManyRoutes(ws, nextID(distances->map), cities[index],
+                          cities + index + 1, n - index - 1)) {
+        atomic_store(&distances->failed, true);
+        return;
+    }
+
+    for (int j = index + 1; j < n; j++) {
+        if (cities[j] == cities[index])
+            continue;//The same city
+
+        //The route back is checked as the search from the other city would choose it
+        Distance d, back;
+        int routes = finishRouteCheck(ws, cities[j], &d);
+        int backRoutes = finishReversedRouteCheck(ws, cities[j], &back);
+        if (routes == -1 || backRoutes == -1) {
+            atomic_store(&distances->failed, true);
+            return;
+        }
+
+        RouteDistance *rd = &distances->out[index * n + j];
+        if (routes > 0) {
+            rd->length = d.distance;
+            rd->oldestRoad = d.oldestRoad;
+            rd->unique = (routes == 1);
+        }
+        distances->out[j * n + index] = *rd;
+        distances->out[j * n + index].unique = (backRoutes == 1);
+    }
+}
+
+RouteDistance *distanceMatrix(Map *map, const char **cities, int n) {
+    if (map == NULL || cities == NULL || n <= 0)
+        return NULL;//Wrong parameters
+
+    Distances distances;
+    distances.map = map;
+    distances.n = n;
+    distances.cities = (City**) malloc(sizeof(City*) * n);
+    distances.out = (RouteDistance*) calloc((size_t) n * n, sizeof(RouteDistance));
+    atomic_init(&distances.failed, false);
+
+    bool err = (distances.cities == NULL || distances.out == NULL);
+    for (int i = 0; i < n && !err; i++)
+        if (cities[i] == NULL || (distances.cities[i] = getCity(map, cities[i])) == NULL)
+            err = true;//City not found
+
+    if (!err) {
+        //The searches only read the map, so they run at once
+        ThreadPool *pool = searchPool(map, n - 1);
+        if (pool != NULL)
+            runThreadPool(pool, &findDistances, &distances, n - 1);
+        else
+            for (int i = 0; i < n - 1; i++)
+                findDistances(&distances, i, 0);
+
+        err = atomic_load(&distances.failed);
+    }
+
+    free(distances.cities);
+    if (err) {
+        free(distances.out);
+        return NULL;
+    }
+    return distances.out;
+}
+
+unsigned long long getMapRouteVersion(Map *map, unsigned routeId) {
+    if (map == NULL)
+        return 0;//Wrong parameters
+
+    Route *route = getRoute(map, routeId);
+    if (route == NULL)
+        return 0;
+    return getRouteVersion(route);
+}
+
+unsigned long long getRouteLength(Map *map, unsigned routeId) {
+    if (map == NULL)
+        return 0;//Wrong parameters
+
+    Route *route = getRoute(map, routeId);
+    if (route == NULL)
+        return 0;
+    return getLengthRoute(route);
+}
+
+int getRouteOldestYear(Map *map, unsigned routeId) {
+    if (map == NULL)
+        return 0;//Wrong parameters
+
+    Route *route = getRoute(map, routeId);
+    if (route == NULL || getHopCountRoute(route) == 0)
+        return 0;
+    return getOldestYearRoute(route);
+}
+
+int getRouteHopCount(Map *map, unsigned routeId) {
+    if (map == NULL)
+        return 0;//Wrong parameters
+
+    Route *route = getRoute(map, routeId);
+    if (route == NULL)
+        return 0;
+    return getHopCountRoute(route);
+}
+
+/// @private Compares the numbers of the routes.
+static int compareRouteIds(const void *a, const void *b) {
+    unsigned x = *(const unsigned*) a, y = *(const unsigned*) b;
+    return (x > y) - (x < y);
+}
+
+unsigned *getCityRoutes(Map *map, const char *city, int *count) {
+    if (map == NULL || city == NULL || count == NULL)
+        return NULL;//Wrong parameters
+
+    City *c = getCity(map, city);
+    if (c == NULL)
+        return NULL;//City not found
+
+    if (!indexRoutesCity(c))
+        return NULL;//Failed to allocate memory
+
+    int size = routeCountCity(c);
+    unsigned *out = (unsigned*) malloc(sizeof(unsigned) * (size + 1));
+    if (out == NULL)
+        return NULL;
+
+    for (int i = 0; i < size; i++)
+        out[i] = getRouteNumber(getRouteCity(c, i));
+    qsort(out, size, sizeof(unsigned), &compareRouteIds);
+
+    count[0] = size;
+    return out;
+}
+
+/// @private Returns the planner with the current stops of the routes(NULL if the memory could not be allocated).
+static JourneyPlanner *getJourneyPlanner(Map *map) {
+    if (map->journeys == NULL && (map->journeys = newJourneyPlanner()) == NULL)
+        return NULL;
+
+    //The stops are copied again after any route or the number of the cities changes
+    unsigned long long version = lastRouteVersion();
+    if (map->journeysVersion != version || plannerCities(map->journeys) != nextID(map)) {
+        map->journeysVersion = 0;
+        if (!buildJourneyPlanner(map->journeys, map->routes, nextID(map)))
+            return NULL;
+        map->journeysVersion = version;
+    }
+
+    return map->journeys;
+}
+
+JourneyLeg *planJourney(Map *map, const char *city1, const char *city2, int *count) {
+    if (map == NULL || city1 == NULL || city2 == NULL || count == NULL)
+        return NULL;//Wrong parameters
+
+    City *from, *to;
+    if ((from = getCity(map, city1)) == NULL || (to = getCity(map, city2)) == NULL)
+        return NULL;//City not found
+    if (from == to)
+        return NULL;//Cities are the same
+
+    JourneyPlanner *planner = getJourneyPlanner(map);
+    PlannedLeg *legs;
+    int size;
+    if (planner == NULL || (size = planJourneyPlanner(planner, getCityID(from), getCityID(to), &legs)) < 0)
+        return NULL;//Failed to allocate memory
+
+    JourneyLeg *out = (JourneyLeg*) malloc(sizeof(JourneyLeg) * (size + 1));
+    if (out == NULL)
+        return NULL;
+
+    for (int i = 0; i < size; i++) {
+        out[i].routeId = legs[i].route;
+        out[i].from = getCityName(getVec(map->cities, legs[i].from));
+        out[i].to = getCityName(getVec(map->cities, legs[i].to));
+        out[i].length = legs[i].length;
+    }
+
+    count[0] = size;
+    return out;
+}
+
+AlternativeRoute *kShortestRoutes(Map *map, const char *city1, const char *city2, int k,
+                                  int *count) {
+    if (map == NULL || city1 == NULL || city2 == NULL || k < 1 || count == NULL)
+        return NULL;//Wrong parameters
+
+    City *from, *to;
+    if ((from = getCity(map, city1)) == NULL || (to = getCity(map, city2)) == NULL)
+        return NULL;//City not found
+    if (from == to)
+        return NULL;//Cities are the same
+
+    if (map->alternatives == NULL && (map->alternatives = newAlternativeSearch()) == NULL)
+        return NULL;
+
+    //All searches are directed by the tree of the routes from 'to'
+    SearchWorkspace *tree = findTreeCache(map->trees, to, nextID(map));
+    if (tree == NULL) {
+        ThreadPool *pool = NULL;
+        if (nextID(map) >= map->parallelCities)
+            pool = searchPool(map, nextID(map));
+        tree = addTreeCache(map->trees, to, nextID(map), pool);
+    }
+
+    Alternative *routes;
+    int size;
+    if (tree == NULL
+        || (size = findAlternatives(map->alternatives, nextID(map), from, to, tree, k, &routes)) < 0)
+        return NULL;//Failed to allocate memory
+
+    //The names of the cities are kept behind the routes, so one free releases all
+    size_t names = 0;
+    for (int i = 0; i < size; i++)
+        names += routes[i].size;
+
+    AlternativeRoute *out = (AlternativeRoute*) malloc(sizeof(AlternativeRoute) * (size + 1)
+                                                       + sizeof(char*) * names);
+    if (out == NULL)
+        return NULL;
+
+    const char **name = (const char**) (out + size + 1);
+    for (int i = 0; i < size; i++) {
+        out[i].length = routes[i].distance;
+        out[i].oldestYear = routes[i].oldestRoad;
+        out[i].cityCount = routes[i].size;
+        out[i].cities = name;
+        for (int j = 0; j < routes[i].size; j++)
+            *name++ = getCityName(routes[i].cities[j]);
+    }
+
+    count[0] = size;
+    return out;
+}
+
+/// @private Function given to @ref citiesWithin with its data.
+typedef struct WithinVisit{
+    /// The function.
+    void (*visit)(void *data, const char *city, unsigned distance);
+    /// Data passed to the function.
+    void *data;
+}WithinVisit;
+
+/// @private Gives the name of the city found by @ref searchWithin to the function.
+static void visitWithin(void *data, City *city, unsigned distance) {
+    WithinVisit *within = (WithinVisit*) data;
+    within->visit(within->data, getCityName(city), distance);
+}
+
+bool citiesWithin(Map *map, const char *city, unsigned distance,
+                  void (*visit)(void *data, const char *city, unsigned distance), void *data) {
+    if (map == NULL || city == NULL || visit == NULL)
+        return false;//Wrong parameters
+
+    City *from = getCity(map, city);
+    if (from == NULL)
+        return false;//City not found
+
+    WithinVisit within = {visit, data};
+    return searchWithin(getVec(map->workspaces, 0), nextID(map), from, distance,
+                        &visitWithin, &within);
+}
+
+/// @private Adds the description of the route(see @ref getRouteDescription) to the sink.
+static void sinkRoute(Sink *sink, unsigned routeId, Route *route) {
+    putSinkUInt(sink, routeId);
+    putSinkChar(sink, ';');
+
+    City *last = getRouteStart(route);
+    vector *roads = getRouteRoads(route);
+    for (int i = 0; i < vecSize(roads); i++) {
+        Road *road = getVec(roads, i);
+
+        putSinkString(sink, getCityName(last));
+        putSinkChar(sink, ';');
+        putSinkInt(sink, getRoadLength(road));
+        putSinkChar(sink, ';');
+        putSinkInt(sink, getRoadYear(road));
+        putSinkChar(sink, ';');
+
+        last = getConnectedCity(road, last);
+    }
+    putSinkString(sink, getCityName(getRouteEnd(route)));
+}
+
+/// @private Text gathered from a sink(see @ref appendSinkText).
+typedef struct SinkText{
+    /// The text ended by '\0'(NULL if it is empty).
+    char *text;
+    /// Length of the text.
+    size_t size;
+    /// Size of the array 'text' without the '\0'.
+    size_t capacity;
+    /// Whether the memory could not be allocated.
+    bool failed;
+}SinkText;
+
+/// @private Appends the text written to the sink to the 'SinkText'.
+static void appendSinkText(void *data, const char *text, size_t size) {
+    SinkText *out = (SinkText*) data;
+    if (out->failed)
+        return;
+
+    if (out->size + size > out->capacity) {
+        size_t capacity = (out->capacity == 0 ? 64 : out->capacity);
+        while (capacity < out->size + size)
+            capacity *= 2;
+
+        char *grown = (char*) realloc(out->text, capacity + 1);
+        if (grown == NULL) {
+            out->failed = true;
+            return;
+        }
+        out->text = grown;
+        out->capacity = capacity;
+    }
+
+    memcpy(out->text + out->size, text, size);
+    out->size += size;
+    out->text[out->size] = '\0';
+}
+
+/// @private Returns a copy of the first 'size' characters of the text.
+static char *copyDescription(const char *text, size_t size) {
+    char *out = (char*) malloc(size + 1);
+    if (out == NULL)
+        return NULL;
+
+    memcpy(out, text, size);
+    out[size] = '\0';
+    return out;
+}
+
+char const *getRouteDescription(Map *map, unsigned routeId) {
+    if (map == NULL)
+        return NULL;//Wrong parameters
+
+    Route *route = getRoute(map, routeId);
+    if (route == NULL)
+        return copyDescription("", 0);
+
+    //The description of an unchanged route is only copied
+    size_t size;
+    pthread_mutex_lock(&map->descriptions);
+    const char *stored = getDescriptionRoute(route, &size);
+    char *out = (stored == NULL ? NULL : copyDescription(stored, size));
+    pthread_mutex_unlock(&map->descriptions);
+    if (stored != NULL)
+        return out;
+
+    //The readers of a shared map do not change the route, so its stamp stays the same
+    unsigned long long version = getRouteVersion(route);
+    SinkText text = {NULL, 0, 0, false};
+    Sink sink;
+    initSink(&sink, &appendSinkText, &text);
+    sinkRoute(&sink, routeId, route);
+    flushSink(&sink);
+
+    out = (text.failed ? NULL : copyDescription(text.text, text.size));
+    if (out == NULL) {
+        free(text.text);
+        return NULL;//Failed to allocate memory
+    }
+
+    pthread_mutex_lock(&map->descriptions);
+    setDescriptionRoute(route, text.text, text.size, version);
+    pthread_mutex_unlock(&map->descriptions);
+
+    return out;
+}
+
+bool exportRoutes(Map *map, void (*write)(void *data, const char *text, size_t size),
+                  void *data) {
+    if (map == NULL || write == NULL)
+        return false;//Wrong parameters
+
+    Sink sink;
+    initSink(&sink, write, data);
+
+    for (int i = 1; i < vecSize(map->routes); i++) {
+        Route *route = getVec(map->routes, i);
+        if (route == NULL)
+            continue;
+
+        sinkRoute(&sink, (unsigned) i, route);
+        putSinkChar(&sink, '\n');
+    }
+    flushSink(&sink);
+
+    return true;
+}
+
+bool exportRoads(Map *map, void (*write)(void *data, const char *text, size_t size),
+                 void *data) {
+    if (map == NULL || write == NULL)
+        return false;//Wrong parameters
+
+    Sink sink;
+    initSink(&sink, write, data);
+
+    for (int i = 0; i < nextID(map); i++) {
+        City *city = getVec(map->cities, i);
+        vector *roads = getRoadsCity(city);
+
+        for (int j = 0; j < vecSize(roads); j++) {
+            Road *road = getVec(roads, j);
+            if (getAnyCityFromRoad(road) != city)
+                continue;//Every road is written by the city it was created from
+
+            putSinkString(&sink, getCityName(city));
+            putSinkChar(&sink, ';');
+            putSinkString(&sink, getCityName(getConnectedCity(road, city)));
+            putSinkChar(&sink, ';');
+            putSinkInt(&sink, getRoadLength(road));
+            putSinkChar(&sink, ';');
+            putSinkInt(&sink, getRoadYear(road));
+            putSinkChar(&sink, '\n');
+        }
+    }
+    flushSink(&sink);
+
+    return true;
+}
+
+bool encodeMap(Map *map, ByteBuffer *out) {
+    if (map == NULL || out == NULL)
+        return false;//Wrong parameters
+    if (map->transaction != NULL)
+        return false;//The routes may use the removed roads
+
+    bool err = (putVarUInt(out, nextID(map)) == NULL);
+    for (int i = 0; i < nextID(map) && !err; i++)
+        err |= (putString(out, getCityName(getVec(map->cities, i))) == NULL);
+
+    //Roads are written in the order in which the cities store them
+    for (int i = 0; i < nextID(map) && !err; i++) {
+        City *city = getVec(map->cities, i);
+        vector *roads = getRoadsCity(city);
+
+        err |= (putVarUInt(out, vecSize(roads)) == NULL);
+        for (int j = 0; j < vecSize(roads) && !err; j++) {
+            Road *road = getVec(roads, j);
+            int other = getCityID(getConnectedCity(road, city));
+
+            err |= (putVarUInt(out, other) == NULL);
+            if (other > i) {//The road is described by the city with the lower ID
+                err |= (putVarUInt(out, (unsigned) getRoadLength(road)) == NULL);
+                err |= (putVarInt(out, getRoadYear(road)) == NULL);
+            }
+        }
+    }
+
+    int routes = 0;
+    for (int i = 1; i < vecSize(map->routes); i++)
+        if (getVec(map->routes, i) != NULL)
+            routes++;
+
+    err |= (putVarUInt(out, routes) == NULL);
+    for (int i = 1; i < vecSize(map->routes) && !err; i++) {
+        Route *route = getVec(map->routes, i);
+        if (route == NULL)
+            continue;
+
+        City *last = getRouteStart(route);
+        vector *roads = getRouteRoads(route);
+
+        err |= (putVarUInt(out, i) == NULL);
+        err |= (putVarUInt(out, getCityID(last)) == NULL);
+        err |= (putVarUInt(out, vecSize(roads)) == NULL);
+        for (int j = 0; j < vecSize(roads) && !err; j++) {
+            last = getConnectedCity(getVec(roads, j), last);
+            err |= (putVarUInt(out, getCityID(last)) == NULL);
+        }
+    }
+
+    return !err;
+}
+
+/**
+ @private
+ @brief
+    Frees the roads of a map whose city road lists
+    were only partially decoded. Every road is stored
+    at least by the city it was created from.
+ */
+static void discardDecodedRoads(Map *map) {
+    for (int i = 0; i < nextID(map); i++) {
+        City *city = getVec(map->cities, i);
+        vector *roads = getRoadsCity(city);
+
+        for (int j = 0; j < vecSize(roads); j++)
+            if (getAnyCityFromRoad(getVec(roads, j)) == city)
+                destroyRoad(getVec(roads, j));
+    }
+
+    for (int i = 0; i < nextID(map); i++)
+        resetVec(getRoadsCity(getVec(map->cities, i)));
+}
+
+/// @private
+static bool decodeRoads(Map *map, ByteReader *in) {
+    uint64_t created = 0, entries = 0;
+
+    for (int i = 0; i < nextID(map); i++) {
+        City *city = getVec(map->cities, i);
+        uint64_t degree;
+        if (!getVarUInt(in, &degree))
+            return false;
+
+        for (uint64_t j = 0; j < degree; j++) {
+            uint64_t other, length;
+            int64_t year;
+            if (!getVarUInt(in, &other) || other >= (uint64_t) nextID(map) ||
+                other == (uint64_t) i)
+                return false;//Wrong city
+
+            City *dest = getVec(map->cities, (int) other);
+            if (getRoadCity(city, dest) != NULL)
+                return false;//Road listed twice
+
+            Road *road;
+            if (other > (uint64_t) i) {
+                if (!getVarUInt(in, &length) || !getVarInt(in, &year) ||
+                    year < INT_MIN || year > INT_MAX)
+                    return false;
+
+                road = newRoad(city, dest, (int) year, (int) length);
+                if (road == NULL)
+                    return false;//Failed to allocate memory
+                created++;
+            }
+            else if ((road = getRoadCity(dest, city)) == NULL)
+                return false;//The road was not described earlier
+
+            if (pushBackVec(getRoadsCity(city), road) == NULL) {
+                if (other > (uint64_t) i)
+                    destroyRoad(road);
+                return false;//Failed to allocate memory
+            }
+            entries++;
+        }
+    }
+
+    return entries == 2 * created;//Every road is stored by both cities
+}
+
+/// @private
+static bool decodeRoutes(Map *map, ByteReader *in) {
+    uint64_t routes;
+    if (!getVarUInt(in, &routes))
+        return false;
+
+    for (uint64_t i = 0; i < routes; i++) {
+        uint64_t routeId, start, size;
+        if (!getVarUInt(in, &routeId) || !getVarUInt(in, &start) ||
+            !getVarUInt(in, &size))
+            return false;
+        if (routeId == 0 || routeId > 999 || getRoute(map, routeId) != NULL)
+            return false;//Wrong route number
+        if (start >= (uint64_t) nextID(map) || size == 0)
+            return false;
+
+        vector *roads = newVec((int) size);
+        if (roads == NULL)
+            return false;
+
+        City *last = getVec(map->cities, (int) start);
+        bool err = false;
+        for (uint64_t j = 0; j < size && !err; j++) {
+            uint64_t next;
+            Road *road = NULL;
+            if (!getVarUInt(in, &next) || next >= (uint64_t) nextID(map) ||
+                (road = getRoadCity(last, getVec(map->cities, (int) next))) == NULL)
+                err = true;
+            else {
+                pushBackVec(roads, road);
+                last = getVec(map->cities, (int) next);
+            }
+        }
+
+        Route *route = NULL;
+        if (!err && (route = addRoute(map, (unsigned) routeId)) == NULL)
+            err = true;
+
+        if (!err) {
+            setRouteStart(route, getVec(map->cities, (int) start));
+            setRouteEnd(route, last);
+            copyRoadsRoute(route, roads);
+        }
+        destroyVec(roads);
+
+        if (err)
+            return false;
+    }
+
+    return true;
+}
+
+Map *decodeMap(ByteReader *in) {
+    if (in == NULL)
+        return NULL;//Wrong parameters
+
+    Map *map = newMap();
+    if (map == NULL)
+        return NULL;//Failed to allocate memory
+
+    uint64_t cities;
+    bool err = !getVarUInt(in, &cities);
+    for (uint64_t i = 0; i < cities && !err; i++) {
+        char *name = NULL;
+        if (!getString(in, &name))
+            err = true;
+        else if (getCity(map, name) != NULL || addCity(map, name) == NULL)
+            err = true;//Repeated or wrong city name
+        free(name);
+    }
+
+    if (!err && !decodeRoads(map, in)) {
+        discardDecodedRoads(map);
+        err = true;
+    }
+
+    if (!err)
+        err = !decodeRoutes(map, in);
+
+    if (err) {
+        deleteMap(map);
+        return NULL;
+    }
 
-    return ready;
+    map->componentsStale = true;//The roads were added directly
+    return map;
 }
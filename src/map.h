@@ -12,6 +12,7 @@
 #include <stdbool.h>
 
 #include "vector.h"
+#include "ByteBuffer.h"
 
 /**
  * Struktura przechowująca mapę dróg krajowych.
@@ -49,6 +50,56 @@ void deleteMap(Map *map);
 bool addRoad(Map *map, const char *city1, const char *city2,
              unsigned length, int builtYear);
 
+/**
+ * Odcinki dróg dodawane do mapy jednocześnie(zobacz @ref beginRoadBatch).
+ */
+typedef struct RoadBatch RoadBatch;
+
+/** @brief Rozpoczyna dodawanie wielu odcinków dróg naraz.
+ * Odcinki dodane funkcją @ref addRoadBatch są tylko zapamiętywane, a miasta
+ * i odcinki dróg powstają dopiero w funkcji @ref commitRoadBatch, za jednym
+ * razem, w czasie proporcjonalnym do liczby odcinków. Mapa może być zmieniana
+ * przed zatwierdzeniem, zatwierdzane odcinki są porównywane z jej stanem
+ * w chwili zatwierdzenia.
+ * @param[in,out] map    – wskaźnik na strukturę przechowującą mapę dróg.
+ * @return Wskaźnik na utworzoną strukturę lub NULL, gdy parametr jest
+ * niepoprawny lub nie udało się zaalokować pamięci.
+ */
+RoadBatch *beginRoadBatch(Map *map);
+
+/** @brief Zapamiętuje odcinek drogi do dodania.
+ * Kopiuje nazwy miast, więc napisy mogą zostać zwolnione po wywołaniu.
+ * @param[in,out] batch  – wskaźnik na strukturę utworzoną funkcją
+ * @ref beginRoadBatch;
+ * @param[in] city1      – wskaźnik na napis reprezentujący nazwę miasta;
+ * @param[in] city2      – wskaźnik na napis reprezentujący nazwę miasta;
+ * @param[in] length     – długość w km odcinka drogi;
+ * @param[in] builtYear  – rok budowy odcinka drogi.
+ * @return Wartość @p true, jeśli odcinek został zapamiętany.
+ * Wartość @p false, jeśli któryś z parametrów ma niepoprawną wartość, obie
+ * podane nazwy miast są identyczne lub nie udało się zaalokować pamięci.
+ */
+bool addRoadBatch(RoadBatch *batch, const char *city1, const char *city2,
+                  unsigned length, int builtYear);
+
+/** @brief Dodaje zapamiętane odcinki dróg do mapy i usuwa strukturę.
+ * Wynik jest taki sam, jak po wywołaniu funkcji @ref addRoad dla kolejnych
+ * zapamiętanych odcinków: brakujące miasta są tworzone w kolejności pierwszego
+ * użycia, a odcinek pomiędzy miastami, które już są połączone odcinkiem drogi
+ * (istniejącym lub zapamiętanym wcześniej), jest pomijany.
+ * @param[in,out] batch  – wskaźnik na strukturę utworzoną funkcją
+ * @ref beginRoadBatch.
+ * @return Liczba dodanych odcinków dróg lub -1, gdy parametr jest niepoprawny
+ * lub nie udało się zaalokować pamięci. Wtedy żaden odcinek nie zostaje
+ * dodany, ale część miast mogła zostać utworzona.
+ */
+int commitRoadBatch(RoadBatch *batch);
+
+/** @brief Usuwa strukturę bez dodawania zapamiętanych odcinków dróg.
+ * @param[in] batch      – wskaźnik na usuwaną strukturę.
+ */
+void abortRoadBatch(RoadBatch *batch);
+
 /** @brief Modyfikuje rok ostatniego remontu odcinka drogi.
  * Dla odcinka drogi między dwoma miastami zmienia rok jego ostatniego remontu
  * lub ustawia ten rok, jeśli odcinek nie był jeszcze remontowany.
@@ -84,6 +135,23 @@ bool repairRoad(Map *map, const char *city1, const char *city2, int repairYear);
 bool newRoute(Map *map, unsigned routeId,
               const char *city1, const char *city2);
 
+/** @brief Tworzy wiele dróg krajowych naraz.
+ * Działa tak, jak wywołanie funkcji @ref newRoute dla kolejnych dróg krajowych
+ * z tablic, ale drogi krajowe zaczynające się lub kończące w tym samym mieście
+ * są wyznaczane jednym przeszukaniem mapy, a przeszukania od różnych miast
+ * wykonuje kilka wątków(zobacz @ref setMapThreads).
+ * @param[in,out] map    – wskaźnik na strukturę przechowującą mapę dróg;
+ * @param[in] routeIds   – tablica numerów dróg krajowych;
+ * @param[in] cities1    – tablica nazw miast, w których zaczynają się drogi krajowe;
+ * @param[in] cities2    – tablica nazw miast, w których kończą się drogi krajowe;
+ * @param[in] n          – liczba dróg krajowych;
+ * @param[out] created   – tablica, w której dla każdej drogi krajowej zapisywane
+ * jest, czy została utworzona(może mieć wartość NULL).
+ * @return Liczba utworzonych dróg krajowych.
+ */
+int newRoutes(Map *map, unsigned *routeIds, const char **cities1,
+              const char **cities2, int n, bool *created);
+
 //Komentarz wyjatkowo w jezyku polskim aby zachowac jednorodnosc w pliku(map.h).
 /** @brief Tworzy droge krajowa przechodzaca przez podane miasta.
  * Tworzy drogę krajową o podanym numerze i przebiegu. Jeśli jakieś miasto lub
@@ -140,6 +208,48 @@ bool extendRoute(Map *map, unsigned routeId, const char *city);
  */
 bool removeRoad(Map *map, const char *city1, const char *city2);
 
+/** @brief Rozpoczyna transakcję.
+ * Do jej zatwierdzenia funkcją @ref commitTransaction lub wycofania funkcją
+ * @ref rollbackTransaction funkcje @ref addRoad, @ref repairRoad
+ * i @ref removeRoad zmieniają odcinki dróg od razu, ale @ref removeRoad nie
+ * uzupełnia dróg krajowych: przechodzą one przez usunięte odcinki aż do
+ * zatwierdzenia transakcji. Funkcje tworzące, zmieniające i usuwające drogi
+ * krajowe, @ref commitRoadBatch oraz @ref encodeMap kończą się wtedy błędem.
+ * @param[in,out] map    – wskaźnik na strukturę przechowującą mapę dróg.
+ * @return Wartość @p true, jeśli transakcja została rozpoczęta.
+ * Wartość @p false, jeśli parametr ma niepoprawną wartość, transakcja jest już
+ * rozpoczęta lub nie udało się zaalokować pamięci.
+ */
+bool beginTransaction(Map *map);
+
+/** @brief Sprawdza, czy transakcja jest rozpoczęta.
+ * @param[in] map        – wskaźnik na strukturę przechowującą mapę dróg.
+ * @return Wartość @p true, jeśli transakcja jest rozpoczęta.
+ */
+bool inTransaction(Map *map);
+
+/** @brief Zatwierdza transakcję.
+ * Uzupełnia każdą drogę krajową, która przechodzi przez usunięte w transakcji
+ * odcinki dróg, raz, na mapie po wszystkich zmianach. Usunięte odcinki są
+ * zastępowane po kolei, od początku drogi krajowej, tak jak zrobiłaby to
+ * funkcja @ref removeRoad po transakcji. Drogi krajowe są uzupełniane
+ * w kolejności numerów.
+ * @param[in,out] map    – wskaźnik na strukturę przechowującą mapę dróg.
+ * @return Wartość @p true, jeśli transakcja została zatwierdzona.
+ * Wartość @p false, jeśli nie ma rozpoczętej transakcji, którejś drogi
+ * krajowej nie da się jednoznacznie uzupełnić lub nie udało się zaalokować
+ * pamięci. Wtedy transakcja jest wycofywana(zobacz @ref rollbackTransaction).
+ */
+bool commitTransaction(Map *map);
+
+/** @brief Wycofuje transakcję.
+ * Przywraca odcinki dróg, ich kolejność i lata remontów sprzed rozpoczęcia
+ * transakcji. Miasta utworzone w transakcji pozostają w mapie, bez odcinków
+ * dróg. Nic nie robi, jeśli nie ma rozpoczętej transakcji.
+ * @param[in,out] map    – wskaźnik na strukturę przechowującą mapę dróg.
+ */
+void rollbackTransaction(Map *map);
+
 /** @brief Usuwa drogę krajową o podanym numerze
  * Usuwa z mapy dróg drogę krajową o podanym numerze, jeśli taka istnieje.
  * A w przeciwnym przypadku niczego nie zmienia w mapie dróg.
@@ -168,4 +278,373 @@ bool removeRoute(Map *map, unsigned routeId);
  */
 char const *getRouteDescription(Map *map, unsigned routeId);
 
+/** @brief Ustala liczbę wątków szukających objazdów i odległości.
+ * Funkcja @ref removeRoad szuka objazdów dla wszystkich dróg krajowych
+ * przechodzących przez usuwany odcinek drogi jednocześnie, w kilku wątkach,
+ * a funkcje @ref distanceMatrix i @ref newRoutes w ten sam sposób szukają dróg
+ * od kolejnych miast. Wynik nie zależy od liczby wątków.
+ * @param[in,out] map    – wskaźnik na strukturę przechowującą mapę dróg;
+ * @param[in] threads    – liczba wątków; 0 oznacza jeden wątek na każdy
+ * procesor, 1 wyłącza dodatkowe wątki.
+ */
+void setMapThreads(Map *map, int threads);
+
+/** @brief Ustala liczbę wyszukiwań wykonywanych na przemian przez jeden wątek.
+ * Gdy funkcje @ref removeRoad i @ref newRoutes nie używają dodatkowych wątków,
+ * kilka wyszukiwań wykonuje się na przemian małymi krokami. Każdy krok prosi
+ * procesor o wczytanie pamięci potrzebnej w następnym kroku, która jest
+ * wczytywana w czasie kroków pozostałych wyszukiwań. Wynik nie zależy od
+ * liczby wyszukiwań.
+ * @param[in,out] map    – wskaźnik na strukturę przechowującą mapę dróg;
+ * @param[in] searches   – liczba wyszukiwań(co najwyżej 16); 1 oznacza
+ * wykonywanie wyszukiwań po kolei.
+ */
+void setMapInterleaving(Map *map, int searches);
+
+/** @brief Ustala wielkość mapy, od której jedno wyszukiwanie wykonuje wiele wątków.
+ * Funkcja @ref newRoute szuka najkrótszych dróg od miasta do wszystkich miast
+ * mapy. Na mapie z co najmniej @p cities miastami to wyszukiwanie wykonują
+ * naraz wszystkie wątki mapy(zobacz @ref setMapThreads). Wynik, również wybór
+ * jednoznacznej drogi, nie zależy od liczby wątków.
+ * @param[in,out] map    – wskaźnik na strukturę przechowującą mapę dróg;
+ * @param[in] cities     – liczba miast; 0 oznacza używanie wątków na każdej
+ * mapie. Domyślnie 1000000.
+ */
+void setMapParallelSearch(Map *map, int cities);
+
+/**
+ * Statystyki szukania objazdów przez funkcje @ref removeRoad.
+ * Objazd jest najpierw szukany w niewielkiej odległości od usuwanego odcinka
+ * drogi, a gdy go tam nie ma, odległość jest kilka razy zwiększana, zanim
+ * przeszukiwana jest cała mapa.
+ */
+typedef struct RepairStats{
+    /** Liczba wyszukiwań zakończonych w początkowej odległości. */
+    unsigned long long local;
+    /** Liczba wyszukiwań zakończonych po zwiększeniu odległości. */
+    unsigned long long widened;
+    /** Liczba wyszukiwań, które nie były już ograniczone. */
+    unsigned long long global;
+    /** Liczba miast odwiedzonych przez wszystkie wyszukiwania. */
+    unsigned long long settled;
+}RepairStats;
+
+/** @brief Udostępnia statystyki szukania objazdów.
+ * @param[in] map        – wskaźnik na strukturę przechowującą mapę dróg.
+ * @return Statystyki od utworzenia mapy(same zera, gdy @p map ma wartość NULL).
+ */
+RepairStats getRepairStats(Map *map);
+
+/**
+ * Najlepsza droga pomiędzy dwoma miastami, jaką miałaby droga krajowa
+ * utworzona przez funkcję @ref newRoute.
+ */
+typedef struct RouteDistance{
+    /** Długość najkrótszej drogi lub 0, gdy miasta nie są połączone
+        (albo są tym samym miastem). */
+    unsigned length;
+    /** Rok budowy lub ostatniego remontu najstarszego odcinka najlepszej
+        drogi lub 0, gdy miasta nie są połączone. */
+    int oldestRoad;
+    /** Czy najlepsza droga jest jednoznaczna, czyli czy funkcja
+        @ref newRoute mogłaby utworzyć z niej drogę krajową. */
+    bool unique;
+}RouteDistance;
+
+/** @brief Wyznacza najlepsze drogi pomiędzy każdą parą miast.
+ * Nie zmienia mapy ani dróg krajowych. Odległości są szukane od każdego
+ * miasta tylko do miast dalszych na liście, a wynik dla przeciwnej
+ * kolejności jest odczytywany z tego samego wyszukiwania(różni się co
+ * najwyżej polem @p unique, bo funkcja @ref newRoute szuka drogi od jej
+ * początku). Wyszukiwania od różnych miast wykonuje kilka
+ * wątków(zobacz @ref setMapThreads).
+ * @param[in,out] map    – wskaźnik na strukturę przechowującą mapę dróg;
+ * @param[in] cities     – tablica nazw miast;
+ * @param[in] n          – liczba miast.
+ * @return Wskaźnik na tablicę @p n * @p n wyników, w której droga z miasta
+ * @p cities[i] do miasta @p cities[j] ma indeks @p i * @p n + @p j, lub NULL,
+ * gdy któreś z miast nie istnieje, parametry są niepoprawne lub nie udało się
+ * zaalokować pamięci. Tablicę zwalnia się funkcją free.
+ */
+RouteDistance *distanceMatrix(Map *map, const char **cities, int n);
+
+/** @brief Udostępnia znacznik ostatniej zmiany drogi krajowej.
+ * Znacznik zmienia się przy każdej zmianie przebiegu drogi krajowej oraz przy
+ * remoncie któregokolwiek z jej odcinków, czyli zawsze, gdy zmienia się wynik
+ * funkcji @ref getRouteDescription. Znaczniki nie powtarzają się, także dla
+ * drogi krajowej utworzonej ponownie pod tym samym numerem.
+ * @param[in] map        – wskaźnik na strukturę przechowującą mapę dróg;
+ * @param[in] routeId    – numer drogi krajowej.
+ * @return Znacznik lub 0, jeśli droga krajowa nie istnieje.
+ */
+unsigned long long getMapRouteVersion(Map *map, unsigned routeId);
+
+/** @brief Udostępnia długość drogi krajowej.
+ * Długość jest przechowywana przy drodze krajowej i zmieniana razem z jej
+ * przebiegiem, więc nie trzeba tworzyć opisu drogi krajowej.
+ * @param[in] map        – wskaźnik na strukturę przechowującą mapę dróg;
+ * @param[in] routeId    – numer drogi krajowej.
+ * @return Suma długości odcinków drogi krajowej lub 0, jeśli droga krajowa
+ * nie istnieje.
+ */
+unsigned long long getRouteLength(Map *map, unsigned routeId);
+
+/** @brief Udostępnia rok najstarszego odcinka drogi krajowej.
+ * Rok jest przechowywany przy drodze krajowej i zmieniany razem z jej
+ * przebiegiem oraz przy remontach jej odcinków.
+ * @param[in] map        – wskaźnik na strukturę przechowującą mapę dróg;
+ * @param[in] routeId    – numer drogi krajowej.
+ * @return Najmniejszy rok budowy lub ostatniego remontu odcinka drogi
+ * krajowej lub 0, jeśli droga krajowa nie istnieje.
+ */
+int getRouteOldestYear(Map *map, unsigned routeId);
+
+/** @brief Udostępnia liczbę odcinków drogi krajowej.
+ * @param[in] map        – wskaźnik na strukturę przechowującą mapę dróg;
+ * @param[in] routeId    – numer drogi krajowej.
+ * @return Liczba odcinków drogi krajowej lub 0, jeśli droga krajowa
+ * nie istnieje.
+ */
+int getRouteHopCount(Map *map, unsigned routeId);
+
+/** @brief Udostępnia numery dróg krajowych przechodzących przez miasto.
+ * Każde miasto pamięta drogi krajowe, których odcinki się w nim kończą, więc
+ * czas działania zależy tylko od liczby tych dróg krajowych, a nie od liczby
+ * wszystkich dróg krajowych.
+ * @param[in] map        – wskaźnik na strukturę przechowującą mapę dróg;
+ * @param[in] city       – wskaźnik na napis reprezentujący nazwę miasta;
+ * @param[out] count     – liczba dróg krajowych.
+ * @return Wskaźnik na tablicę @p count numerów dróg krajowych w kolejności
+ * rosnącej lub NULL, gdy miasto nie istnieje, parametry są niepoprawne lub nie
+ * udało się zaalokować pamięci. Tablicę zwalnia się funkcją free.
+ */
+unsigned *getCityRoutes(Map *map, const char *city, int *count);
+
+/**
+ * Przejazd jedną drogą krajową w podróży(zobacz @ref planJourney).
+ */
+typedef struct JourneyLeg{
+    /** Numer drogi krajowej. */
+    unsigned routeId;
+    /** Nazwa miasta, w którym zaczyna się przejazd. */
+    const char *from;
+    /** Nazwa miasta, w którym kończy się przejazd. */
+    const char *to;
+    /** Suma długości odcinków drogi krajowej pomiędzy tymi miastami. */
+    unsigned long long length;
+}JourneyLeg;
+
+/** @brief Planuje podróż drogami krajowymi.
+ * Podróż prowadzi wzdłuż dróg krajowych, w dowolnym kierunku, i zmienia drogę
+ * krajową tylko w mieście należącym do obu dróg. Spośród podróży używających
+ * najmniejszej liczby dróg krajowych wybiera najkrótszą(a z równie krótkich
+ * dowolną). Przystanki dróg krajowych są kopiowane po każdej zmianie dróg
+ * krajowych, a kolejne podróże korzystają z tej kopii.
+ * @param[in,out] map    – wskaźnik na strukturę przechowującą mapę dróg;
+ * @param[in] city1      – wskaźnik na napis reprezentujący nazwę miasta;
+ * @param[in] city2      – wskaźnik na napis reprezentujący nazwę miasta;
+ * @param[out] count     – liczba przejazdów podróży, 0, gdy podróż nie jest
+ * możliwa.
+ * @return Wskaźnik na tablicę @p count przejazdów od miasta @p city1 do miasta
+ * @p city2 lub NULL, gdy któreś z miast nie istnieje, nazwy miast są identyczne,
+ * parametry są niepoprawne lub nie udało się zaalokować pamięci. Nazwy miast są
+ * ważne do usunięcia mapy. Tablicę zwalnia się funkcją free.
+ */
+JourneyLeg *planJourney(Map *map, const char *city1, const char *city2, int *count);
+
+/**
+ * Jedna z najkrótszych dróg pomiędzy miastami(zobacz @ref kShortestRoutes).
+ */
+typedef struct AlternativeRoute{
+    /** Suma długości odcinków drogi. */
+    unsigned long long length;
+    /** Najwcześniejszy rok budowy lub ostatniego remontu odcinków drogi. */
+    int oldestYear;
+    /** Liczba miast drogi, o jeden większa od liczby odcinków. */
+    int cityCount;
+    /** Nazwy kolejnych miast drogi. */
+    const char **cities;
+}AlternativeRoute;
+
+/** @brief Wyznacza kilka najkrótszych dróg pomiędzy miastami.
+ * Drogi nie przechodzą dwa razy przez to samo miasto i są uporządkowane tak
+ * jak przy wyborze drogi krajowej: rosnąco według długości, a przy równej
+ * długości od najpóźniejszego roku najstarszego odcinka(drogi równe pod oboma
+ * względami w dowolnej kolejności). Najkrótsze drogi od miasta @p city2 do
+ * wszystkich miast są zapamiętywane tak samo jak przy tworzeniu dróg
+ * krajowych.
+ * @param[in,out] map    – wskaźnik na strukturę przechowującą mapę dróg;
+ * @param[in] city1      – wskaźnik na napis reprezentujący nazwę miasta;
+ * @param[in] city2      – wskaźnik na napis reprezentujący nazwę miasta;
+ * @param[in] k          – największa liczba dróg, dodatnia;
+ * @param[out] count     – liczba wyznaczonych dróg, mniejsza od @p k, gdy
+ * więcej dróg nie istnieje, 0, gdy miasta nie są połączone.
+ * @return Wskaźnik na tablicę @p count dróg od miasta @p city1 do miasta
+ * @p city2 lub NULL, gdy któreś z miast nie istnieje, nazwy miast są identyczne,
+ * parametry są niepoprawne lub nie udało się zaalokować pamięci. Nazwy miast są
+ * ważne do usunięcia mapy. Tablicę(razem z tablicami nazw miast) zwalnia się
+ * funkcją free.
+ */
+AlternativeRoute *kShortestRoutes(Map *map, const char *city1, const char *city2, int k,
+                                  int *count);
+
+/** @brief Wyznacza miasta położone nie dalej niż podana odległość od miasta.
+ * Przekazuje funkcji @p visit kolejne miasta, od najbliższego(samego miasta
+ * @p city z odległością 0), gdy tylko znana jest ich odległość, nie tworząc
+ * listy wyników. Przeszukiwane są tylko te miasta i ich sąsiedzi, więc czas
+ * działania nie zależy od wielkości reszty mapy. Funkcja @p visit nie może
+ * zmieniać mapy.
+ * @param[in,out] map    – wskaźnik na strukturę przechowującą mapę dróg;
+ * @param[in] city       – wskaźnik na napis reprezentujący nazwę miasta;
+ * @param[in] distance   – największa odległość(długość najkrótszej drogi);
+ * @param[in] visit      – funkcja wywoływana z @p data, nazwą miasta(ważną do
+ * usunięcia mapy) i jego odległością;
+ * @param[in] data       – dane przekazywane funkcji @p visit.
+ * @return Wartość @p true, jeśli wszystkie miasta zostały przekazane.
+ * Wartość @p false, jeśli miasto nie istnieje, parametry są niepoprawne lub nie
+ * udało się zaalokować pamięci(część miast mogła już zostać przekazana).
+ */
+bool citiesWithin(Map *map, const char *city, unsigned distance,
+                  void (*visit)(void *data, const char *city, unsigned distance), void *data);
+
+/** @brief Wypisuje opisy wszystkich dróg krajowych.
+ * Przekazuje funkcji @p write kolejne fragmenty tekstu, w którym opisy dróg
+ * krajowych(w formacie funkcji @ref getRouteDescription) występują w kolejności
+ * rosnących numerów, każdy zakończony znakiem końca linii. Tekst jest zbierany
+ * w buforze stałej wielkości, więc funkcja nie alokuje pamięci. Fragment tekstu
+ * nie musi kończyć się na końcu linii, a po nim(poza jego długością) jest
+ * znak '\0'. Funkcja @p write nie może zmieniać mapy.
+ * @param[in] map        – wskaźnik na strukturę przechowującą mapę dróg;
+ * @param[in] write      – funkcja wywoływana z @p data, fragmentem tekstu
+ * i jego długością;
+ * @param[in] data       – dane przekazywane funkcji @p write.
+ * @return Wartość @p false, jeśli parametry są niepoprawne, i @p true
+ * w przeciwnym przypadku.
+ */
+bool exportRoutes(Map *map, void (*write)(void *data, const char *text, size_t size),
+                  void *data);
+
+/** @brief Wypisuje wszystkie odcinki dróg.
+ * Działa tak jak funkcja @ref exportRoutes, ale każda linia opisuje jeden
+ * odcinek drogi w formacie: nazwa miasta;nazwa miasta;długość odcinka drogi;
+ * rok budowy lub ostatniego remontu. Odcinki występują w kolejności miast,
+ * w której są tworzone.
+ * @param[in] map        – wskaźnik na strukturę przechowującą mapę dróg;
+ * @param[in] write      – funkcja wywoływana z @p data, fragmentem tekstu
+ * i jego długością;
+ * @param[in] data       – dane przekazywane funkcji @p write.
+ * @return Wartość @p false, jeśli parametry są niepoprawne, i @p true
+ * w przeciwnym przypadku.
+ */
+bool exportRoads(Map *map, void (*write)(void *data, const char *text, size_t size),
+                 void *data);
+
+/**
+ * Rodzaj zmiany mapy(zobacz @ref readChanges).
+ */
+typedef enum MapChangeKind{
+    /** Dodano odcinek drogi. */
+    CHANGE_ROAD_ADDED,
+    /** Usunięto odcinek drogi. */
+    CHANGE_ROAD_REMOVED,
+    /** Zmieniono rok budowy lub ostatniego remontu odcinka drogi. */
+    CHANGE_ROAD_REPAIRED,
+    /** Utworzono drogę krajową. */
+    CHANGE_ROUTE_CREATED,
+    /** Przedłużono drogę krajową. */
+    CHANGE_ROUTE_EXTENDED,
+    /** Uzupełniono drogę krajową po usunięciu odcinków dróg lub zmieniono
+        rok budowy albo ostatniego remontu jej odcinka(wtedy @p removed
+        i @p added są równe 1, a @p first jest numerem tego odcinka). */
+    CHANGE_ROUTE_REPAIRED,
+    /** Usunięto drogę krajową. */
+    CHANGE_ROUTE_REMOVED
+}MapChangeKind;
+
+/**
+ * Zmiana mapy zapisana w dzienniku zmian(zobacz @ref setChangeLog).
+ */
+typedef struct MapChange{
+    /** Numer zmiany, kolejne zmiany mają kolejne numery, od 1. */
+    unsigned long long sequence;
+    /** Rodzaj zmiany. */
+    MapChangeKind kind;
+    /** Nazwy miast zmienionego odcinka drogi(ważne do usunięcia mapy) lub
+        NULL dla zmian dróg krajowych. */
+    const char *city1, *city2;
+    /** Długość odcinka drogi. */
+    unsigned length;
+    /** Rok budowy lub ostatniego remontu odcinka drogi po zmianie. */
+    int year;
+    /** Numer zmienionej drogi krajowej lub 0 dla zmian odcinków dróg. */
+    unsigned routeId;
+    /** Numer pierwszego zmienionego odcinka drogi krajowej, licząc od jej
+        początku od 0. */
+    int first;
+    /** Liczba odcinków drogi krajowej usuniętych od odcinka @p first. */
+    int removed;
+    /** Liczba odcinków wstawionych w ich miejsce. */
+    int added;
+}MapChange;
+
+/** @brief Włącza lub wyłącza dziennik zmian mapy.
+ * Dziennik pamięta ostatnie @p capacity zmian odcinków dróg i dróg krajowych,
+ * w kolejności ich wykonania. Zmiana drogi krajowej jest opisana fragmentem,
+ * który został zastąpiony. Zmiany wycofane w transakcji(zobacz
+ * @ref rollbackTransaction) są zapisywane jako zmiany odwrotne. Naprawa odcinka
+ * drogi zmienia też opisy dróg krajowych, które przez niego przechodzą, więc
+ * po niej zapisywana jest zmiana @ref CHANGE_ROUTE_REPAIRED każdej z nich.
+ * Wywołanie usuwa zapamiętane zmiany, a numery kolejnych zmian są dalej
+ * zwiększane.
+ * @param[in,out] map    – wskaźnik na strukturę przechowującą mapę dróg;
+ * @param[in] capacity   – liczba pamiętanych zmian, 0 wyłącza dziennik.
+ * @return Wartość @p true, jeśli dziennik został zmieniony.
+ * Wartość @p false, jeśli parametr ma niepoprawną wartość lub nie udało się
+ * zaalokować pamięci. Wtedy dziennik się nie zmienia.
+ */
+bool setChangeLog(Map *map, unsigned capacity);
+
+/** @brief Podaje numer ostatniej zapisanej zmiany.
+ * Odbiorca, który odczytał całą mapę, może od tego numeru czytać kolejne
+ * zmiany funkcją @ref readChanges.
+ * @param[in] map        – wskaźnik na strukturę przechowującą mapę dróg.
+ * @return Numer ostatniej zmiany lub 0, gdy nie zapisano żadnej zmiany.
+ */
+unsigned long long lastChange(Map *map);
+
+/** @brief Odczytuje zmiany mapy następujące po kursorze.
+ * Kopiuje do tablicy @p changes najwyżej @p max kolejnych zmian o numerach
+ * większych od @p cursor i przesuwa kursor na ostatnią skopiowaną zmianę.
+ * Czas działania jest proporcjonalny do liczby skopiowanych zmian.
+ * @param[in] map        – wskaźnik na strukturę przechowującą mapę dróg;
+ * @param[in,out] cursor – numer ostatniej odczytanej zmiany;
+ * @param[out] changes   – tablica na co najmniej @p max zmian;
+ * @param[in] max        – największa liczba kopiowanych zmian.
+ * @return Liczba skopiowanych zmian, 0, gdy kursor wskazuje na ostatnią zmianę,
+ * lub -1, gdy parametry są niepoprawne, dziennik jest wyłączony albo zmiany
+ * następujące po kursorze zostały już zastąpione nowszymi. Wtedy odbiorca
+ * musi odczytać cała mapę ponownie(zobacz @ref lastChange).
+ */
+int readChanges(Map *map, unsigned long long *cursor, MapChange *changes, int max);
+
+/** @brief Zapisuje mapę w postaci binarnej.
+ * Dopisuje do bufora @p out zawartość mapy: miasta w kolejności ich
+ * identyfikatorów, odcinki dróg w kolejności, w jakiej są przechowywane przy
+ * każdym z miast, oraz drogi krajowe. Mapa odczytana z tych danych funkcją
+ * @ref decodeMap jest w takim samym stanie jak mapa zapisana.
+ * @param[in] map       - wskaźnik na strukturę przechowującą mapę dróg;
+ * @param[in,out] out   - bufor, do którego dopisywane są dane.
+ * @return Wartość @p true, jeśli mapa została zapisana.
+ * Wartość @p false, jeśli nie udało się zaalokować pamięci.
+ */
+bool encodeMap(Map *map, ByteBuffer *out);
+
+/** @brief Odtwarza mapę zapisaną funkcją @ref encodeMap.
+ * @param[in,out] in    - dane mapy; po wywołaniu wskazuje na pierwszy bajt
+ * za zapisaną mapą.
+ * @return Wskaźnik na utworzoną strukturę lub NULL, gdy dane są niepoprawne
+ * lub nie udało się zaalokować pamięci.
+ */
+Map *decodeMap(ByteReader *in);
+
 #endif /* __MAP_H__ */
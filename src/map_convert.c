@@ -0,0 +1,91 @@
+/** @file map_convert.c
+ *  Converts the commands from the text format(standard input)
+ *  to the binary format(standard output), see @ref BinaryProtocol.h.
+ *  Every line becomes a single frame, so the numbers of the lines
+ *  reported by the errors stay the same.
+ *
+ * @author Cezary Chodun
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "BinaryProtocol.h"
+#include "ByteBuffer.h"
+#include "Text.h"
+
+/// @private Size of the output written at once.
+static const size_t FLUSH_SIZE = 1 << 16;
+
+/// @private
+static bool flushOutput(ByteBuffer *out) {
+    if (!writeByteBuffer(out, STDOUT_FILENO))
+        return false;
+
+    clearByteBuffer(out);
+    return true;
+}
+
+/// @private Appends the frame for a single line.
+static bool convertLine(BinaryWriter *writer, char *line, ssize_t size, ByteBuffer *out) {
+    if (size == 1 && line[0] == '\n')
+        return encodeBinaryEmpty(out, BIN_NOP);//Empty line
+    if (line[0] == '#')
+        return encodeBinaryEmpty(out, BIN_NOP);//Comment
+    if (line[size - 1] != '\n')
+        return encodeBinaryEmpty(out, BIN_INVALID);//Wrong format
+
+    line[size - 1] = '\0';
+    Text *s = newText(line);
+    if (s == NULL)
+        return false;
+
+    vector *args = splitText(s, ';');
+    destroyText(s);
+    if (args == NULL)
+        return false;
+
+    bool ok = encodeBinaryCommand(writer, args, out);
+
+    for (int i = 0; i < vecSize(args); i++)
+        destroyText(getVec(args, i));
+    destroyVec(args);
+
+    return ok;
+}
+
+/**
+ * @brief
+ *  Reads the text commands and writes them in the binary format.
+ * @return
+ *  0 if the conversion was successful and 1 otherwise.
+ */
+int main(void) {
+    BinaryWriter *writer = newBinaryWriter();
+    ByteBuffer *out = newByteBuffer(FLUSH_SIZE * 2);
+    bool ok = (writer != NULL && out != NULL && encodeBinaryHeader(out));
+
+    char *line = NULL;
+    size_t capacity = 0;
+    ssize_t size;
+    while (ok && (size = getline(&line, &capacity, stdin)) > 0) {
+        ok = convertLine(writer, line, size, out);
+        if (ok && byteBufferSize(out) >= FLUSH_SIZE)
+            ok = flushOutput(out);
+    }
+
+    ok = ok && flushOutput(out);
+
+    free(line);
+    destroyByteBuffer(out);
+    destroyBinaryWriter(writer);
+
+    if (!ok) {
+        fprintf(stderr, "Conversion failed\n");
+        return 1;
+    }
+    return 0;
+}
@@ -10,9 +10,13 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <limits.h>
 #include <assert.h>
 
+#include "BinaryProtocol.h"
+#include "Checkpoint.h"
+#include "Journal.h"
 #include "MapParser.h"
 #include "Text.h"
 #include "map.h"
@@ -55,16 +59,42 @@ static bool readLine(Text *s, int buffSize) {
     return true;
 }
 
-/**
- * @brief
- *  After invoking the function the program will start waiting for input.
- */
-int main() {
-    int bufSize = 64;
+/// @private
+static void printUsage(const char *program) {
+    fprintf(stderr, "Usage: %s [-j journal_prefix] [-g group_size] "
+                    "[-c compaction_records] [-t threads]\n", program);
+}
 
-    Map *map = newMap();
-    if (map == NULL)
-        return 0;
+/// @private
+static bool readOption(const char *s, unsigned long long *val) {
+    if (s == NULL || s[0] < '0' || s[0] > '9')
+        return false;
+
+    char *end;
+    val[0] = strtoull(s, &end, 10);
+    return end[0] == '\0';
+}
+
+/// @private
+static bool checkpointFoo(Checkpointer *checkpointer, Map *map, Journal *journal,
+                          vector *args, int lineNum) {
+    if (vecSize(args) != 2 || textSize(getVec(args, 1)) == 0)
+        return false;   //Wrong amount of parameters
+
+    char *path = to_cString(getVec(args, 1));
+    if (path == NULL)
+        return false;
+
+    uint64_t lsn = (journal == NULL ? 0 : journalLsn(journal));
+    bool ok = startCheckpoint(checkpointer, map, path, lsn, lineNum);
+
+    free(path);
+    return ok;
+}
+
+/// @private Executes the commands in the text format.
+static void processText(Map *map, Journal *journal, Checkpointer *checkpointer) {
+    int bufSize = 64;
 
     int lineNum = 0;
     Text *s = newText("");
@@ -93,6 +123,7 @@ int main() {
             }
 
             Text *cmd = getVec(args, 0);
+            bool rolledBack = false;
 
             unsigned tmp;
             if (equalsC(cmd, "addRoad"))
@@ -111,9 +142,50 @@ int main() {
                 err |= !removeRouteFoo(map, args);
             else if (toUIntVal(cmd, &tmp))   //Exact route
                 err |= !exactRouteFoo(map, args);
+            else if (equalsC(cmd, "getRepairStats"))
+                err |= !getRepairStatsFoo(map, args);
+            else if (equalsC(cmd, "distanceMatrix"))
+                err |= !distanceMatrixFoo(map, args);
+            else if (equalsC(cmd, "getRouteLength"))
+                err |= !getRouteLengthFoo(map, args);
+            else if (equalsC(cmd, "getRouteOldestYear"))
+                err |= !getRouteOldestYearFoo(map, args);
+            else if (equalsC(cmd, "getRouteHopCount"))
+                err |= !getRouteHopCountFoo(map, args);
+            else if (equalsC(cmd, "getCityRoutes"))
+                err |= !getCityRoutesFoo(map, args);
+            else if (equalsC(cmd, "planJourney"))
+                err |= !planJourneyFoo(map, args);
+            else if (equalsC(cmd, "kShortestRoutes"))
+                err |= !kShortestRoutesFoo(map, args);
+            else if (equalsC(cmd, "citiesWithin"))
+                err |= !citiesWithinFoo(map, args);
+            else if (equalsC(cmd, "exportRoutes"))
+                err |= !exportRoutesFoo(map, args);
+            else if (equalsC(cmd, "exportRoads"))
+                err |= !exportRoadsFoo(map, args);
+            else if (equalsC(cmd, "beginTransaction"))
+                err |= !beginTransactionFoo(map, args);
+            else if (equalsC(cmd, "commitTransaction")) {
+                bool open = inTransaction(map);
+                err |= !commitTransactionFoo(map, args);
+                //The failed commit rolls the changes back, which is journaled as well
+                rolledBack = err && open && !inTransaction(map);
+            }
+            else if (equalsC(cmd, "rollbackTransaction"))
+                err |= !rollbackTransactionFoo(map, args);
+            else if (equalsC(cmd, "setChangeLog"))
+                err |= !setChangeLogFoo(map, args);
+            else if (equalsC(cmd, "getChanges"))
+                err |= !getChangesFoo(map, args);
+            else if (equalsC(cmd, "checkpoint"))
+                err |= !checkpointFoo(checkpointer, map, journal, args, lineNum);
             else
                 err = true; //Wrong command
 
+            if ((!err || rolledBack) && journal != NULL)
+                err |= !journalCommand(journal, args);
+
             for (int i = 0; i < vecSize(args); i++)
                 destroyText(getVec(args, i));
             destroyVec(args);
@@ -121,6 +193,7 @@ int main() {
 
         if (err)
             fprintf(stderr, "%s %d\n", "ERROR", lineNum);
+        pollCheckpoints(checkpointer);
         if (backText(s) == EOF)
             break;
         clearText(s);
@@ -128,6 +201,147 @@ int main() {
 
     if (s != NULL)
         destroyText(s);
+}
+
+/// @private Executes the commands in the binary format(see @ref BinaryProtocol.h).
+static void processBinary(Map *map, Journal *journal, Checkpointer *checkpointer) {
+    BinaryReader *reader = newBinaryReader(stdin);
+    if (reader == NULL) {
+        fprintf(stderr, "%s %d\n", "ERROR", 1);
+        return;
+    }
+
+    int lineNum = 0;
+    BinaryCommand cmd;
+    while (true) {
+        bool err = false;
+        lineNum++;
+
+        int ret = readBinaryCommand(reader, &cmd);
+        if (ret == 0)
+            break;
+        if (ret == -2) {    //The rest of the input can not be read
+            fprintf(stderr, "%s %d\n", "ERROR", lineNum);
+            break;
+        }
+
+        if (ret == -1 || cmd.op == BIN_INVALID)
+            err = true;
+        else if (cmd.op == BIN_NOP);
+        else if (cmd.op == BIN_CHECKPOINT) {
+            uint64_t lsn = (journal == NULL ? 0 : journalLsn(journal));
+            err = (cmd.path[0] == '\0'
+                   || !startCheckpoint(checkpointer, map, cmd.path, lsn, lineNum));
+        }
+        else
+            err = !executeBinaryCommand(map, &cmd);
+
+        if (!err && journal != NULL && cmd.op != BIN_NOP
+            && cmd.op != BIN_CHECKPOINT && cmd.op != BIN_GET_ROUTE_DESCRIPTION) {
+            vector *args = binaryCommandArgs(&cmd);
+            err = (args == NULL || !journalCommand(journal, args));
+
+            for (int i = 0; i < vecSize(args); i++)
+                destroyText(getVec(args, i));
+            destroyVec(args);
+        }
+
+        clearBinaryCommand(&cmd);
+
+        if (err)
+            fprintf(stderr, "%s %d\n", "ERROR", lineNum);
+        pollCheckpoints(checkpointer);
+    }
+
+    destroyBinaryReader(reader);
+}
+
+/**
+ * @brief
+ *  After invoking the function the program will start waiting for input.
+ *  Options:
+ *  -j prefix - stores the successful modifications in the journal
+ *              'prefix.journal' and recovers the map from it
+ *              at the start;
+ *  -g n      - number of the journal records flushed to the disk at once;
+ *  -c n      - number of the journal records after which the journal
+ *              is folded into the snapshot 'prefix.snap'(0 - never);
+ *  -t n      - number of the threads searching for the detours
+ *              when a road is removed(0 - one per processor).
+ *  Besides the map commands, 'checkpoint;path' writes the snapshot
+ *  of the map to 'path' in the background, and 'beginTransaction',
+ *  'commitTransaction' and 'rollbackTransaction' group the changes
+ *  of the roads(see @ref beginTransaction), 'setChangeLog;n' keeps the
+ *  last n changes and 'getChanges;number' prints the changes after
+ *  the given one.
+ *  The input is read in the binary format(see @ref BinaryProtocol.h)
+ *  if it starts with its header.
+ */
+int main(int argc, char **argv) {
+    const char *journalPrefix = NULL;
+    unsigned long long groupSize = 0, compaction = 0, threads = 0;
+    bool setGroup = false, setCompaction = false, setThreads = false;
+
+    for (int i = 1; i < argc; i++) {
+        bool ok = (i + 1 < argc);
+        if (ok && strcmp(argv[i], "-j") == 0)
+            journalPrefix = argv[++i];
+        else if (ok && strcmp(argv[i], "-g") == 0)
+            ok = setGroup = readOption(argv[++i], &groupSize);
+        else if (ok && strcmp(argv[i], "-c") == 0)
+            ok = setCompaction = readOption(argv[++i], &compaction);
+        else if (ok && strcmp(argv[i], "-t") == 0)
+            ok = setThreads = readOption(argv[++i], &threads);
+        else
+            ok = false;
+
+        if (!ok) {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    Map *map = NULL;
+    Journal *journal = NULL;
+    if (journalPrefix != NULL) {
+        journal = openJournal(journalPrefix, &map);
+        if (journal == NULL) {
+            fprintf(stderr, "Failed to recover the map from the journal\n");
+            return 1;
+        }
+
+        if (setGroup)
+            setJournalGroupSize(journal, groupSize > UINT_MAX ? UINT_MAX : (unsigned) groupSize);
+        if (setCompaction)
+            setJournalCompaction(journal, compaction);
+    }
+    else
+        map = newMap();
+
+    if (map == NULL)
+        return 0;
+    if (setThreads)
+        setMapThreads(map, threads > INT_MAX ? INT_MAX : (int) threads);
+
+    Checkpointer *checkpointer = newCheckpointer();
+    if (checkpointer == NULL) {
+        closeJournal(journal);
+        deleteMap(map);
+        return 0;
+    }
+
+    int first = getc(stdin);
+    if (first != EOF)
+        ungetc(first, stdin);
+
+    if (first == BINARY_MAGIC_BYTE)
+        processBinary(map, journal, checkpointer);
+    else
+        processText(map, journal, checkpointer);
+
+    destroyCheckpointer(checkpointer);
+    if (journal != NULL)
+        closeJournal(journal);
     deleteMap(map);
 
     return 0;
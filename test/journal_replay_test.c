@@ -0,0 +1,142 @@
+/** @file journal_replay_test.c
+ *  Checks that the map recovered from the journal(see @ref Journal.h)
+ *  is the same as the map which wrote it, after failed commands.
+ *  Failed commands are not journaled, so they must not leave any trace
+ *  in the map, not even a new city or the order of the roads of a city.
+ *
+ *  Usage: journal_replay_test [journal prefix]
+ *
+ * @author Cezary Chodun
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ByteBuffer.h"
+#include "Journal.h"
+#include "MapParser.h"
+#include "Text.h"
+#include "map.h"
+
+/// @private Removes the files of the journal.
+static void removeJournal(const char *prefix) {
+    const char *suffixes[] = {".snap", ".journal", ".journal.old"};
+    char path[4096];
+
+    for (int i = 0; i < 3; i++) {
+        snprintf(path, sizeof(path), "%s%s", prefix, suffixes[i]);
+        remove(path);
+    }
+}
+
+/// @private Executes the command and journals it if it succeeds, as map_main does.
+static bool execute(Map *map, Journal *journal, const char *line) {
+    char *copy = strdup(line);
+    Text *s = (copy == NULL ? NULL : newText(copy));
+    free(copy);
+    vector *args = (s == NULL ? NULL : splitText(s, ';'));
+    destroyText(s);
+    if (args == NULL)
+        return false;
+
+    Text *cmd = getVec(args, 0);
+    unsigned number;
+    bool ok = false;
+    if (equalsC(cmd, "addRoad"))
+        ok = addRoadFoo(map, args);
+    else if (equalsC(cmd, "newRoute"))
+        ok = newRouteFoo(map, args);
+    else if (equalsC(cmd, "removeRoad"))
+        ok = removeRoadFoo(map, args);
+    else if (toUIntVal(cmd, &number))
+        ok = exactRouteFoo(map, args);
+
+    if (ok)
+        ok = journalCommand(journal, args);
+
+    for (int i = 0; i < vecSize(args); i++)
+        destroyText(getVec(args, i));
+    destroyVec(args);
+
+    return ok;
+}
+
+/// @private Encodes the map(NULL if the memory could not be allocated).
+static ByteBuffer *encode(Map *map) {
+    ByteBuffer *out = newByteBuffer(256);
+    if (out != NULL && !encodeMap(map, out)) {
+        destroyByteBuffer(out);
+        return NULL;
+    }
+
+    return out;
+}
+
+int main(int argc, char **argv) {
+    const char *prefix = (argc > 1 ? argv[1] : "journal_replay_test");
+    removeJournal(prefix);
+
+    Map *map = NULL;
+    Journal *journal = openJournal(prefix, &map);
+    if (journal == NULL || map == NULL) {
+        fprintf(stderr, "Failed to open the journal\n");
+        return 1;
+    }
+
+    //Route 1 goes C-B-A. A has three roads, so removing its first one moves the last
+    const char *commands[] = {
+        "addRoad;A;B;1;2000",
+        "addRoad;A;C;10;2000",
+        "addRoad;A;D;1;2000",
+        "addRoad;B;C;1;2000",
+        "newRoute;1;C;A"
+    };
+    bool ok = true;
+    for (int i = 0; i < (int) (sizeof(commands) / sizeof(commands[0])); i++)
+        ok &= execute(map, journal, commands[i]);
+
+    //The only detour of A-B goes through C, which is on the route,
+    //and the other commands fail after their cities could be created
+    const char *failing[] = {
+        "removeRoad;A;B",
+        "addRoad;X;X;1;1",
+        "2;R;1;1;S;1;1;R",
+        "3;P;1;1;A;1;1990;B"
+    };
+    for (int i = 0; i < (int) (sizeof(failing) / sizeof(failing[0])); i++)
+        ok &= !execute(map, journal, failing[i]);
+
+    if (!ok) {
+        fprintf(stderr, "Unexpected result of the commands\n");
+        return 1;
+    }
+
+    ByteBuffer *written = encode(map);
+    bool closed = closeJournal(journal);
+    deleteMap(map);
+
+    map = NULL;
+    journal = openJournal(prefix, &map);
+    ByteBuffer *replayed = (journal == NULL || map == NULL ? NULL : encode(map));
+    if (!closed || written == NULL || replayed == NULL) {
+        fprintf(stderr, "Failed to replay the journal\n");
+        return 1;
+    }
+
+    bool same = (byteBufferSize(written) == byteBufferSize(replayed)
+                 && memcmp(byteBufferData(written), byteBufferData(replayed),
+                           byteBufferSize(written)) == 0);
+    if (!same)
+        fprintf(stderr, "The replayed map differs from the written one\n");
+
+    destroyByteBuffer(written);
+    destroyByteBuffer(replayed);
+    closeJournal(journal);
+    deleteMap(map);
+    removeJournal(prefix);
+
+    return same ? 0 : 1;
+}